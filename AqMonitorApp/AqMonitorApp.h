@@ -27,6 +27,13 @@
 #include "Lcd.h"
 #include "TemperatureProbe.h"
 #include "RealTimeClock.h"
+#include "Telemetry.h"
+#include "Console.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "History.h"
+#include "Logger.h"
+#include "Dump.h"
 
 
 #endif /* AQ_MONITOR_H_ */
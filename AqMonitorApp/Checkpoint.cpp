@@ -0,0 +1,100 @@
+/*
+ * Checkpoint.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include "Checkpoint.h"
+#include "Crc16.h"
+
+/** Instance */
+Checkpoint CHECKPOINT = Checkpoint();
+
+/**
+ * Constructor
+ */
+Checkpoint::Checkpoint()
+{
+} // end constructor
+
+/**
+ * Writes the probe filters to the clock's RAM, stamped with the clock
+ * time from the last RTC.readClock()
+ */
+void Checkpoint::save()
+{
+	uint8_t buffer[CHECKPOINT_SIZE];
+	unsigned long epoch = RTC.getEpoch();
+	uint16_t crc;
+
+	buffer[0] = CHECKPOINT_MAGIC;
+	buffer[1] = CHECKPOINT_VERSION;
+	buffer[2] = epoch;
+	buffer[3] = epoch >> 8;
+	buffer[4] = epoch >> 16;
+	buffer[5] = epoch >> 24;
+	TEMP.saveState( &buffer[6] );
+	PH.saveState( &buffer[6 + TEMP_STATE_SIZE] );
+
+	crc = crc16( buffer, CHECKPOINT_SIZE - 2 );
+	buffer[CHECKPOINT_SIZE - 2] = crc;
+	buffer[CHECKPOINT_SIZE - 1] = crc >> 8;
+
+	RTC.writeData( DS1307_NVRAM_START, buffer, CHECKPOINT_SIZE );
+
+} // end save
+
+/**
+ * Reloads the probe filters if the clock's RAM holds a valid checkpoint
+ * taken within CHECKPOINT_MAX_AGE.  The clock must have been read first.
+ * Returns true if at least one filter was restored.
+ */
+boolean Checkpoint::restore()
+{
+	uint8_t buffer[CHECKPOINT_SIZE];
+	unsigned long epoch;
+	unsigned long now = RTC.getEpoch();
+	uint16_t crc;
+	boolean temp, ph;
+
+	RTC.readData( DS1307_NVRAM_START, buffer, CHECKPOINT_SIZE );
+
+	crc = buffer[CHECKPOINT_SIZE - 2] | (buffer[CHECKPOINT_SIZE - 1] << 8);
+	if( buffer[0] != CHECKPOINT_MAGIC || buffer[1] != CHECKPOINT_VERSION ||
+			crc != crc16( buffer, CHECKPOINT_SIZE - 2 ) )
+	{
+		Serial.println(F("Checkpoint: none found"));
+		return false;
+	}
+
+	epoch = buffer[2] | ((unsigned long)buffer[3] << 8) |
+			((unsigned long)buffer[4] << 16) | ((unsigned long)buffer[5] << 24);
+	if( epoch > now || now - epoch > CHECKPOINT_MAX_AGE )
+	{
+		PRINTF( Serial, "Checkpoint: stale (saved at %lu, now %lu)\r\n", epoch, now );
+		return false;
+	}
+
+	// Each filter checks its own state; one that fails starts empty
+	temp = TEMP.restoreState( &buffer[6] );
+	ph = PH.restoreState( &buffer[6 + TEMP_STATE_SIZE] );
+	if( !temp && !ph )
+	{
+		Serial.println(F("Checkpoint: no filter state usable"));
+		return false;
+	}
+
+	Serial.printf( F("Checkpoint: restored %S%S%S, %lu seconds old\r\n"),
+			temp ? PSTR("temperature") : PSTR(""), temp && ph ? PSTR(" and ") : PSTR(""),
+			ph ? PSTR("pH") : PSTR(""), now - epoch );
+	return true;
+
+} // end restore
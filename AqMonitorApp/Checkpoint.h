@@ -0,0 +1,49 @@
+/*
+ * Checkpoint.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <WProgram.h>
+#include "TemperatureProbe.h"
+#include "PhStamp.h"
+#include "RealTimeClock.h"
+
+/**
+ * Filter state kept in the DS1307's battery backed RAM so the averages
+ * survive a reset:
+ *
+ *   magic  version  epoch(4)  temp state  pH state  crc(2)
+ */
+#define CHECKPOINT_MAGIC		0xA7
+#define CHECKPOINT_VERSION		2
+#define CHECKPOINT_MAX_AGE		300		// seconds; older state is stale
+#define CHECKPOINT_SIZE			(6 + TEMP_STATE_SIZE + PH_STATE_SIZE + 2)
+
+#if CHECKPOINT_SIZE > DS1307_NVRAM_SIZE
+#error "checkpoint does not fit in the DS1307 RAM"
+#endif
+
+class Checkpoint
+{
+public:
+	Checkpoint();
+	void save();
+	boolean restore();
+
+};
+
+extern Checkpoint CHECKPOINT;
+
+#endif /* CHECKPOINT_H_ */
@@ -0,0 +1,426 @@
+/*
+ * Commands.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include "AqMonitorApp.h"
+
+/**
+ * Replies with an error and returns false if value is outside low..high
+ */
+static boolean inRange(unsigned long value, unsigned long low, unsigned long high)
+{
+	if( value < low || value > high )
+	{
+		PRINTF( Serial, "** Error: %lu is outside %lu..%lu\r\n", value, low, high );
+		return false;
+	}
+	return true;
+}
+
+void cmdShowClock(const ConsoleArg *args)
+{
+	RTC.readClock();
+	PRINTF( Serial, "20%02d-%02d-%02d %02d:%02d:%02d epoch %lu\r\n",
+			RTC.getYear(), RTC.getMonth(), RTC.getDate(),
+			RTC.getHours24(), RTC.getMinutes(), RTC.getSeconds(), RTC.getEpoch() );
+}
+
+void cmdSetTimestamp(const ConsoleArg *args)
+{
+	if( RTC.setTimestamp( args[0].text ) )
+	{
+		cmdShowClock( args );
+	}
+	else
+	{
+		CONSOLE.error(F("expected YYYY-MM-DD HH:MM:SS"));
+	}
+}
+
+void cmdSetEpoch(const ConsoleArg *args)
+{
+	// the clock only counts years 2000-2099
+	if( inRange( args[0].number, 0, 3155759999UL ) )
+	{
+		RTC.setEpoch( args[0].number );
+		cmdShowClock( args );
+	}
+}
+
+void cmdSetHours(const ConsoleArg *args)
+{
+	boolean ok;
+
+	if( RTC.is12hour() )
+	{
+		ok = inRange( args[0].number, 1, 12 );
+	}
+	else
+	{
+		ok = inRange( args[0].number, 0, 23 );
+	}
+	if( ok )
+	{
+		RTC.setHours(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting hours to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetMinutes(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 0, 59 ) )
+	{
+		RTC.setMinutes(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting minutes to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetSeconds(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 0, 59 ) )
+	{
+		RTC.setSeconds(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting seconds to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetYear(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 0, 99 ) )
+	{
+		RTC.setYear(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting year to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetMonth(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 1, 12 ) )
+	{
+		RTC.setMonth(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting month to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetDate(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 1, 31 ) )
+	{
+		RTC.setDate(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting date to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdSetDayOfWeek(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 1, 7 ) )
+	{
+		RTC.setDayOfWeek(args[0].number);
+		RTC.setClock();
+		PRINTF( Serial, "Setting day of week to: %u\r\n", (unsigned int)args[0].number );
+	}
+}
+
+void cmdShowDayOfWeek(const ConsoleArg *args)
+{
+	PRINTF( Serial, "Day of week is: %d\r\n", RTC.getDayOfWeek() );
+}
+
+void cmdToggle24h(const ConsoleArg *args)
+{
+	if(RTC.is12hour())
+	{
+		RTC.switchTo24h();
+		Serial.println(F("Switching to 24-hour clock."));
+	}
+	else
+	{
+		RTC.switchTo12h();
+		Serial.println(F("Switching to 12-hour clock."));
+	}
+	RTC.setClock();
+}
+
+void cmdSetAM(const ConsoleArg *args)
+{
+	if(RTC.is12hour())
+	{
+		RTC.setAM();
+		RTC.setClock();
+		Serial.println(F("Set AM."));
+	}
+	else
+	{
+		Serial.println(F("(Set hours only in 24-hour mode.)"));
+	}
+}
+
+void cmdSetPM(const ConsoleArg *args)
+{
+	if(RTC.is12hour())
+	{
+		RTC.setPM();
+		RTC.setClock();
+		Serial.println(F("Set PM."));
+	}
+	else
+	{
+		Serial.println(F("(Set hours only in 24-hour mode.)"));
+	}
+}
+
+void cmdStartClock(const ConsoleArg *args)
+{
+	RTC.start();
+	Serial.println(F("Clock oscillator started."));
+}
+
+void cmdStopClock(const ConsoleArg *args)
+{
+	RTC.stop();
+	Serial.println(F("Clock oscillator stopped."));
+}
+
+void cmdSqwEnable(const ConsoleArg *args)
+{
+	RTC.sqwEnable(RTC.SQW_1Hz);
+	Serial.println(F("Square wave output set to 1Hz"));
+}
+
+void cmdSqwDisable(const ConsoleArg *args)
+{
+	RTC.sqwDisable(0);
+	Serial.println(F("Square wave output disabled (low)"));
+}
+
+void cmdWriteRegister(const ConsoleArg *args)
+{
+	// DS1307 has 8 clock registers and 56 bytes of RAM
+	if( inRange( args[0].number, 0, 63 ) && inRange( args[1].number, 0, 255 ) )
+	{
+		RTC.writeData(args[0].number, args[1].number);
+		PRINTF( Serial, "Write to register %u the value %u\r\n",
+				(unsigned int)args[0].number, (unsigned int)args[1].number );
+	}
+}
+
+void cmdReadRegister(const ConsoleArg *args)
+{
+	if( inRange( args[0].number, 0, 63 ) )
+	{
+		PRINTF( Serial, "Read from register %u the value %u\r\n",
+				(unsigned int)args[0].number, RTC.readData(args[0].number) );
+	}
+}
+
+void cmdShowConfig(const ConsoleArg *args)
+{
+	CONFIG.print( Serial );
+}
+
+void cmdSetConfig(const ConsoleArg *args)
+{
+	char *name = (char *)args[0].text;
+	char *value = name;
+	char *end;
+	long n;
+	int8_t field;
+
+	// split "name value"
+	while( *value && *value != ' ' && *value != ',' )
+	{
+		value++;
+	}
+	while( *value == ' ' || *value == ',' )
+	{
+		*value++ = 0;
+	}
+
+	if( strcasecmp_P( name, PSTR("defaults") ) == 0 && *value == 0 )
+	{
+		CONFIG.setDefaults();
+	}
+	else
+	{
+		if( (field = CONFIG.find( name )) < 0 )
+		{
+			CONSOLE.error(F("unknown setting, g lists them"));
+			return;
+		}
+		n = strtol( value, &end, 10 );
+		if( end == value || *end != 0 )
+		{
+			CONSOLE.error(F("bad number"));
+			return;
+		}
+		if( !CONFIG.set( field, n ) )
+		{
+			CONSOLE.error(F("value out of range"));
+			return;
+		}
+	}
+
+	if( !CONFIG.save() )
+	{
+		CONSOLE.error(F("EEPROM write failed"));
+		return;
+	}
+	Serial.println(F("Saved; baud rates apply after a reset."));
+}
+
+void cmdShowMemory(const ConsoleArg *args)
+{
+	PRINTF( Serial, "Free %d, largest block %u, heap top 0x%04x\r\n",
+			freeMemory(), largestFreeBlock(), heapTop() );
+	PRINTF( Serial, "Stack max %u, never used %u\r\n",
+			stackHighWater(), stackUnused() );
+}
+
+void cmdToggleTelemetry(const ConsoleArg *args)
+{
+	if( TELEMETRY.isEnabled() )
+	{
+		TELEMETRY.setMode( TELEMETRY_OFF );
+		Serial.println(F("Binary telemetry off."));
+	}
+	else if( CONFIG.data.telemetry == TELEMETRY_BLOCKS )
+	{
+		TELEMETRY.setMode( TELEMETRY_BLOCKS );
+		Serial.println(F("Binary telemetry on, compressed."));
+	}
+	else
+	{
+		TELEMETRY.setMode( TELEMETRY_SAMPLES );
+		Serial.println(F("Binary telemetry on."));
+	}
+}
+
+/**
+ * Prints a history record as "start count tmin tmax tmean phmin phmax phmean"
+ */
+static void printHistory(uint8_t resolution, const HistoryRecord *record)
+{
+	Serial.printf( F("%lu %u %.2Q %.2Q %.2Q %.2Q %.2Q %.2Q\r\n"),
+			(unsigned long)record->start, record->count,
+			record->tempMin, record->tempMax, record->tempMean,
+			record->phMin, record->phMax, record->phMean );
+}
+
+static void sendHistory(uint8_t resolution, const HistoryRecord *record)
+{
+	TELEMETRY.sendHistory( resolution, record );
+}
+
+void cmdShowHistory(const ConsoleArg *args)
+{
+	const char *p = args[0].text;
+	unsigned long from = 0;
+	unsigned long to = 0xFFFFFFFF;
+	uint8_t resolution;
+	char *end;
+
+	switch( *p | 0x20 )
+	{
+	case 'r': resolution = HISTORY_RAW; break;
+	case 'm': resolution = HISTORY_MINUTE; break;
+	case 'h': resolution = HISTORY_HOUR; break;
+	default:
+		CONSOLE.error(F("expected r, m or h"));
+		return;
+	}
+
+	// optional epoch range
+	while( *p && *p != ' ' && *p != ',' )
+	{
+		p++;
+	}
+	if( *p )
+	{
+		from = strtoul( p, &end, 10 );
+		to = strtoul( end, &end, 10 );
+		if( end == p || *end != 0 || to < from )
+		{
+			CONSOLE.error(F("bad range"));
+			return;
+		}
+	}
+
+	// binary frames when telemetry is on, text otherwise
+	if( TELEMETRY.isEnabled() )
+	{
+		HISTORY.query( resolution, from, to, sendHistory );
+	}
+	else
+	{
+		PRINTF( Serial, "%u records\r\n", HISTORY.query( resolution, from, to, printHistory ) );
+	}
+}
+
+void cmdShowLog(const ConsoleArg *args)
+{
+	LogRecord record;
+
+	if( !LOGGER.isPresent() )
+	{
+		CONSOLE.error(F("no log EEPROM"));
+		return;
+	}
+
+	// the head moves when the flush completes, so read it after
+	if( !LOGGER.flush() )
+	{
+		CONSOLE.error(F("log EEPROM not answering"));
+	}
+	PRINTF( Serial, "block %u of %u, records %lu..%lu, %u write errors, %u dropped\r\n",
+			LOGGER.getHead(), LOGGER_BLOCKS, (unsigned long)LOGGER.getOldest(),
+			(unsigned long)LOGGER.getSequence() - 1, LOGGER.getErrors(), LOGGER.getDropped() );
+	if( LOGGER.read( LOGGER.getSequence() - 1, &record ) )
+	{
+		Serial.printf( F("last: record %lu epoch %lu temp %.2Q pH %.2Q\r\n"),
+				(unsigned long)record.sequence, (unsigned long)record.epoch, record.temp, record.ph );
+	}
+}
+
+void cmdDump(const ConsoleArg *args)
+{
+	if( args[1].number < args[0].number )
+	{
+		CONSOLE.error(F("bad range"));
+		return;
+	}
+	if( !DUMP.start( args[0].number, args[1].number, args[2].number ) )
+	{
+		CONSOLE.error(F("no log EEPROM"));
+	}
+}
+
+void cmdDumpAbort(const ConsoleArg *args)
+{
+	DUMP.abort();
+}
+
+void cmdDumpAck(const ConsoleArg *args)
+{
+	DUMP.ack( args[0].number );
+}
+
+void cmdHelp(const ConsoleArg *args)
+{
+	CONSOLE.help();
+}
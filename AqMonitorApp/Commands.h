@@ -0,0 +1,64 @@
+/*
+ * Commands.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#ifndef COMMANDS_H_
+#define COMMANDS_H_
+
+#include "Console.h"
+
+/**
+ * Console commands: CONSOLE_COMMAND(key, spec, handler, help)
+ *
+ * A command is its key character followed by the arguments the spec asks
+ * for, separated by spaces or commas: 'u' is an unsigned number and 's'
+ * takes the rest of the line.  Upper case keys without an entry of their
+ * own fall back to the lower case command.
+ */
+#define CONSOLE_COMMANDS \
+	CONSOLE_COMMAND('r', "",   cmdShowClock,    "r - Read clock as timestamp and epoch") \
+	CONSOLE_COMMAND('c', "s",  cmdSetTimestamp, "c YYYY-MM-DD HH:MM:SS - set Clock") \
+	CONSOLE_COMMAND('e', "u",  cmdSetEpoch,     "e# - set clock to Epoch (seconds since 2000)") \
+	CONSOLE_COMMAND('h', "u",  cmdSetHours,     "h## - set Hours") \
+	CONSOLE_COMMAND('i', "u",  cmdSetMinutes,   "i## - set mInutes") \
+	CONSOLE_COMMAND('s', "u",  cmdSetSeconds,   "s## - set Seconds") \
+	CONSOLE_COMMAND('y', "u",  cmdSetYear,      "y## - set Year") \
+	CONSOLE_COMMAND('m', "u",  cmdSetMonth,     "m## - set Month") \
+	CONSOLE_COMMAND('d', "u",  cmdSetDate,      "d## - set Date") \
+	CONSOLE_COMMAND('w', "u",  cmdSetDayOfWeek, "w# - set day of Week (1-7)") \
+	CONSOLE_COMMAND('W', "",   cmdShowDayOfWeek, "W - show day of Week") \
+	CONSOLE_COMMAND('t', "",   cmdToggle24h,    "t - toggle 24-hour mode") \
+	CONSOLE_COMMAND('a', "",   cmdSetAM,        "a - set AM") \
+	CONSOLE_COMMAND('p', "",   cmdSetPM,        "p - set PM") \
+	CONSOLE_COMMAND('z', "",   cmdStartClock,   "z - start clock") \
+	CONSOLE_COMMAND('Z', "",   cmdStopClock,    "Z - stop clock") \
+	CONSOLE_COMMAND('q', "",   cmdSqwEnable,    "q - SQW/OUT = 1Hz") \
+	CONSOLE_COMMAND('Q', "",   cmdSqwDisable,   "Q - stop SQW/OUT") \
+	CONSOLE_COMMAND('>', "uu", cmdWriteRegister, ">##,### - write to register ## the value ###") \
+	CONSOLE_COMMAND('<', "u",  cmdReadRegister, "<## - read the value in register ##") \
+	CONSOLE_COMMAND('g', "",   cmdShowConfig,   "g - show settings") \
+	CONSOLE_COMMAND('k', "s",  cmdSetConfig,    "k name value - set and save a setting; k defaults") \
+	CONSOLE_COMMAND('f', "",   cmdShowMemory,   "f - show Free memory and stack use") \
+	CONSOLE_COMMAND('l', "s",  cmdShowHistory,  "l r|m|h [from to] - List raw, minute or hour history") \
+	CONSOLE_COMMAND('n', "",   cmdShowLog,      "n - show Nonvolatile sample log") \
+	CONSOLE_COMMAND('x', "uuu", cmdDump,        "x from to offset - eXport log records as binary frames") \
+	CONSOLE_COMMAND('X', "",   cmdDumpAbort,    "X - stop an export") \
+	CONSOLE_COMMAND('o', "u",  cmdDumpAck,      "o# - acknowledge exported records before #") \
+	CONSOLE_COMMAND('b', "",   cmdToggleTelemetry, "b - toggle Binary telemetry frames") \
+	CONSOLE_COMMAND('?', "",   cmdHelp,         "? - show this help")
+
+#define CONSOLE_COMMAND(key, spec, handler, help) \
+	void handler(const ConsoleArg *);
+CONSOLE_COMMANDS
+#undef CONSOLE_COMMAND
+
+#endif /* COMMANDS_H_ */
@@ -0,0 +1,237 @@
+/*
+ * Config.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include <avr/eeprom.h>
+#include "Config.h"
+#include "Crc16.h"
+
+#define CONFIG_HEADER_SIZE	4
+
+/** A record has to fit its slot */
+typedef char ConfigFitsSlot[ (CONFIG_HEADER_SIZE + sizeof(ConfigData) + 2 <= CONFIG_SLOT_SIZE) ? 1 : -1 ];
+
+/** Field names, in flash */
+#define CONFIG_FIELD(name, type, def, min, max) static const char name##Name[] PROGMEM = #name;
+CONFIG_FIELDS
+#undef CONFIG_FIELD
+
+/** Field descriptions, in flash */
+struct ConfigField
+{
+	const prog_char *name;
+	uint8_t offset;
+	uint8_t size;
+	uint8_t isSigned;
+	long min;
+	long max;
+};
+
+static const ConfigField fields[] PROGMEM =
+{
+#define CONFIG_FIELD(name, type, def, min, max) \
+	{ name##Name, offsetof(ConfigData, name), sizeof(type), (type)-1 < 0, min, max },
+CONFIG_FIELDS
+#undef CONFIG_FIELD
+};
+
+#define CONFIG_FIELD_COUNT (sizeof(fields) / sizeof(fields[0]))
+
+static const ConfigData defaults PROGMEM =
+{
+#define CONFIG_FIELD(name, type, def, min, max) def,
+CONFIG_FIELDS
+#undef CONFIG_FIELD
+};
+
+/** Instance */
+Config CONFIG = Config();
+
+/**
+ * Constructor
+ */
+Config::Config()
+{
+	sequence = 0;
+	slot = CONFIG_SLOTS - 1;
+	setDefaults();
+
+} // end constructor
+
+/**
+ * Restores the compiled in settings, in RAM only
+ */
+void Config::setDefaults()
+{
+	memcpy_P( &data, &defaults, sizeof(data) );
+
+} // end setDefaults
+
+/**
+ * Loads the newest valid record from the journal, or leaves the defaults
+ * if there is none
+ */
+void Config::load()
+{
+	uint8_t record[CONFIG_HEADER_SIZE + sizeof(ConfigData) + 2];
+	const uint8_t *address;
+	uint16_t crc;
+	uint16_t seq;
+	boolean found = false;
+
+	for(uint8_t i=0; i < CONFIG_SLOTS; i++)
+	{
+		address = (const uint8_t *)(CONFIG_EEPROM_START + i*CONFIG_SLOT_SIZE);
+		eeprom_read_block( record, address, sizeof(record) );
+
+		crc = record[sizeof(record) - 2] | (record[sizeof(record) - 1] << 8);
+		if( record[2] != CONFIG_VERSION || record[3] != sizeof(ConfigData) ||
+				crc != crc16( record, sizeof(record) - 2 ) )
+		{
+			continue;
+		}
+
+		// Newest by serial number arithmetic, so the sequence may wrap
+		seq = record[0] | (record[1] << 8);
+		if( !found || (int16_t)(seq - sequence) > 0 )
+		{
+			found = true;
+			sequence = seq;
+			slot = i;
+			memcpy( &data, &record[CONFIG_HEADER_SIZE], sizeof(data) );
+		}
+	}
+
+	if( found )
+	{
+		PRINTF( Serial, "Config: loaded record %u from slot %u\r\n", sequence, slot );
+	}
+	else
+	{
+		Serial.println(F("Config: no record, using defaults"));
+	}
+
+} // end load
+
+/**
+ * Appends the current settings to the journal.  Returns false if the
+ * record did not read back correctly.
+ */
+boolean Config::save()
+{
+	uint8_t record[CONFIG_HEADER_SIZE + sizeof(ConfigData) + 2];
+	uint8_t check[sizeof(record)];
+	uint8_t *address;
+	uint16_t crc;
+
+	sequence++;
+	slot = (slot + 1) % CONFIG_SLOTS;
+	address = (uint8_t *)(CONFIG_EEPROM_START + slot*CONFIG_SLOT_SIZE);
+
+	record[0] = sequence;
+	record[1] = sequence >> 8;
+	record[2] = CONFIG_VERSION;
+	record[3] = sizeof(ConfigData);
+	memcpy( &record[CONFIG_HEADER_SIZE], &data, sizeof(data) );
+	crc = crc16( record, sizeof(record) - 2 );
+	record[sizeof(record) - 2] = crc;
+	record[sizeof(record) - 1] = crc >> 8;
+
+	eeprom_write_block( record, address, sizeof(record) );
+	eeprom_read_block( check, address, sizeof(check) );
+	return memcmp( record, check, sizeof(record) ) == 0;
+
+} // end save
+
+/**
+ * Returns the index of the named field (any case), or -1
+ */
+int8_t Config::find(const char *name)
+{
+	ConfigField field;
+
+	for(uint8_t i=0; i < CONFIG_FIELD_COUNT; i++)
+	{
+		memcpy_P( &field, &fields[i], sizeof(field) );
+		if( strcasecmp_P( name, field.name ) == 0 )
+		{
+			return i;
+		}
+	}
+	return -1;
+
+} // end find
+
+/**
+ * Sets a field in RAM if value is in its range
+ */
+boolean Config::set(uint8_t i, long value)
+{
+	ConfigField field;
+	uint8_t *p = (uint8_t *)&data;
+
+	memcpy_P( &field, &fields[i], sizeof(field) );
+	if( value < field.min || value > field.max )
+	{
+		return false;
+	}
+
+	// little endian, like the fields themselves
+	p += field.offset;
+	for(uint8_t n=0; n < field.size; n++)
+	{
+		*p++ = value;
+		value >>= 8;
+	}
+	return true;
+
+} // end set
+
+/**
+ * Returns a field as a long, whatever its size
+ */
+long Config::get(uint8_t i)
+{
+	ConfigField field;
+	const uint8_t *p = (const uint8_t *)&data;
+	long value = 0;
+
+	memcpy_P( &field, &fields[i], sizeof(field) );
+	p += field.offset;
+	for(uint8_t n=field.size; n > 0; n--)
+	{
+		value = (value << 8) | p[n - 1];
+	}
+	if( field.isSigned && field.size < sizeof(long) && (p[field.size - 1] & 0x80) )
+	{
+		value -= 1L << (8 * field.size);
+	}
+	return value;
+
+} // end get
+
+/**
+ * Lists every field with its value and range
+ */
+void Config::print(Print &out)
+{
+	ConfigField field;
+
+	for(uint8_t i=0; i < CONFIG_FIELD_COUNT; i++)
+	{
+		memcpy_P( &field, &fields[i], sizeof(field) );
+		out.printf( F(" %-12S %8ld  (%ld..%ld)\r\n"), field.name, get(i), field.min, field.max );
+	}
+	PRINTF( out, " record %u in slot %u\r\n", sequence, slot );
+
+} // end print
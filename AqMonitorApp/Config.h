@@ -0,0 +1,86 @@
+/*
+ * Config.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <WProgram.h>
+#include <stddef.h>
+#include "TemperatureProbe.h"
+#include "PhStamp.h"
+#include "Lcd.h"
+
+/**
+ * Run time settings: CONFIG_FIELD(name, type, default, min, max)
+ *
+ * The defaults are the old compile time values.  The sample counts may
+ * be lowered, but not raised past the sizes the arrays are built with.
+ * telemetry is the Telemetry mode: 0 off, 1 sample frames, 2 compressed
+ * blocks.  It starts off so frames do not land in the console's output.
+ */
+#define CONFIG_FIELDS \
+	CONFIG_FIELD(tempVRef,    uint16_t, TEMP_V_REF_MV,    1000, 5000) \
+	CONFIG_FIELD(tempSamples, uint8_t,  TEMP_SAMPLE_SIZE, 1, TEMP_SAMPLE_SIZE) \
+	CONFIG_FIELD(tempOffset,  int16_t,  0,                -1000, 1000) \
+	CONFIG_FIELD(phSamples,   uint8_t,  PH_SAMPLE_SIZE,   1, PH_SAMPLE_SIZE) \
+	CONFIG_FIELD(phOffset,    int16_t,  0,                -200, 200) \
+	CONFIG_FIELD(phBaud,      uint32_t, PH_BAUD_RATE,     300, 57600) \
+	CONFIG_FIELD(lcdBaud,     uint32_t, LCD_BAUD_RATE,    300, 57600) \
+	CONFIG_FIELD(telemetry,   uint8_t,  0,                0, 2)
+
+/** Bump when fields change; records of another version are ignored */
+#define CONFIG_VERSION			1
+
+/**
+ * The EEPROM journal: CONFIG_SLOTS slots of CONFIG_SLOT_SIZE bytes, each
+ * holding sequence(2) version length data[length] crc(2).  Every save
+ * goes to the slot after the newest, so the writes are spread over all
+ * of them.
+ */
+#define CONFIG_EEPROM_START		0x000
+#define CONFIG_SLOT_SIZE		32
+#define CONFIG_SLOTS			16
+#define CONFIG_EEPROM_END		(CONFIG_EEPROM_START + CONFIG_SLOT_SIZE*CONFIG_SLOTS)
+
+struct ConfigData
+{
+#define CONFIG_FIELD(name, type, def, min, max) type name;
+	CONFIG_FIELDS
+#undef CONFIG_FIELD
+};
+
+class Config
+{
+public:
+	Config();
+	void load();
+	boolean save();
+	void setDefaults();
+	int8_t find(const char *name);
+	boolean set(uint8_t field, long value);
+	long get(uint8_t field);
+	void print(Print &out);
+
+	/** The settings; read these directly, they are plain RAM */
+	ConfigData data;
+
+private:
+	uint16_t sequence;
+	uint8_t slot;
+
+};
+
+extern Config CONFIG;
+
+#endif /* CONFIG_H_ */
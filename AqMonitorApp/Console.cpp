@@ -0,0 +1,235 @@
+/*
+ * Console.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include "Console.h"
+#include "Commands.h"
+
+/** Instance */
+Console CONSOLE = Console();
+
+/** Flash strings for each command */
+#define CONSOLE_COMMAND(key, spec, handler, help) \
+	static const char handler##Spec[] PROGMEM = spec; \
+	static const char handler##Help[] PROGMEM = help;
+CONSOLE_COMMANDS
+#undef CONSOLE_COMMAND
+
+/** Table index of each command */
+enum
+{
+#define CONSOLE_COMMAND(key, spec, handler, help) handler##Index,
+CONSOLE_COMMANDS
+#undef CONSOLE_COMMAND
+	CONSOLE_COMMAND_COUNT
+};
+
+/** The command table */
+static const ConsoleCommand commands[CONSOLE_COMMAND_COUNT] PROGMEM =
+{
+#define CONSOLE_COMMAND(key, spec, handler, help) \
+	{ key, handler##Spec, handler, handler##Help },
+CONSOLE_COMMANDS
+#undef CONSOLE_COMMAND
+};
+
+/**
+ * Maps a key to its table index, or -1.  The compiler turns the switch
+ * into a jump table, so lookup time does not grow with the table.
+ */
+static int8_t findCommand(char key)
+{
+	switch( key )
+	{
+#define CONSOLE_COMMAND(key, spec, handler, help) case key: return handler##Index;
+CONSOLE_COMMANDS
+#undef CONSOLE_COMMAND
+	}
+	return -1;
+}
+
+/**
+ * Constructor
+ */
+Console::Console()
+{
+	length = 0;
+	overflow = false;
+	busy = false;
+
+} // end constructor
+
+/**
+ * Collects whatever the serial port has received and runs each complete
+ * line.  Never waits for more input.
+ */
+void Console::poll()
+{
+	char c;
+
+	// A handler that waits lets the yield hook call back in here
+	if( busy )
+	{
+		return;
+	}
+	busy = true;
+
+	while( Serial.available() )
+	{
+		c = Serial.read();
+		if( c == '\r' || c == '\n' )
+		{
+			if( overflow )
+			{
+				error(F("line too long"));
+			}
+			else if( length > 0 )
+			{
+				line[length] = 0;
+				dispatch();
+			}
+			length = 0;
+			overflow = false;
+		}
+		else if( c == '\b' || c == 0x7f )
+		{
+			if( length > 0 )
+			{
+				length--;
+			}
+		}
+		else if( length < CONSOLE_LINE_SIZE - 1 )
+		{
+			line[length++] = c;
+		}
+		else
+		{
+			overflow = true;
+		}
+	}
+
+	busy = false;
+
+} // end poll
+
+/**
+ * Looks up and runs the command on the current line
+ */
+void Console::dispatch()
+{
+	ConsoleCommand command;
+	ConsoleArg args[CONSOLE_MAX_ARGS];
+	int8_t i;
+
+	i = findCommand( line[0] );
+	if( i < 0 && line[0] >= 'A' && line[0] <= 'Z' )
+	{
+		i = findCommand( line[0] - 'A' + 'a' );
+	}
+	if( i < 0 )
+	{
+		error(F("unknown command, ? for help"));
+		return;
+	}
+
+	memcpy_P( &command, &commands[i], sizeof(command) );
+	if( parseArgs( command.spec, &line[1], args ) )
+	{
+		command.handler( args );
+	}
+
+} // end dispatch
+
+/**
+ * Splits the arguments following the key according to spec.  Replies
+ * with an error and returns false if they do not match.
+ */
+boolean Console::parseArgs(const prog_char *spec, char *s, ConsoleArg *args)
+{
+	char type;
+	unsigned long n;
+	uint8_t digits;
+
+	while( (type = pgm_read_byte(spec++)) != 0 )
+	{
+		while( *s == ' ' || *s == ',' )
+		{
+			s++;
+		}
+		if( *s == 0 )
+		{
+			error(F("missing argument"));
+			return false;
+		}
+
+		if( type == 's' )
+		{
+			(args++)->text = s;
+			return true;
+		}
+
+		n = 0;
+		for( digits = 0; *s >= '0' && *s <= '9'; digits++, s++ )
+		{
+			if( n > (0xffffffffUL - 9) / 10 )
+			{
+				error(F("number too large"));
+				return false;
+			}
+			n = n*10 + (*s - '0');
+		}
+		if( digits == 0 || (*s != 0 && *s != ' ' && *s != ',') )
+		{
+			error(F("bad number"));
+			return false;
+		}
+		(args++)->number = n;
+	}
+
+	while( *s == ' ' || *s == ',' )
+	{
+		s++;
+	}
+	if( *s != 0 )
+	{
+		error(F("too many arguments"));
+		return false;
+	}
+	return true;
+
+} // end parseArgs
+
+/**
+ * Lists the commands
+ */
+void Console::help()
+{
+	ConsoleCommand command;
+
+	for(uint8_t i=0; i < CONSOLE_COMMAND_COUNT; i++)
+	{
+		memcpy_P( &command, &commands[i], sizeof(command) );
+		Serial.print(F(" "));
+		Serial.println( (const __FlashStringHelper *)command.help );
+	}
+
+} // end help
+
+/**
+ * Replies with an error message
+ */
+void Console::error(const __FlashStringHelper *message)
+{
+	Serial.print(F("** Error: "));
+	Serial.println( message );
+
+} // end error
@@ -0,0 +1,61 @@
+/*
+ * Console.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include <WProgram.h>
+
+#define CONSOLE_LINE_SIZE	40
+#define CONSOLE_MAX_ARGS	3
+
+/** One parsed argument; which member is set follows the argument spec */
+typedef union
+{
+	unsigned long number;	// 'u' - unsigned decimal
+	const char *text;		// 's' - rest of the line
+} ConsoleArg;
+
+typedef void (*ConsoleHandler)(const ConsoleArg *args);
+
+/** Command table entry, kept in flash */
+struct ConsoleCommand
+{
+	char key;
+	const prog_char *spec;
+	ConsoleHandler handler;
+	const prog_char *help;
+};
+
+class Console
+{
+public:
+	Console();
+	void poll();
+	void help();
+	void error(const __FlashStringHelper *message);
+
+private:
+	char line[CONSOLE_LINE_SIZE];
+	uint8_t length;
+	boolean overflow;
+	boolean busy;
+
+	void dispatch();
+	boolean parseArgs(const prog_char *spec, char *s, ConsoleArg *args);
+
+};
+
+extern Console CONSOLE;
+
+#endif /* CONSOLE_H_ */
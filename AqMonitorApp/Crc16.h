@@ -0,0 +1,52 @@
+/*
+ * Crc16.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include <stdint.h>
+
+/**
+ * CRC-CCITT as computed by avr-libc's _crc_ccitt_update(), starting from
+ * CRC16_START.  Plain C with a portable fallback so the host tools get
+ * the same result.
+ */
+#define CRC16_START		0xFFFF
+
+#if defined(__AVR__)
+#include <util/crc16.h>
+#define crc16Update _crc_ccitt_update
+#else
+static inline uint16_t crc16Update(uint16_t crc, uint8_t data)
+{
+	data ^= crc & 0xff;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4)
+			^ ((uint16_t)data << 3));
+}
+#endif
+
+/** CRC of a whole buffer */
+static inline uint16_t crc16(const uint8_t *data, uint16_t length)
+{
+	uint16_t crc = CRC16_START;
+
+	while( length-- )
+	{
+		crc = crc16Update( crc, *data++ );
+	}
+	return crc;
+}
+
+#endif /* CRC16_H_ */
@@ -0,0 +1,200 @@
+/*
+ * Dump.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include "Dump.h"
+
+/** Instance */
+Dump DUMP = Dump();
+
+/**
+ * Constructor
+ */
+Dump::Dump()
+{
+	frameLength = 0;
+	active = false;
+	ended = false;
+
+} // end constructor
+
+/**
+ * Starts a dump of the records from..to (epochs), beginning no earlier
+ * than record offset.  Returns false if there is no log.
+ */
+boolean Dump::start(unsigned long f, unsigned long t, uint32_t offset)
+{
+	if( !LOGGER.isPresent() )
+	{
+		return false;
+	}
+	if( active )
+	{
+		finish( TELEMETRY_DUMP_ABORTED );
+	}
+
+	// the first frame covers offset..begin as skipped, so the host can
+	// tell this run's frames from a lost one
+	from = f;
+	to = t;
+	begin = LOGGER.find( f );
+	next = offset;
+	acked = offset;
+	ackTime = millis();
+	frameLength = 0;
+	ended = false;
+	active = true;
+	return true;
+
+} // end start
+
+/**
+ * The host has every record before offset
+ */
+void Dump::ack(uint32_t offset)
+{
+	if( active && offset > acked && offset <= next )
+	{
+		acked = offset;
+		ackTime = millis();
+	}
+
+} // end ack
+
+void Dump::abort()
+{
+	if( active )
+	{
+		finish( TELEMETRY_DUMP_ABORTED );
+	}
+
+} // end abort
+
+boolean Dump::isActive()
+{
+	return active;
+}
+
+/**
+ * Sends what the window allows; call often
+ */
+void Dump::poll()
+{
+	uint8_t *payload = frame + TELEMETRY_HEADER_SIZE;
+	LogRecord *records = (LogRecord *)(payload + TELEMETRY_DUMP_HEADER_SIZE);
+	uint32_t stored;
+	uint32_t first;
+	uint8_t n = 0;
+
+	if( !active || !push() )
+	{
+		return;
+	}
+
+	// nothing heard: go back to the last acknowledged record
+	if( next != acked && millis() - ackTime > DUMP_ACK_TIMEOUT )
+	{
+		next = acked;
+		ended = false;
+		ackTime = millis();
+	}
+
+	first = next;
+	if( next < begin )
+	{
+		next = begin;
+	}
+	if( next < LOGGER.getOldest() )
+	{
+		next = LOGGER.getOldest();	// overwritten while we were away
+	}
+	stored = LOGGER.getStored();
+
+	while( n < DUMP_FRAME_RECORDS && !ended && next < stored && next - acked < DUMP_WINDOW )
+	{
+		// straight into the frame; skip records that are unreadable or
+		// were overwritten since the dump started
+		if( LOGGER.read( next, &records[n] ) )
+		{
+			if( records[n].epoch > to )
+			{
+				ended = true;
+				break;
+			}
+			if( records[n].epoch >= from )
+			{
+				n++;
+			}
+		}
+		next++;
+	}
+
+	if( next != first )
+	{
+		put32( payload, first );
+		put32( payload + 4, next );
+		frameLength = TELEMETRY.buildFrame( frame, TELEMETRY_TYPE_DUMP, payload,
+				TELEMETRY_DUMP_HEADER_SIZE + n * LOGGER_RECORD_SIZE );
+		push();
+	}
+	else if( (ended || next >= stored) && acked == next )
+	{
+		finish( TELEMETRY_DUMP_DONE );
+	}
+
+} // end poll
+
+/**
+ * Hands the pending frame to the serial port if it fits without
+ * waiting; true once nothing is pending
+ */
+boolean Dump::push()
+{
+	if( frameLength )
+	{
+		if( Serial.availableForWrite() < frameLength )
+		{
+			return false;
+		}
+		Serial.write( frame, frameLength );
+		frameLength = 0;
+	}
+	return true;
+
+} // end push
+
+/**
+ * Sends the end frame
+ */
+void Dump::finish(uint8_t status)
+{
+	uint8_t payload[TELEMETRY_DUMP_END_SIZE];
+
+	put32( payload, next );
+	payload[4] = status;
+
+	// the frame buffer may hold a frame not yet sent; it is dropped
+	frameLength = TELEMETRY.buildFrame( frame, TELEMETRY_TYPE_DUMP_END, payload, sizeof(payload) );
+	Serial.write( frame, frameLength );
+	frameLength = 0;
+	active = false;
+
+} // end finish
+
+void Dump::put32(uint8_t *p, uint32_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
@@ -0,0 +1,70 @@
+/*
+ * Dump.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef DUMP_H_
+#define DUMP_H_
+
+#include <WProgram.h>
+#include "Telemetry.h"
+#include "Logger.h"
+
+/**
+ * Streams a time range of the EEPROM log as TELEMETRY_TYPE_DUMP frames
+ * while sampling goes on.  Records are read into the frame buffer and a
+ * frame is handed to the serial port only when its transmit buffer has
+ * room for all of it, so poll() never waits on the UART.
+ *
+ * Records are numbered by their log sequence.  The host acknowledges
+ * with "o<next>", next taken from the last frame it got; no more than
+ * DUMP_WINDOW records go out past the last acknowledgement, and after
+ * DUMP_ACK_TIMEOUT without one the dump goes back to it.  A dump can be
+ * restarted from any record with "x from to offset".  A
+ * TELEMETRY_TYPE_DUMP_END frame closes it.
+ */
+#define DUMP_FRAME_RECORDS		3
+#define DUMP_WINDOW				24
+#define DUMP_ACK_TIMEOUT		1000	// ms
+
+class Dump
+{
+public:
+	Dump();
+	boolean start(unsigned long from, unsigned long to, uint32_t offset);
+	void ack(uint32_t offset);
+	void abort();
+	void poll();
+	boolean isActive();
+
+private:
+	uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_DUMP_HEADER_SIZE
+			+ DUMP_FRAME_RECORDS*LOGGER_RECORD_SIZE + TELEMETRY_CRC_SIZE];
+	uint8_t frameLength;	// frame bytes waiting for the serial port
+	boolean active;
+	boolean ended;			// reached a record past the range
+	unsigned long from;
+	unsigned long to;
+	uint32_t begin;			// first record in the range
+	uint32_t next;			// next record to read
+	uint32_t acked;			// host has everything before this
+	unsigned long ackTime;
+
+	boolean push();
+	void finish(uint8_t status);
+	void put32(uint8_t *p, uint32_t value);
+
+};
+
+extern Dump DUMP;
+
+#endif /* DUMP_H_ */
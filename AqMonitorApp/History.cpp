@@ -0,0 +1,285 @@
+/*
+ * History.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include <avr/eeprom.h>
+#include "History.h"
+#include "Crc16.h"
+
+/** The EEPROM after the settings must hold a day of hours */
+typedef char HistoryHoldsADay[ (HISTORY_HOURS >= 24) ? 1 : -1 ];
+
+/** Instance */
+History HISTORY = History();
+
+/**
+ * Constructor
+ */
+History::History()
+{
+	memset( rawLength, 0, sizeof(rawLength) );
+	rawBlock = 0;
+	sampleEncoderBegin( &rawEncoder, raw[0], HISTORY_RAW_BLOCK_SIZE, 0 );
+	minuteHead = 0;
+	minuteCount = 0;
+	minute.count = 0;
+	hour.count = 0;
+	hourSlot = HISTORY_HOURS - 1;
+	hourSequence = 0;
+
+} // end constructor
+
+/**
+ * Finds the newest hour in the EEPROM ring so new hours follow it.  The
+ * newest is the one written last, not the latest start, so a clock that
+ * was set back does not change where the ring continues.
+ */
+void History::initialize()
+{
+	HistoryRecord record;
+	uint8_t sequence;
+	uint8_t valid = 0;
+
+	for(uint8_t i=0; i < HISTORY_HOURS; i++)
+	{
+		if( readHour( i, &record, &sequence ) )
+		{
+			// Newest by serial number arithmetic, so the sequence may wrap
+			if( valid == 0 || (int8_t)(sequence - hourSequence) > 0 )
+			{
+				hourSequence = sequence;
+				hourSlot = i;
+			}
+			valid++;
+		}
+	}
+	PRINTF( Serial, "History: %u of %u hours stored\r\n", valid, (unsigned int)HISTORY_HOURS );
+
+} // end initialize
+
+/**
+ * Adds a reading taken at epoch
+ */
+void History::add(unsigned long epoch, int16_t temp, int16_t ph)
+{
+	unsigned long minuteStart = epoch - epoch % 60;
+	unsigned long hourStart = epoch - epoch % 3600;
+	HistoryRecord record;
+	sample_record sample;
+
+	// Raw ring; a full block starts the next, dropping the oldest
+	sample.epoch = epoch;
+	sample.temp = temp;
+	sample.ph = ph;
+	sample.errors = 0;
+	if( !sampleEncode( &rawEncoder, &sample ) )
+	{
+		rawBlock = (rawBlock + 1) % HISTORY_RAW_BLOCKS;
+		sampleEncoderBegin( &rawEncoder, raw[rawBlock], HISTORY_RAW_BLOCK_SIZE, 0 );
+		sampleEncode( &rawEncoder, &sample );
+	}
+	rawLength[rawBlock] = rawEncoder.length;
+
+	// A reading from another minute or hour (or a clock that was set
+	// back) closes the rollup in progress
+	if( minute.count && minute.start != minuteStart )
+	{
+		close( &minute, &minutes[minuteHead] );
+		minuteHead = (minuteHead + 1) % HISTORY_MINUTES;
+		if( minuteCount < HISTORY_MINUTES )
+		{
+			minuteCount++;
+		}
+		minute.count = 0;
+	}
+	if( hour.count && hour.start != hourStart )
+	{
+		close( &hour, &record );
+		writeHour( &record );
+		hour.count = 0;
+	}
+
+	accumulate( &minute, minuteStart, temp, ph );
+	accumulate( &hour, hourStart, temp, ph );
+
+} // end add
+
+/**
+ * Visits every record of the given resolution that starts within
+ * from..to, oldest first, including the minute or hour in progress.
+ * Returns the number visited.
+ */
+uint16_t History::query(uint8_t resolution, unsigned long from, unsigned long to, HistoryVisitor visit)
+{
+	HistoryRecord record;
+	sample_decoder decoder;
+	sample_record sample;
+	uint8_t sequence;
+	uint16_t visited = 0;
+	uint8_t i, n;
+
+	switch( resolution )
+	{
+	case HISTORY_RAW:
+		for(n=1; n <= HISTORY_RAW_BLOCKS; n++)
+		{
+			i = (rawBlock + n) % HISTORY_RAW_BLOCKS;
+			sampleDecoderBegin( &decoder, raw[i], rawLength[i] );
+			while( sampleDecode( &decoder, &sample ) == 1 )
+			{
+				if( sample.epoch >= from && sample.epoch <= to )
+				{
+					record.start = sample.epoch;
+					record.count = 1;
+					record.tempMin = record.tempMax = record.tempMean = sample.temp;
+					record.phMin = record.phMax = record.phMean = sample.ph;
+					visit( resolution, &record );
+					visited++;
+				}
+			}
+		}
+		break;
+
+	case HISTORY_MINUTE:
+		for(n=0; n < minuteCount; n++)
+		{
+			i = (minuteHead + HISTORY_MINUTES - minuteCount + n) % HISTORY_MINUTES;
+			if( minutes[i].start >= from && minutes[i].start <= to )
+			{
+				visit( resolution, &minutes[i] );
+				visited++;
+			}
+		}
+		if( minute.count && minute.start >= from && minute.start <= to )
+		{
+			close( &minute, &record );
+			visit( resolution, &record );
+			visited++;
+		}
+		break;
+
+	case HISTORY_HOUR:
+		for(n=1; n <= HISTORY_HOURS; n++)
+		{
+			i = (hourSlot + n) % HISTORY_HOURS;
+			if( readHour( i, &record, &sequence ) && record.start >= from && record.start <= to )
+			{
+				visit( resolution, &record );
+				visited++;
+			}
+		}
+		if( hour.count && hour.start >= from && hour.start <= to )
+		{
+			close( &hour, &record );
+			visit( resolution, &record );
+			visited++;
+		}
+		break;
+	}
+	return visited;
+
+} // end query
+
+/**
+ * Folds a reading into a rollup, starting it if empty
+ */
+void History::accumulate(HistoryAccumulator *a, unsigned long start, int16_t temp, int16_t ph)
+{
+	if( a->count == 0 )
+	{
+		a->start = start;
+		a->tempMin = a->tempMax = temp;
+		a->phMin = a->phMax = ph;
+		a->tempSum = 0;
+		a->phSum = 0;
+	}
+	a->count++;
+	a->tempSum += temp;
+	a->phSum += ph;
+	if( temp < a->tempMin ) a->tempMin = temp;
+	if( temp > a->tempMax ) a->tempMax = temp;
+	if( ph < a->phMin ) a->phMin = ph;
+	if( ph > a->phMax ) a->phMax = ph;
+
+} // end accumulate
+
+/**
+ * Turns a rollup into a record
+ */
+void History::close(const HistoryAccumulator *a, HistoryRecord *record)
+{
+	record->start = a->start;
+	record->count = a->count;
+	record->tempMin = a->tempMin;
+	record->tempMax = a->tempMax;
+	record->tempMean = a->tempSum / a->count;
+	record->phMin = a->phMin;
+	record->phMax = a->phMax;
+	record->phMean = a->phSum / a->count;
+
+} // end close
+
+/**
+ * Reads an hour slot and its sequence number; false if it was never
+ * written or is corrupt
+ */
+boolean History::readHour(uint8_t slot, HistoryRecord *record, uint8_t *sequence)
+{
+	uint8_t buffer[HISTORY_SLOT_SIZE];
+	HistoryHour stored;
+	uint16_t crc;
+
+	eeprom_read_block( buffer, (const void *)(HISTORY_EEPROM_START + slot*HISTORY_SLOT_SIZE), sizeof(buffer) );
+	crc = buffer[sizeof(buffer) - 2] | (buffer[sizeof(buffer) - 1] << 8);
+	if( crc != crc16( buffer, sizeof(buffer) - 2 ) )
+	{
+		return false;
+	}
+	memcpy( &stored, buffer, sizeof(stored) );
+
+	*sequence = stored.sequence;
+	record->start = (stored.hour[0] | ((uint32_t)stored.hour[1] << 8) |
+			((uint32_t)stored.hour[2] << 16)) * 3600;
+	// count and tempMin..phMean are laid out alike in both
+	memcpy( &record->count, &stored.count, sizeof(stored) - offsetof(HistoryHour, count) );
+	return true;
+
+} // end readHour
+
+/**
+ * Writes a finished hour to the slot after the newest.  Takes about
+ * 66ms, once an hour.
+ */
+void History::writeHour(const HistoryRecord *record)
+{
+	uint8_t buffer[HISTORY_SLOT_SIZE];
+	HistoryHour stored;
+	uint32_t hour = record->start / 3600;
+	uint16_t crc;
+
+	hourSequence++;
+	stored.sequence = hourSequence;
+	stored.hour[0] = hour;
+	stored.hour[1] = hour >> 8;
+	stored.hour[2] = hour >> 16;
+	memcpy( &stored.count, &record->count, sizeof(stored) - offsetof(HistoryHour, count) );
+
+	memcpy( buffer, &stored, sizeof(stored) );
+	crc = crc16( buffer, sizeof(buffer) - 2 );
+	buffer[sizeof(buffer) - 2] = crc;
+	buffer[sizeof(buffer) - 1] = crc >> 8;
+
+	hourSlot = (hourSlot + 1) % HISTORY_HOURS;
+	eeprom_write_block( buffer, (void *)(HISTORY_EEPROM_START + hourSlot*HISTORY_SLOT_SIZE), sizeof(buffer) );
+
+} // end writeHour
@@ -0,0 +1,130 @@
+/*
+ * History.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <WProgram.h>
+#include "Config.h"
+#include "SampleCodec.h"
+
+/**
+ * Reading history at three resolutions:
+ *
+ *   raw     every reading of the last few minutes, in RAM
+ *   minute  min/max/mean of the last HISTORY_MINUTES minutes, in RAM
+ *   hour    min/max/mean per hour, in an EEPROM ring after the settings
+ *
+ * The minute and hour figures are kept up to date as readings arrive, so
+ * a query only walks the rollups it asks for.
+ */
+#define HISTORY_MINUTES			12
+
+#define HISTORY_RAW				0
+#define HISTORY_MINUTE			1
+#define HISTORY_HOUR			2
+
+/**
+ * Raw ring: blocks of readings delta coded with the sample codec, about
+ * a byte a reading while only the pH moves.  A full block moves on to
+ * the next, dropping the oldest.  At one reading a second with the pH
+ * moving on every one, the ring keeps two and a half minutes or more.
+ */
+#define HISTORY_RAW_BLOCKS		5
+#define HISTORY_RAW_BLOCK_SIZE	64
+
+/**
+ * EEPROM hour ring: records of HISTORY_SLOT_SIZE bytes, crc at the end.
+ * The record is stored as it is in memory, so it is built from fixed
+ * size fields with no padding.
+ */
+#define HISTORY_EEPROM_START	CONFIG_EEPROM_END
+#define HISTORY_SLOT_SIZE		(sizeof(HistoryHour) + 2)
+#define HISTORY_HOURS			((E2END + 1 - HISTORY_EEPROM_START) / HISTORY_SLOT_SIZE)
+
+/** One reading, or a rollup of count readings from start on */
+struct HistoryRecord
+{
+	uint32_t start;			// seconds since 2000
+	uint16_t count;
+	int16_t tempMin;
+	int16_t tempMax;
+	int16_t tempMean;
+	int16_t phMin;
+	int16_t phMax;
+	int16_t phMean;
+};
+
+/** An hour as stored in the EEPROM ring */
+struct HistoryHour
+{
+	uint8_t sequence;		// newest by serial number arithmetic
+	uint8_t hour[3];		// start, in hours since 2000, little endian
+	uint16_t count;
+	int16_t tempMin;
+	int16_t tempMax;
+	int16_t tempMean;
+	int16_t phMin;
+	int16_t phMax;
+	int16_t phMean;
+};
+
+/** Rollup still being collected */
+struct HistoryAccumulator
+{
+	uint32_t start;
+	uint16_t count;
+	int16_t tempMin;
+	int16_t tempMax;
+	int16_t phMin;
+	int16_t phMax;
+	int32_t tempSum;
+	int32_t phSum;
+};
+
+typedef void (*HistoryVisitor)(uint8_t resolution, const HistoryRecord *record);
+
+class History
+{
+public:
+	History();
+	void initialize();
+	void add(unsigned long epoch, int16_t temp, int16_t ph);
+	uint16_t query(uint8_t resolution, unsigned long from, unsigned long to, HistoryVisitor visit);
+
+private:
+	uint8_t raw[HISTORY_RAW_BLOCKS][HISTORY_RAW_BLOCK_SIZE];
+	uint8_t rawLength[HISTORY_RAW_BLOCKS];	// bytes used in each block
+	uint8_t rawBlock;						// block being written
+	sample_encoder rawEncoder;
+
+	HistoryRecord minutes[HISTORY_MINUTES];
+	uint8_t minuteHead;
+	uint8_t minuteCount;
+
+	HistoryAccumulator minute;
+	HistoryAccumulator hour;
+	uint8_t hourSlot;
+	uint8_t hourSequence;
+
+	void accumulate(HistoryAccumulator *a, unsigned long start, int16_t temp, int16_t ph);
+	void close(const HistoryAccumulator *a, HistoryRecord *record);
+	boolean readHour(uint8_t slot, HistoryRecord *record, uint8_t *sequence);
+	void writeHour(const HistoryRecord *record);
+
+};
+
+extern History HISTORY;
+
+#endif /* HISTORY_H_ */
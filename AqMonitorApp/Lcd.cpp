@@ -15,6 +15,7 @@
  */
 
 #include "Lcd.h"
+#include "Config.h"
 
 /** Create instance */
 Lcd LCD = Lcd();
@@ -33,13 +34,13 @@ Lcd::Lcd()
  */
 void Lcd::initialize()
 {
-	Serial.println("Initializing LCD");
+	Serial.println(F("Initializing LCD"));
 
 	// Select lcdPort. don't think we need this since we're always transmitting, but it doesn't hurt
 	lcdPort.listen();
 
 	// Initialize serial
-	lcdPort.begin(9600);
+	lcdPort.begin(CONFIG.data.lcdBaud);
 
 	// Initialize LCD
 	enableDisplay( false );
@@ -49,21 +50,21 @@ void Lcd::initialize()
 
 	// Set up screen
 	setCursorPosition(LCD_LINE_1_START);
-	lcdPort.print(STRING_DATE);
+	lcdPort.print(F(STRING_DATE));
 
 	setCursorPosition(LCD_LINE_2_START);
-	lcdPort.print(STRING_TIME);
+	lcdPort.print(F(STRING_TIME));
 
 	setCursorPosition(LCD_LINE_3_START);
-	lcdPort.print(STRING_TEMP);
+	lcdPort.print(F(STRING_TEMP));
 
 	setCursorPosition(LCD_LINE_4_START);
-	lcdPort.print(STRING_PH);
+	lcdPort.print(F(STRING_PH));
 
 	// Turn screen on
 	enableDisplay( true );
 
-	Serial.println("LCD Initialization Complete.");
+	Serial.println(F("LCD Initialization Complete."));
 
 } // end initialize
 
@@ -72,12 +73,12 @@ void Lcd::initialize()
 /**
  * Updates display with a new temperature
  */
-void Lcd::updateTemp(double temp)
+void Lcd::updateTemp(int16_t temp)
 {
 	setCursorPosition(LCD_CURSOR_POS_TEMP_START);
 
 	// Send temp to LCD
-	lcdPort.print( temp, 2 );
+	lcdPort.printFixed( temp, 2 );
 
 } // end updateTemp
 
@@ -85,13 +86,13 @@ void Lcd::updateTemp(double temp)
 /**
  * Updates display with a new pH
  */
-void Lcd::updatepH(double ph)
+void Lcd::updatepH(int16_t ph)
 {
 	// Set cursor location
 	setCursorPosition(LCD_CURSOR_POS_PH_START);
 
 	// Send ph to LCD
-	lcdPort.print( ph, 2 );
+	lcdPort.printFixed( ph, 2 );
 
 } // end updatepH
 
@@ -104,39 +105,10 @@ void Lcd::updateTime(uint8_t hour, uint8_t min, uint8_t sec, boolean is12, boole
 	// if stored time is different from read time, update.  Else, return
 
 	setCursorPosition(LCD_CURSOR_POS_TIME_START);
-	if( hour < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( hour, DEC );
-	lcdPort.print( ":" );
-	if( min < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( min, DEC );
-	lcdPort.print( ":" );
-	if( sec < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( sec, DEC );
 
-	if( is12 )
-	{
-		if( isPM )
-		{
-			lcdPort.print(" PM");
-		}
-		else
-		{
-			lcdPort.print(" AM");
-		}
-	}
-	else
-	{
-		lcdPort.print("   ");  // blank AM/PM if it was there; only need to do once...
-	}
+	// Blank AM/PM in 24-hour mode in case it was there
+	lcdPort.printf( F("%02u:%02u:%02u %S"), hour, min, sec,
+			is12 ? (isPM ? PSTR("PM") : PSTR("AM")) : PSTR("  ") );
 
 } // end updateTime
 
@@ -150,23 +122,7 @@ void Lcd::updateDate(uint8_t month, uint8_t day, uint8_t year)
 	setCursorPosition(LCD_CURSOR_POS_DATE_START);
 
 	// Send date to LCD
-	if( month < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( month, DEC );
-	lcdPort.print( "/" );
-	if( day < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( day, DEC );
-	lcdPort.print( "/20" );
-	if( year < 10 )
-	{
-		lcdPort.print( "0" );
-	}
-	lcdPort.print( year, DEC );
+	PRINTF( lcdPort, "%02u/%02u/20%02u", month, day, year );
 
 } // end updateDate
 
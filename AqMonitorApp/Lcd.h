@@ -69,14 +69,15 @@
 
 #define LCD_RX_PIN 3
 #define LCD_TX_PIN 4
+#define LCD_BAUD_RATE 9600
 
 class Lcd
 {
 public:
 	Lcd();
 	void initialize();
-	void updateTemp(double temp);
-	void updatepH(double ph);
+	void updateTemp(int16_t temp);
+	void updatepH(int16_t ph);
 	void updateDate(uint8_t month, uint8_t day, uint8_t year);
 	void updateTime(uint8_t hour, uint8_t min, uint8_t sec, boolean is12, boolean isPM);
 	void home();
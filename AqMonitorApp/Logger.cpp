@@ -0,0 +1,636 @@
+/*
+ * Logger.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#include <Wire.h>
+#include "Logger.h"
+#include "Crc16.h"
+
+#if LOGGER_PAGE_SIZE % LOGGER_BLOCK_SIZE
+#error "blocks must not straddle EEPROM pages"
+#endif
+#if LOGGER_SIZE > 524288UL
+#error "the log addressing covers four 24LC1025s at most"
+#endif
+#if LOGGER_SIZE > 65536UL && LOGGER_SIZE % 131072UL
+#error "a log above 64K is made of whole 24LC1025s"
+#endif
+
+/** The header is stored as it is in memory */
+typedef char LoggerHeaderCheck[ sizeof(LogBlock) == LOGGER_BLOCK_HEADER ? 1 : -1 ];
+
+#define LOGGER_DATA_SIZE		(LOGGER_BLOCK_SIZE - LOGGER_BLOCK_HEADER)
+
+/** Instance */
+Logger LOGGER = Logger();
+
+/**
+ * CRC of a block: the header up to its crc, then the records
+ */
+static uint16_t blockCrc(const uint8_t *data)
+{
+	uint16_t crc = crc16( data, LOGGER_BLOCK_HEADER - 2 );
+	uint8_t i;
+
+	for(i=LOGGER_BLOCK_HEADER; i < LOGGER_BLOCK_SIZE; i++)
+	{
+		crc = crc16Update( crc, data[i] );
+	}
+	return crc;
+}
+
+/**
+ * Constructor
+ */
+Logger::Logger()
+{
+	pending = false;
+	head = 0;
+	wrapped = false;
+	start = 0;
+	sequence = 0;
+	stored = 0;
+	sent = 0;
+	device = LOGGER_I2C_ADDRESS;
+	state = LOGGER_IDLE;
+	present = false;
+	flushing = false;
+	errors = 0;
+	dropped = 0;
+	cacheBlock = LOGGER_NO_BLOCK;
+	readNext = 0xFFFFFFFF;
+	oldestBlock = LOGGER_NO_BLOCK;
+	beginBlock();
+
+} // end constructor
+
+/**
+ * Finds the newest block.  Blocks hold sequence(0) on up to the newest
+ * and older or blank ones after it, so a binary search finds the end.
+ * Logging goes on in the block after it.  Returns false if there is no
+ * EEPROM.
+ *
+ * Wire must be started (RTC.initialize()) first.
+ */
+boolean Logger::initialize()
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	uint32_t first;
+	uint16_t low, high, mid;
+
+	Wire.beginTransmission( LOGGER_I2C_ADDRESS );
+	present = (Wire.endTransmission() == 0);
+	if( !present )
+	{
+		Serial.println(F("Logger: no EEPROM"));
+		return false;
+	}
+
+	head = 0;
+	wrapped = false;
+	start = 0;
+	pending = false;
+	cacheBlock = LOGGER_NO_BLOCK;
+	oldestBlock = LOGGER_NO_BLOCK;
+	if( loadBlock( 0 ) )
+	{
+		first = header->sequence;
+		low = 0;
+		high = LOGGER_BLOCKS - 1;
+		while( low < high )
+		{
+			mid = low + (high - low + 1) / 2;
+			if( loadBlock( mid ) && header->sequence >= first )
+			{
+				low = mid;
+			}
+			else
+			{
+				high = mid - 1;
+			}
+		}
+		head = (low + 1) % LOGGER_BLOCKS;
+
+		// older records after it; the block right after may be a torn write
+		wrapped = (head == 0) || loadBlock( head ) ||
+				(head + 1 < LOGGER_BLOCKS && loadBlock( head + 1 ));
+		loadBlock( low );
+		start = header->sequence + header->count;
+	}
+	else if( loadBlock( LOGGER_BLOCKS - 1 ) )
+	{
+		// wrapped and block 0 was not finished
+		head = 0;
+		wrapped = true;
+		start = header->sequence + header->count;
+	}
+	sequence = start;
+	stored = start;
+	beginBlock();
+
+	PRINTF( Serial, "Logger: block %u, record %lu\r\n", head, (unsigned long)sequence );
+	return true;
+
+} // end initialize
+
+/**
+ * Adds a record to the open block.  Dropped if the one before it is
+ * still waiting for the block on the bus or a full one to be written.
+ */
+void Logger::add(unsigned long epoch, int16_t temp, int16_t ph, uint16_t errors)
+{
+	if( !present )
+	{
+		return;
+	}
+
+	poll();
+	if( pending )
+	{
+		dropped++;
+		return;
+	}
+
+	waiting.epoch = epoch;
+	waiting.temp = temp;
+	waiting.ph = ph;
+	waiting.errors = errors;
+	pending = true;
+	sequence++;
+	append();
+
+	poll();
+
+} // end add
+
+/**
+ * Moves the write along without waiting; call often
+ */
+void Logger::poll()
+{
+	if( !present || Wire.busy() )
+	{
+		return;
+	}
+
+	switch( state )
+	{
+	case LOGGER_WRITING:
+		if( Wire.result() == 0 )
+		{
+			stored = start + sent;
+			if( cacheBlock == head )
+			{
+				cacheBlock = LOGGER_NO_BLOCK;
+			}
+			if( full )
+			{
+				head = (head + 1) % LOGGER_BLOCKS;
+				wrapped |= (head == 0);
+				start = stored;
+				beginBlock();
+			}
+			flushing = false;
+		}
+		else
+		{
+			// keep the block and try again once the EEPROM answers
+			errors++;
+		}
+		state = LOGGER_PROGRAMMING;
+		append();
+		// fall through
+
+	case LOGGER_PROGRAMMING:
+		// an address-only write is ACKed once the write cycle is over
+		Wire.beginTransmission( device );
+		if( Wire.startTransmission( 0, 0 ) == 0 )
+		{
+			state = LOGGER_PROBING;
+		}
+		break;
+
+	case LOGGER_PROBING:
+		state = (Wire.result() == 0) ? LOGGER_IDLE : LOGGER_PROGRAMMING;
+		break;
+
+	case LOGGER_IDLE:
+		if( full || (flushing && stored != start + encoder.count) )
+		{
+			startWrite();
+		}
+		break;
+	}
+
+} // end poll
+
+/**
+ * Writes the open block without waiting for it to fill, and waits until
+ * every record is in the EEPROM; false if that took too long.  Not for
+ * use while sampling.
+ */
+boolean Logger::flush()
+{
+	unsigned long start = millis();
+
+	do
+	{
+		flushing = (stored != sequence);
+		poll();
+		if( state == LOGGER_IDLE && stored == sequence )
+		{
+			return true;
+		}
+	} while( present && millis() - start < LOGGER_FLUSH_TIMEOUT );
+
+	return false;
+
+} // end flush
+
+/**
+ * Reads a record by its sequence number; false if it is not in the log
+ * or its block is corrupt.  Records of the open block come from RAM, the
+ * rest from the EEPROM, one block at a time, so reading in order costs a
+ * block read per block.  Waits for the bus and the EEPROM, so not for
+ * use while sampling.
+ */
+boolean Logger::read(uint32_t record, LogRecord *out)
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	sample_decoder open;
+	sample_decoder *d = &reader;
+	sample_record r;
+	uint32_t k;
+
+	if( record >= start )
+	{
+		if( record - start >= encoder.count )
+		{
+			return false;
+		}
+		sampleDecoderBegin( &open, block + LOGGER_BLOCK_HEADER, encoder.length );
+		d = &open;
+		k = start;
+	}
+	else
+	{
+		if( record < getOldest() || !loadBlock( findBlock( record ) ) ||
+				record - header->sequence >= header->count )
+		{
+			return false;
+		}
+		if( record < readNext )
+		{
+			sampleDecoderBegin( &reader, cache + LOGGER_BLOCK_HEADER, LOGGER_DATA_SIZE );
+			readNext = header->sequence;
+		}
+		k = readNext;
+	}
+
+	for(;;)
+	{
+		if( sampleDecode( d, &r ) != 1 )
+		{
+			readNext = 0xFFFFFFFF;		// start the block again next time
+			return false;
+		}
+		if( k++ == record )
+		{
+			break;
+		}
+	}
+	if( d == &reader )
+	{
+		readNext = k;
+	}
+
+	out->sequence = record;
+	out->epoch = r.epoch;
+	out->temp = r.temp;
+	out->ph = r.ph;
+	out->errors = r.errors;
+	out->crc = crc16( (const uint8_t *)out, LOGGER_RECORD_SIZE - 2 );
+	return true;
+
+} // end read
+
+/**
+ * First record at or after epoch, or getStored() if there is none.
+ * Assumes the log is in time order; finds the block by its first record
+ * and then reads through it.
+ */
+uint32_t Logger::find(unsigned long epoch)
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	uint16_t first = firstBlock();
+	uint16_t low = 0;
+	uint16_t high = usedBlocks();
+	uint16_t mid;
+	sample_decoder d;
+	sample_record r;
+	uint32_t k;
+
+	// blocks before low start before epoch
+	while( low < high )
+	{
+		mid = low + (high - low) / 2;
+		if( loadBlock( (first + mid) % LOGGER_BLOCKS ) )
+		{
+			sampleDecoderBegin( &d, cache + LOGGER_BLOCK_HEADER, LOGGER_DATA_SIZE );
+			if( sampleDecode( &d, &r ) == 1 && r.epoch >= epoch )
+			{
+				high = mid;
+				continue;
+			}
+		}
+		low = mid + 1;
+	}
+
+	if( low > 0 && loadBlock( (first + low - 1) % LOGGER_BLOCKS ) )
+	{
+		sampleDecoderBegin( &d, cache + LOGGER_BLOCK_HEADER, LOGGER_DATA_SIZE );
+		for(k = header->sequence; sampleDecode( &d, &r ) == 1; k++)
+		{
+			if( r.epoch >= epoch )
+			{
+				return k;
+			}
+		}
+	}
+	if( low < usedBlocks() && loadBlock( (first + low) % LOGGER_BLOCKS ) )
+	{
+		return header->sequence;
+	}
+
+	// the part of the open block that is written
+	sampleDecoderBegin( &d, block + LOGGER_BLOCK_HEADER, encoder.length );
+	for(k = start; k < stored && sampleDecode( &d, &r ) == 1; k++)
+	{
+		if( r.epoch >= epoch )
+		{
+			return k;
+		}
+	}
+	return stored;
+
+} // end find
+
+boolean Logger::isPresent()
+{
+	return present;
+}
+
+uint16_t Logger::getHead()
+{
+	return head;
+}
+
+uint32_t Logger::getSequence()
+{
+	return sequence;
+}
+
+/**
+ * Sequence number of the next record to reach the EEPROM; the ones
+ * before it can be read back
+ */
+uint32_t Logger::getStored()
+{
+	return stored;
+}
+
+/**
+ * Oldest record still in the EEPROM: the first of the block after the
+ * head once the log has wrapped, since the open block replaces the one
+ * at the head
+ */
+uint32_t Logger::getOldest()
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	uint16_t first = firstBlock();
+	uint16_t i;
+
+	if( first != oldestBlock )
+	{
+		oldest = start;
+		for(i=0; i < usedBlocks(); i++)
+		{
+			if( loadBlock( (first + i) % LOGGER_BLOCKS ) )
+			{
+				oldest = header->sequence;
+				oldestBlock = first;
+				break;
+			}
+		}
+	}
+	return oldest;
+
+} // end getOldest
+
+uint16_t Logger::getErrors()
+{
+	return errors;
+}
+
+uint16_t Logger::getDropped()
+{
+	return dropped;
+}
+
+/**
+ * Encodes the waiting record into the open block unless the block is on
+ * the bus; a full block has to be written before the next one starts.
+ */
+void Logger::append()
+{
+	if( !pending || full || state == LOGGER_WRITING )
+	{
+		return;
+	}
+	if( sampleEncode( &encoder, &waiting ) )
+	{
+		pending = false;
+	}
+	else
+	{
+		full = true;
+	}
+
+} // end append
+
+/**
+ * Empties the open block; unused bytes stay blank, which the decoder
+ * reads as the end of the block
+ */
+void Logger::beginBlock()
+{
+	memset( block, 0xFF, sizeof(block) );
+	sampleEncoderBegin( &encoder, block + LOGGER_BLOCK_HEADER, LOGGER_DATA_SIZE, 0 );
+	full = false;
+
+} // end beginBlock
+
+/**
+ * Sends the open block to its place in one burst: the two address bytes
+ * go through the Wire buffer and the block follows straight from RAM, so
+ * a whole block fits in one write.
+ */
+boolean Logger::startWrite()
+{
+	LogBlock *header = (LogBlock *)block;
+	uint32_t address = (uint32_t)head * LOGGER_BLOCK_SIZE;
+
+	header->sequence = start;
+	header->count = encoder.count;
+	header->crc = blockCrc( block );
+
+	device = LOGGER_DEVICE(address);
+	Wire.beginTransmission( device );
+	Wire.send( (uint8_t)(address >> 8) );
+	Wire.send( (uint8_t)address );
+	if( Wire.startTransmission( block, LOGGER_BLOCK_SIZE ) != 0 )
+	{
+		return false;
+	}
+	sent = encoder.count;
+	state = LOGGER_WRITING;
+	return true;
+
+} // end startWrite
+
+/**
+ * Reads a block into the cache; false if it is blank or corrupt
+ */
+boolean Logger::loadBlock(uint16_t index)
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	uint32_t address = (uint32_t)index * LOGGER_BLOCK_SIZE;
+	uint8_t i;
+
+	if( index == cacheBlock )
+	{
+		return true;
+	}
+
+	cacheBlock = LOGGER_NO_BLOCK;
+	readNext = 0xFFFFFFFF;
+	for(i=0; i < LOGGER_BLOCK_SIZE; i += BUFFER_LENGTH)
+	{
+		if( !readBytes( address + i, cache + i, min( LOGGER_BLOCK_SIZE - i, BUFFER_LENGTH ) ) )
+		{
+			return false;
+		}
+	}
+	if( header->count == 0 || header->crc != blockCrc( cache ) )
+	{
+		return false;
+	}
+	cacheBlock = index;
+	return true;
+
+} // end loadBlock
+
+/**
+ * Block a stored record should be in: the cached block or the one after
+ * it when reading in order, otherwise a binary search on the block
+ * sequence numbers
+ */
+uint16_t Logger::findBlock(uint32_t record)
+{
+	const LogBlock *header = (const LogBlock *)cache;
+	uint16_t first = firstBlock();
+	uint16_t low = 0;
+	uint16_t high = usedBlocks() - 1;
+	uint16_t mid;
+
+	if( cacheBlock != LOGGER_NO_BLOCK && record >= header->sequence )
+	{
+		if( record - header->sequence < header->count )
+		{
+			return cacheBlock;
+		}
+		if( record - header->sequence == header->count )
+		{
+			return (cacheBlock + 1) % LOGGER_BLOCKS;
+		}
+	}
+
+	while( low < high )
+	{
+		mid = low + (high - low + 1) / 2;
+		if( loadBlock( (first + mid) % LOGGER_BLOCKS ) && header->sequence > record )
+		{
+			high = mid - 1;
+		}
+		else
+		{
+			low = mid;
+		}
+	}
+	return (first + low) % LOGGER_BLOCKS;
+
+} // end findBlock
+
+/**
+ * Oldest block that is not the open one
+ */
+uint16_t Logger::firstBlock()
+{
+	return wrapped ? (head + 1) % LOGGER_BLOCKS : 0;
+}
+
+/**
+ * Written blocks before the open one
+ */
+uint16_t Logger::usedBlocks()
+{
+	return wrapped ? LOGGER_BLOCKS - 1 : head;
+}
+
+/**
+ * Reads length (up to BUFFER_LENGTH) bytes from address, retrying while
+ * the EEPROM is busy with a write cycle
+ */
+boolean Logger::readBytes(uint32_t address, uint8_t *data, uint8_t length)
+{
+	unsigned long start = millis();
+	uint8_t i;
+
+	// let a block write finish first
+	while( state != LOGGER_IDLE && millis() - start < LOGGER_READ_TIMEOUT )
+	{
+		poll();
+	}
+
+	do
+	{
+		Wire.beginTransmission( LOGGER_DEVICE(address) );
+		Wire.send( (uint8_t)(address >> 8) );
+		Wire.send( (uint8_t)address );
+		if( Wire.endTransmission() == 0 )
+		{
+			if( Wire.requestFrom( LOGGER_DEVICE(address), length ) != length )
+			{
+				return false;
+			}
+			for(i=0; i < length; i++)
+			{
+				data[i] = Wire.receive();
+			}
+			return true;
+		}
+	} while( millis() - start < LOGGER_READ_TIMEOUT );
+
+	return false;
+
+} // end readBytes
@@ -0,0 +1,139 @@
+/*
+ * Logger.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <WProgram.h>
+#include "SampleCodec.h"
+
+/**
+ * Sample log in 24LCxx serial EEPROMs, written as a circular buffer of
+ * blocks.  Each block is a LogBlock header followed by records delta
+ * coded with the sample codec (SampleCodec.h), about a byte a record
+ * while only the pH moves.  The open block is built in RAM and sent in
+ * one page-aligned burst straight from there, and the end of the
+ * EEPROM's write cycle is found by polling for its ACK between samples,
+ * so add() and poll() never wait on the device.  The newest block is
+ * found again at start up from the block sequence numbers.
+ *
+ * The records of the open block are only in RAM until it fills, a
+ * minute or so; flush() writes it early and waits for it, and the block
+ * is written again in full once it fills.
+ *
+ * Capacity at one record a second with the pH moving on every one: a
+ * 24LC256 holds about six hours, a 24LC1025 a day, and four 24LC1025s
+ * (LOGGER_SIZE 524288UL) four days; steady readings go much further.
+ */
+#define LOGGER_I2C_ADDRESS		0x50
+#define LOGGER_SIZE				32768UL		// 24LC256
+#define LOGGER_PAGE_SIZE		64			// 128 for a 24LC512 or 24LC1025
+#define LOGGER_BLOCK_SIZE		64
+#define LOGGER_BLOCK_HEADER		8
+#define LOGGER_BLOCKS			(uint16_t)(LOGGER_SIZE / LOGGER_BLOCK_SIZE)
+#define LOGGER_NO_BLOCK			0xFFFF
+#define LOGGER_RECORD_SIZE		16
+#define LOGGER_READ_TIMEOUT		10			// ms; longer than a write cycle
+#define LOGGER_FLUSH_TIMEOUT	50			// ms; two blocks on the bus and their write cycles
+
+/**
+ * I2C address for a log address.  Parts above 64K take the top address
+ * bits in the device address: a 24LC1025's block select B0 is bit 2, and
+ * up to four of them on the bus are told apart by A0 and A1.
+ */
+#define LOGGER_DEVICE(address)	(uint8_t)(LOGGER_I2C_ADDRESS | (((address) >> 14) & 0x04) | ((address) >> 17))
+
+/** States */
+#define LOGGER_IDLE				0
+#define LOGGER_WRITING			1	// block on the bus
+#define LOGGER_PROGRAMMING		2	// EEPROM write cycle, poll for ACK
+#define LOGGER_PROBING			3	// ACK poll on the bus
+
+/** Block header; the crc covers the rest of the block */
+struct LogBlock
+{
+	uint32_t sequence;		// of the first record
+	uint16_t count;			// records in the block
+	uint16_t crc;
+};
+
+/** A record as read back, laid out for the export (TelemetryFrame.h) */
+struct LogRecord
+{
+	uint32_t sequence;
+	uint32_t epoch;			// seconds since 2000
+	int16_t temp;			// hundredths of a degree F
+	int16_t ph;				// hundredths of pH
+	uint16_t errors;		// failed pH samples since power up
+	uint16_t crc;			// of the bytes before it
+};
+
+class Logger
+{
+public:
+	Logger();
+	boolean initialize();
+	void add(unsigned long epoch, int16_t temp, int16_t ph, uint16_t errors);
+	void poll();
+	boolean flush();
+	boolean read(uint32_t record, LogRecord *out);
+	uint32_t find(unsigned long epoch);
+	boolean isPresent();
+	uint16_t getHead();
+	uint32_t getSequence();
+	uint32_t getStored();
+	uint32_t getOldest();
+	uint16_t getErrors();
+	uint16_t getDropped();
+
+private:
+	uint8_t block[LOGGER_BLOCK_SIZE];	// the open block
+	sample_encoder encoder;
+	sample_record waiting;	// record not yet in the block
+	boolean pending;		// waiting holds a record
+	boolean full;			// the open block takes no more; write it and move on
+	uint16_t head;			// block the open one goes to
+	boolean wrapped;		// the blocks after the head hold older records
+	uint32_t start;			// sequence of the open block's first record
+	uint32_t sequence;		// of the next record
+	uint32_t stored;		// records before this are in the EEPROM
+	uint16_t sent;			// records in the block on the bus
+	uint8_t device;			// I2C address the block went to
+	uint8_t state;
+	boolean present;
+	boolean flushing;
+	uint16_t errors;
+	uint16_t dropped;
+
+	uint8_t cache[LOGGER_BLOCK_SIZE];	// a block read back
+	uint16_t cacheBlock;
+	sample_decoder reader;
+	uint32_t readNext;		// record the reader is at
+	uint16_t oldestBlock;	// block oldest was read from
+	uint32_t oldest;
+
+	void append();
+	void beginBlock();
+	boolean startWrite();
+	boolean loadBlock(uint16_t index);
+	uint16_t findBlock(uint32_t record);
+	uint16_t firstBlock();
+	uint16_t usedBlocks();
+	boolean readBytes(uint32_t address, uint8_t *data, uint8_t length);
+
+};
+
+extern Logger LOGGER;
+
+#endif /* LOGGER_H_ */
@@ -15,6 +15,7 @@
  */
 
 #include "PhStamp.h"
+#include "Config.h"
 
 /** Create instance of class */
 PhStamp PH = PhStamp();
@@ -29,9 +30,13 @@ PhStamp::PhStamp()
 	errors = 0;
 
 	index = 0;
+	sampleSize = PH_SAMPLE_SIZE;
 	averageSample = 0;
 	currentSample = 0;
+	sampleSum = 0;
 	filled = false;
+	receiving = false;
+	received = 0;
 
 } // end constructor
 
@@ -40,30 +45,29 @@ PhStamp::PhStamp()
  */
 void PhStamp::initialize()
 {
-	Serial.println("pH probe: initializing...");
+	Serial.println(F("pH probe: initializing..."));
 
 	// Select the serial port for listening
 	phProbe.listen();
 
 	// Initialize serial
-	phProbe.begin(PH_BAUD_RATE);
+	phProbe.begin(CONFIG.data.phBaud);
 
 	// Turn on LED
-	phProbe.print(PH_CMD_ENABLE_LED);
+	phProbe.print(F(PH_CMD_ENABLE_LED));
 	delay(1000); // delay 1 second - from website; don't know why
 
-	Serial.println("pH probe: initialization complete");
+	Serial.println(F("pH probe: initialization complete"));
 
 } // end initialize
 
 
 /**
- * Samples pH
+ * Samples pH.  The temperature and the result are in hundredths.
  */
-void PhStamp::sample(double temp)
+void PhStamp::sample(int16_t temp)
 {
-	uint8_t holding = 0;
-	uint8_t i = 0;
+	int16_t value;
 
 //	Serial.println("\nListening to pH Serial port");
 
@@ -71,39 +75,38 @@ void PhStamp::sample(double temp)
 	phProbe.listen();
 
 	// Send current temp
-	phProbe.print( temp, 2);
-	phProbe.print("\r");
+	phProbe.printFixed( temp, 2 );
+	phProbe.print(F("\r"));
 
 	// Ask for a single sample
 //	Serial.print("Asking for sample: ");
 //	Serial.println( samples, DEC );
 
-	phProbe.print("r\r");
+	phProbe.print(F(PH_CMD_SINGLE_SAMPLE));
 	samples++;
 
-	// per datasheet, 410ms delay w/ LED; 110ms w/o LED
-	delay(500); // delay for processing and to send data (per datasheet)
-
-	if( phProbe.available() > 3 )
+	// per datasheet, 410ms delay w/ LED; 110ms w/o LED.  Commands, the
+	// log and the export carry on until PH_REPLY_QUIET; after that nothing
+	// else runs until the reply is in, so the SoftwareSerial receive is
+	// never held off.
+	received = 0;
+	delay( PH_REPLY_QUIET );
+	receiving = true;
+	waitFor( replyReceived, PH_REPLY_TIMEOUT - PH_REPLY_QUIET );
+	receiving = false;
+	phProbeBuffer[received] = 0;
+	phProbe.flush();
+
+	if( received > 3 )
 	{
-		holding = phProbe.available();
-//		Serial.print("Sample Received.  Bytes available: ");
-//		Serial.println(holding, DEC);
-
-		for(i=0; i < holding; i++)
+		if( !parseValue( (char *)&phProbeBuffer, &value ) )
 		{
-			//Read data from serial buffer
-			phProbeBuffer[i]= phProbe.read();
-			if(phProbeBuffer[i] == 0x0d )
-			{
-				phProbeBuffer[i] = 0;
-			}
+			errors++;
+			PRINTF( Serial, "** Error in Sample %u, Error %u: bad reading\r\n",
+					samples, errors );
+			return;
 		}
-
-		// TODO: Need to provide some checks here before calling
-		currentSample = atof((char *)&phProbeBuffer);
-
-		// TODO: Ensure to ensure atof returned a real value
+		currentSample = value + CONFIG.data.phOffset;
 
 
 		// Print sample
@@ -113,30 +116,35 @@ void PhStamp::sample(double temp)
 //		Serial.println( (char *)&phProbeBuffer );
 //		Serial.println( currentSample, 2 );
 
-		// Compute average value
+		// Start the average over if the window size was changed
+		if( sampleSize != CONFIG.data.phSamples )
+		{
+			sampleSize = CONFIG.data.phSamples;
+			index = 0;
+			sampleSum = 0;
+			filled = false;
+		}
+
+		// Compute average value; keep a running sum instead of re-adding
+		// the whole list
+		if( filled )
+		{
+			sampleSum -= sampleList[index];
+		}
 		sampleList[index++] = currentSample;
-		averageSample = 0;
+		sampleSum += currentSample;
 		if( filled )
 		{
-			// Compute new average
-			for(int i=0; i<PH_SAMPLE_SIZE; i++)
-			{
-				averageSample += sampleList[i];
-			}
-			averageSample /= PH_SAMPLE_SIZE;
+			averageSample = sampleSum / sampleSize;
 		}
 		else
 		{
-			for(int i=0; i<index; i++)
-			{
-				averageSample += sampleList[i];
-			}
-			averageSample /= index;
+			averageSample = sampleSum / index;
 		}
 //		Serial.print("pH: ");
 //		Serial.println( averageSample, 2 );
 
-		if( index == PH_SAMPLE_SIZE )
+		if( index == sampleSize )
 		{
 			index = 0;
 			filled = true;
@@ -146,30 +154,184 @@ void PhStamp::sample(double temp)
 	else
 	{
 		errors++;
-		Serial.print("** Error in Sample ");
-		Serial.print( samples, DEC );
-		Serial.print(", Error ");
-		Serial.print( errors, DEC );
-		Serial.print(": bytes available - ");
-		Serial.println(phProbe.available(), DEC);
+		PRINTF( Serial, "** Error in Sample %u, Error %u: bytes available - %d\r\n",
+				samples, errors, received );
 	}
 
-}
+} // end sample
+
+/**
+ * waitFor() test for the reply: moves it into the buffer as it arrives
+ * and is done at the CR that ends it, or when the buffer is full.  The
+ * CR becomes the terminator; any bytes beyond are dropped.
+ */
+boolean PhStamp::replyReceived()
+{
+	int c;
+
+	while( (c = PH.phProbe.read()) >= 0 )
+	{
+		PH.phProbeBuffer[PH.received++] = (c == 0x0d) ? 0 : c;
+		if( c == 0x0d || PH.received == PH_BUFFER_SIZE - 1 )
+		{
+			return true;
+		}
+	}
+	return false;
+
+} // end replyReceived
+
+/**
+ * Parses a stamp reading such as "7.23" into hundredths.  Extra decimals
+ * are truncated.  Returns false if the string holds no digits or
+ * anything other than a single decimal number.
+ */
+boolean PhStamp::parseValue(const char *s, int16_t *value)
+{
+	int32_t v = 0;
+	int8_t decimals = -1;
+	boolean digits = false;
+
+	for( ; *s; s++ )
+	{
+		if( *s >= '0' && *s <= '9' )
+		{
+			digits = true;
+			if( decimals < 2 )
+			{
+				if( v > 32767 )
+				{
+					return false;
+				}
+				v = v*10 + (*s - '0');
+				if( decimals >= 0 )
+				{
+					decimals++;
+				}
+			}
+		}
+		else if( *s == '.' && decimals < 0 )
+		{
+			decimals = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	if( !digits )
+	{
+		return false;
+	}
+
+	// Scale to hundredths
+	if( decimals < 0 )
+	{
+		decimals = 0;
+	}
+	while( decimals++ < 2 )
+	{
+		v *= 10;
+	}
+	if( v > 32767 )
+	{
+		return false;
+	}
+	*value = v;
+	return true;
+
+} // end parseValue
 
 char *PhStamp::getBuffer()
 {
 	return (char *)&phProbeBuffer;
 }
 
-
-double PhStamp::getLastValue()
+/**
+ * Returns the last pH sampled, in hundredths
+ */
+int16_t PhStamp::getLastValue()
 {
 	return currentSample;
 }
 
-double PhStamp::getAverageValue()
+/**
+ * Returns the average pH over the last PH_SAMPLE_SIZE, in hundredths
+ */
+int16_t PhStamp::getAverageValue()
 {
 	return averageSample;
 }
 
- // end sample
+/**
+ * Returns the number of failed samples since power up
+ */
+uint16_t PhStamp::getErrors()
+{
+	return errors;
+}
+
+/**
+ * True while sample() waits for the stamp's reply to come in
+ */
+boolean PhStamp::isReceiving()
+{
+	return receiving;
+}
+
+/**
+ * Copies the counters and averaging filter into PH_STATE_SIZE bytes
+ */
+void PhStamp::saveState(uint8_t *state)
+{
+	*state++ = samples;
+	*state++ = samples >> 8;
+	*state++ = errors;
+	*state++ = errors >> 8;
+	*state++ = sampleSize;
+	*state++ = index;
+	*state++ = filled;
+	for(uint8_t i=0; i<PH_SAMPLE_SIZE; i++)
+	{
+		*state++ = sampleList[i];
+		*state++ = sampleList[i] >> 8;
+	}
+
+} // end saveState
+
+/**
+ * Reloads the counters and averaging filter from saveState() output.
+ * Returns false, leaving everything alone, if the state makes no sense
+ * or was saved with another window size.
+ */
+boolean PhStamp::restoreState(const uint8_t *state)
+{
+	uint8_t count;
+
+	if( state[4] != CONFIG.data.phSamples || state[5] >= state[4] ||
+			state[6] > 1 || (!state[6] && !state[5]) )
+	{
+		return false;
+	}
+	samples = state[0] | (state[1] << 8);
+	errors = state[2] | (state[3] << 8);
+	sampleSize = state[4];
+	index = state[5];
+	filled = state[6];
+	state += 7;
+
+	sampleSum = 0;
+	for(uint8_t i=0; i<PH_SAMPLE_SIZE; i++, state += 2)
+	{
+		sampleList[i] = state[0] | (state[1] << 8);
+	}
+	count = filled ? sampleSize : index;
+	for(uint8_t i=0; i<count; i++)
+	{
+		sampleSum += sampleList[i];
+	}
+	averageSample = sampleSum / count;
+	currentSample = sampleList[ (index + sampleSize - 1) % sampleSize ];
+	return true;
+
+} // end restoreState
@@ -33,33 +33,56 @@
 #define PH_CMD_ENABLE_LED "l1\r"
 #define PH_CMD_DISABLE_LED "l0\r"
 
-#define PH_SAMPLE_SIZE 	5
+#define PH_SAMPLE_SIZE 	5		// largest averaging window; CONFIG picks the size
+#define PH_BUFFER_SIZE	15
+
+/**
+ * Reply timing, in ms.  With its LED on the stamp answers about 410ms
+ * after "r".  The yield hook may run for the first PH_REPLY_QUIET ms,
+ * which leaves its longest job (the k command's EEPROM writes, about
+ * 80ms) time to finish before the first byte arrives.
+ */
+#define PH_REPLY_QUIET	250
+#define PH_REPLY_TIMEOUT	500
+
+/** Bytes used by saveState(): counters, size, index, filled and the sample list */
+#define PH_STATE_SIZE	(7 + 2*PH_SAMPLE_SIZE)
 
 class PhStamp
 {
 public:
 	PhStamp();
 	void initialize();
-	void sample(double temp);
+	void sample(int16_t temp);
 	char* getBuffer();
-	double getLastValue();
-	double getAverageValue();
+	int16_t getLastValue();
+	int16_t getAverageValue();
+	uint16_t getErrors();
+	boolean isReceiving();
+	void saveState(uint8_t *state);
+	boolean restoreState(const uint8_t *state);
 
 
 private:
 	TwoWire test;
 	SoftwareSerial phProbe;
-	uint8_t phProbeBuffer[15];
+	uint8_t phProbeBuffer[PH_BUFFER_SIZE];
 
 	volatile uint16_t samples;
 	volatile uint16_t errors;
 
 	volatile uint8_t index;
-	volatile double sampleList[PH_SAMPLE_SIZE];
-	volatile double currentSample;
-	volatile double averageSample;
+	volatile uint8_t sampleSize;
+	volatile int16_t sampleList[PH_SAMPLE_SIZE];
+	volatile int16_t currentSample;
+	volatile int16_t averageSample;
+	volatile int32_t sampleSum;
 	volatile boolean filled;
+	boolean receiving;
+	uint8_t received;
 
+	static boolean replyReceived();
+	boolean parseValue(const char *s, int16_t *value);
 
 };
 
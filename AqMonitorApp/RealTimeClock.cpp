@@ -27,6 +27,7 @@
  * Includes
  ******************************************************************************/
 
+#include <avr/pgmspace.h>
 #include "RealTimeClock.h"
 
 /******************************************************************************
@@ -35,6 +36,46 @@
 
 #define DS1307_I2C_ADDRESS 0x68  // This is the I2C address
 
+//days before the first of each month in a non-leap year
+static const uint16_t daysBeforeMonth[12] PROGMEM = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+//every year from 2000 through 2099 divisible by 4 is a leap year
+static unsigned int daysInMonth(int year, int month)
+{
+  if (month == 12) { return 31; }
+  return pgm_read_word(&daysBeforeMonth[month]) - pgm_read_word(&daysBeforeMonth[month - 1])
+      + (month == 2 && (year & 3) == 0);
+}
+
+//year 0-99, month 1-12, date 1-31
+static unsigned int daysSince2000(int year, int month, int date)
+{
+  unsigned int days = year * 365 + (year + 3) / 4;
+  days += pgm_read_word(&daysBeforeMonth[month - 1]);
+  if (month > 2 && (year & 3) == 0)
+  {
+    days++;
+  }
+  return days + date - 1;
+}
+
+//reads an unsigned number of up to maxDigits digits; returns the
+//position after it, or NULL if there were no digits
+static const char *parseField(const char *s, int maxDigits, int *value)
+{
+  int n = 0;
+  int digits = 0;
+  while (*s >= '0' && *s <= '9' && digits < maxDigits)
+  {
+    n = n * 10 + (*s++ - '0');
+    digits++;
+  }
+  *value = n;
+  return digits ? s : NULL;
+}
+
 /******************************************************************************
  * Constructors
  ******************************************************************************/
@@ -93,13 +134,22 @@ void RealTimeClock::readClock()
  */
 void RealTimeClock::setClock()
 {
-  //to be paranoid, we're going to first stop the clock
-  //to ensure we don't have rollovers while we're
-  //writing:
-  writeData(0,0x80);
-  //now, we'll write everything *except* the second
+  setAll();
+}
+
+/**
+ * Writes all time and date registers in a single transaction
+ */
+void RealTimeClock::setAll()
+{
+  //"The countdown chain is reset whenever the seconds register is
+  //written ... the remaining time and date registers must be written
+  //within one second." A burst starting at register 0 does exactly
+  //that, so there is no need to halt the oscillator first. The CH bit
+  //goes out with the seconds as _reg0_sec has it.
   Wire.beginTransmission(DS1307_I2C_ADDRESS);
-  Wire.send(0x01);
+  Wire.send(0x00);
+  Wire.send(_reg0_sec);
   Wire.send(_reg1_min);
   Wire.send(_reg2_hour);
   Wire.send(_reg3_day);
@@ -107,11 +157,6 @@ void RealTimeClock::setClock()
   Wire.send(_reg5_month);
   Wire.send(_reg6_year);
   Wire.endTransmission();
-  //now, we'll write the seconds; we didn't have to keep
-  //track of whether the clock was already running, because
-  //_reg0_sec already knows what we want it to be. This
-  //will restart the clock as it writes the new seconds value.
-  writeData(0,_reg0_sec);
 }
 
 /**
@@ -154,14 +199,22 @@ void RealTimeClock::writeData(byte regNo, byte value)
 void RealTimeClock::writeData(byte regNo, void * source, int length)
 {
   char * p = (char*) source;
+  int n;
   if(regNo > 0x3F || length > 0x3F) { return; }
-  Wire.beginTransmission(DS1307_I2C_ADDRESS);
-  Wire.send(regNo);
-  for(int i=0; i<length; i++) {
-    Wire.send(*p);
-    p++;
+  //the Wire buffer holds the register number plus BUFFER_LENGTH-1 bytes,
+  //so longer writes go out as several transactions
+  while(length > 0) {
+    n = length < BUFFER_LENGTH - 1 ? length : BUFFER_LENGTH - 1;
+    Wire.beginTransmission(DS1307_I2C_ADDRESS);
+    Wire.send(regNo);
+    for(int i=0; i<n; i++) {
+      Wire.send(*p);
+      p++;
+    }
+    Wire.endTransmission();
+    regNo += n;
+    length -= n;
   }
-  Wire.endTransmission();
 }
 
 /**
@@ -183,14 +236,21 @@ byte RealTimeClock::readData(byte regNo)
 void RealTimeClock::readData(byte regNo, void * dest, int length)
 {
   char * p = (char*) dest;
+  int n;
   if(regNo > 0x3F || length > 0x3F) { return; }
-  Wire.beginTransmission(DS1307_I2C_ADDRESS);
-  Wire.send(regNo);
-  Wire.endTransmission();
-  Wire.requestFrom(DS1307_I2C_ADDRESS, length);
-  for(int i=0; i<length; i++) {
-    *p=Wire.receive();
-    p++;
+  //requestFrom() is capped at BUFFER_LENGTH bytes
+  while(length > 0) {
+    n = length < BUFFER_LENGTH ? length : BUFFER_LENGTH;
+    Wire.beginTransmission(DS1307_I2C_ADDRESS);
+    Wire.send(regNo);
+    Wire.endTransmission();
+    Wire.requestFrom(DS1307_I2C_ADDRESS, n);
+    for(int i=0; i<n; i++) {
+      *p=Wire.receive();
+      p++;
+    }
+    regNo += n;
+    length -= n;
   }
 }
 
@@ -263,6 +323,14 @@ int RealTimeClock::getHours()
   //bits 4-5 are tens of hours
   return bcdToDec(_reg2_hour & 0x3f);
 }
+int RealTimeClock::getHours24()
+{
+  if(is12hour()) {
+    //12 AM is hour 0, 12 PM is hour 12
+    return getHours() % 12 + (isPM() ? 12 : 0);
+  }
+  return getHours();
+}
 int RealTimeClock::getMinutes()
 {
   //could mask with 0x7f but shouldn't need to
@@ -293,6 +361,18 @@ int RealTimeClock::getDayOfWeek()
   return bcdToDec(_reg3_day);
 }
 
+unsigned long RealTimeClock::getEpoch()
+{
+  int month = getMonth();
+
+  if (month < 1 || month > 12)
+  {
+    month = 1;
+  }
+  return ((daysSince2000(getYear(), month, getDate()) * 24UL + getHours24()) * 60
+      + getMinutes()) * 60 + getSeconds();
+}
+
 void RealTimeClock::getFormatted(char * buffer)
 {
   int i=0;
@@ -449,18 +529,92 @@ void RealTimeClock::setYear(int y)
 
 
 
+void RealTimeClock::setEpoch(unsigned long epoch)
+{
+  unsigned int days = epoch / 86400UL;
+  unsigned long rest = epoch - days * 86400UL;
+  int year = 0;
+  int month = 1;
+  unsigned int length;
+
+  while (days >= (length = (year & 3) ? 365 : 366))
+  {
+    days -= length;
+    year++;
+  }
+  while (days >= (length = daysInMonth(year, month)))
+  {
+    days -= length;
+    month++;
+  }
+  setFields(year, month, days + 1, rest / 3600, (rest / 60) % 60, rest % 60);
+}
+
+boolean RealTimeClock::setTimestamp(const char *s)
+{
+  int year, month, date, hour, minute, second = 0;
+
+  if ((s = parseField(s, 4, &year)) == NULL || *s++ != '-' ||
+      (s = parseField(s, 2, &month)) == NULL || *s++ != '-' ||
+      (s = parseField(s, 2, &date)) == NULL || (*s != 'T' && *s != ' ') ||
+      (s = parseField(s + 1, 2, &hour)) == NULL || *s++ != ':' ||
+      (s = parseField(s, 2, &minute)) == NULL)
+  {
+    return false;
+  }
+  if (*s == ':' && (s = parseField(s + 1, 2, &second)) == NULL)
+  {
+    return false;
+  }
+  if (*s != 0 || year < 2000 || year > 2099 || month < 1 || month > 12 ||
+      date < 1 || date > (int)daysInMonth(year - 2000, month) ||
+      hour > 23 || minute > 59 || second > 59)
+  {
+    return false;
+  }
+  setFields(year - 2000, month, date, hour, minute, second);
+  return true;
+}
+
+
+
 /*****************************************
  * Private methods
  *****************************************/
+
+//year 0-99, hour 0-23; writes the clock
+void RealTimeClock::setFields(int year, int month, int date, int hour, int minute, int second)
+{
+  _reg0_sec = decToBcd(second) | (_reg0_sec & 0x80);
+  _reg1_min = decToBcd(minute);
+  if (is12hour())
+  {
+    //keep 12-hour mode: hours 1-12 plus the PM bit
+    _reg2_hour = 0x40 | (hour >= 12 ? 0x20 : 0) | decToBcd(hour % 12 == 0 ? 12 : hour % 12);
+  }
+  else
+  {
+    _reg2_hour = decToBcd(hour);
+  }
+  //2000-01-01 was a Saturday, day 7
+  _reg3_day = (daysSince2000(year, month, date) + 6) % 7 + 1;
+  _reg4_date = decToBcd(date);
+  _reg5_month = decToBcd(month);
+  _reg6_year = decToBcd(year);
+  setAll();
+}
+
+//b is 0-99. (b * 103) >> 10 is b / 10 over that range without a divide,
+//and each ten needs 6 added to land in the high nybble
 byte RealTimeClock::decToBcd(byte b)
 {
-  return ( ((b/10) << 4) + (b%10) );
+  return b + 6 * (((uint16_t)b * 103) >> 10);
 }
 
 // Convert binary coded decimal to normal decimal numbers
 byte RealTimeClock::bcdToDec(byte b)
 {
-  return ( ((b >> 4)*10) + (b%16) );
+  return b - 6 * (b >> 4);
 }
 
 char RealTimeClock::lowNybbleToASCII(byte b)
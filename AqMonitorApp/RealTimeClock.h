@@ -36,6 +36,10 @@
 
 #define ARDUINO_PIN_T uint8_t
 
+//battery backed RAM following the clock registers
+#define DS1307_NVRAM_START 0x08
+#define DS1307_NVRAM_SIZE 56
+
 class RealTimeClock
 {
   private:
@@ -49,6 +53,7 @@ class RealTimeClock
     byte _reg7_sqw;
     byte decToBcd(byte);
     byte bcdToDec(byte);
+    void setFields(int year, int month, int date, int hour, int minute, int second);
     char lowNybbleToASCII(byte);
     char highNybbleToASCII(byte);
 
@@ -56,7 +61,8 @@ class RealTimeClock
     RealTimeClock();
     void initialize();
     void readClock();//read registers (incl sqw) to local store
-    void setClock();//update clock registers from local store
+    void setClock();//update clock registers from local store; same as setAll()
+    void setAll();//write registers 0-6 from local store in one burst
     void stop();//immediate; does not require setClock();
     void start();//immediate; does not require setClock();
     void sqwEnable(byte);//enable the square wave with the specified frequency
@@ -67,12 +73,15 @@ class RealTimeClock
     void readData(byte, void *, int);//read several values into a buffer
 
     int getHours();
+    int getHours24();//0-23 regardless of 12/24 mode
     int getMinutes();
     int getSeconds();
     int getYear();
     int getMonth();
     int getDate();
     int getDayOfWeek();
+    //seconds since 2000-01-01 00:00:00, from the local store
+    unsigned long getEpoch();
     boolean is12hour();
     boolean isPM();
     boolean isStopped();
@@ -99,6 +108,14 @@ class RealTimeClock
     void setMonth(int);
     void setYear(int);
 
+    //these write the clock straight away, no setClock() needed. The
+    //12/24 mode and the oscillator bit are kept; the day of week is set
+    //to 1 for Sunday through 7 for Saturday.
+    void setEpoch(unsigned long);//seconds since 2000-01-01 00:00:00
+    //"YYYY-MM-DD HH:MM:SS" or with a 'T' between date and time; seconds
+    //are optional. Returns false, leaving the clock alone, if invalid.
+    boolean setTimestamp(const char *);
+
     //squarewave frequencies:
     static const byte SQW_1Hz=0x00;
     static const byte SQW_4kHz=0x01;//actually 4.096kHz
@@ -0,0 +1,325 @@
+/*
+ * SampleCodec.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef SAMPLECODEC_H_
+#define SAMPLECODEC_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Compact encoding of sample records for the telemetry stream and logs.
+ * Plain C so the host tools share it.
+ *
+ * A block is a series of tagged entries; each one after a keyframe is
+ * relative to the record before it:
+ *
+ *   0x00-0x3F  run: 1-64 records with the same values, the epoch moving
+ *              on by the current step each time
+ *   0x40-0x4F  delta: the low bits say which zigzag varints follow, in
+ *              this order: STEP (new epoch step, applied now), TEMP, PH,
+ *              ERRORS.  Fields not present are unchanged.
+ *   0x50-0x5F  small pH delta: the pH moves by the low bits - 8 (-8..+7)
+ *              and the epoch by the current step, the rest unchanged
+ *   0x80       keyframe: epoch(4) temp(2) ph(2) errors(2), little endian;
+ *              the step goes back to 1
+ *   0xFF       end of block (blank EEPROM)
+ *
+ * Every block starts with a keyframe, so each can be decoded on its own;
+ * the encoder can also put keyframes inside long blocks.  Readings are
+ * kept in hundredths, so no precision is lost.
+ */
+#define SAMPLE_CODEC_RUN			0x00
+#define SAMPLE_CODEC_RUN_MAX		64
+#define SAMPLE_CODEC_DELTA			0x40
+#define SAMPLE_CODEC_STEP			0x01
+#define SAMPLE_CODEC_TEMP			0x02
+#define SAMPLE_CODEC_PH				0x04
+#define SAMPLE_CODEC_ERRORS			0x08
+#define SAMPLE_CODEC_PH_SMALL		0x50
+#define SAMPLE_CODEC_KEY			0x80
+#define SAMPLE_CODEC_KEY_SIZE		11
+#define SAMPLE_CODEC_END			0xFF
+
+/** Largest entry: tag, 5 byte step, three 3 byte deltas */
+#define SAMPLE_CODEC_MAX_ENTRY		15
+
+struct sample_record
+{
+	uint32_t epoch;			// seconds since 2000
+	int16_t temp;			// hundredths of a degree F
+	int16_t ph;				// hundredths of pH
+	uint16_t errors;
+};
+
+struct sample_encoder
+{
+	struct sample_record last;
+	uint32_t step;
+	uint8_t *buffer;
+	uint16_t size;
+	uint16_t length;
+	uint16_t run;			// offset of the open run tag + 1, 0 if none
+	uint16_t count;			// records in the block
+	uint8_t keyInterval;	// records between keyframes, 0 for block start only
+	uint8_t sinceKey;
+};
+
+struct sample_decoder
+{
+	struct sample_record last;
+	uint32_t step;
+	const uint8_t *data;
+	uint16_t length;
+	uint16_t pos;
+	uint8_t run;			// records left in the current run
+};
+
+static inline uint8_t samplePutVarint(uint8_t *out, uint32_t value)
+{
+	uint8_t n = 0;
+
+	while( value >= 0x80 )
+	{
+		out[n++] = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	out[n++] = value;
+	return n;
+}
+
+static inline uint32_t sampleZigzag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t sampleUnzigzag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * Starts a block in buffer
+ */
+static inline void sampleEncoderBegin(struct sample_encoder *e, uint8_t *buffer, uint16_t size, uint8_t keyInterval)
+{
+	e->buffer = buffer;
+	e->size = size;
+	e->length = 0;
+	e->run = 0;
+	e->count = 0;
+	e->keyInterval = keyInterval;
+	e->sinceKey = 0;
+}
+
+/**
+ * Appends a record.  Returns 0 if the block is full; start another and
+ * encode the record again.
+ */
+static inline uint8_t sampleEncode(struct sample_encoder *e, const struct sample_record *r)
+{
+	uint8_t entry[SAMPLE_CODEC_MAX_ENTRY];
+	uint8_t n = 1;
+	uint32_t delta = r->epoch - e->last.epoch;
+
+	if( e->length == 0 || (e->keyInterval && e->sinceKey >= e->keyInterval) )
+	{
+		entry[0] = SAMPLE_CODEC_KEY;
+		memcpy( entry + 1, &r->epoch, 4 );	// AVR and the hosts are little endian
+		memcpy( entry + 5, &r->temp, 2 );
+		memcpy( entry + 7, &r->ph, 2 );
+		memcpy( entry + 9, &r->errors, 2 );
+		n = SAMPLE_CODEC_KEY_SIZE;
+		delta = 1;
+		e->sinceKey = 0;
+	}
+	else
+	{
+		entry[0] = SAMPLE_CODEC_DELTA;
+		if( delta != e->step )
+		{
+			entry[0] |= SAMPLE_CODEC_STEP;
+			n += samplePutVarint( entry + n, sampleZigzag( delta ) );
+		}
+		if( r->temp != e->last.temp )
+		{
+			entry[0] |= SAMPLE_CODEC_TEMP;
+			n += samplePutVarint( entry + n, sampleZigzag( (int32_t)r->temp - e->last.temp ) );
+		}
+		if( r->ph != e->last.ph )
+		{
+			entry[0] |= SAMPLE_CODEC_PH;
+			n += samplePutVarint( entry + n, sampleZigzag( (int32_t)r->ph - e->last.ph ) );
+		}
+		if( r->errors != e->last.errors )
+		{
+			entry[0] |= SAMPLE_CODEC_ERRORS;
+			n += samplePutVarint( entry + n, sampleZigzag( (int32_t)r->errors - e->last.errors ) );
+		}
+
+		if( entry[0] == (SAMPLE_CODEC_DELTA | SAMPLE_CODEC_PH) &&
+				r->ph - e->last.ph >= -8 && r->ph - e->last.ph <= 7 )
+		{
+			// the pH alone moved a little: the common case
+			entry[0] = SAMPLE_CODEC_PH_SMALL + (r->ph - e->last.ph + 8);
+			n = 1;
+		}
+		else if( entry[0] == SAMPLE_CODEC_DELTA )
+		{
+			// unchanged: lengthen the open run, or open one
+			if( e->run && e->buffer[e->run - 1] < SAMPLE_CODEC_RUN + SAMPLE_CODEC_RUN_MAX - 1 )
+			{
+				e->buffer[e->run - 1]++;
+				n = 0;
+			}
+			else
+			{
+				entry[0] = SAMPLE_CODEC_RUN;
+			}
+		}
+	}
+
+	if( n )
+	{
+		if( e->length + n > e->size )
+		{
+			return 0;
+		}
+		memcpy( e->buffer + e->length, entry, n );
+		e->run = (entry[0] == SAMPLE_CODEC_RUN) ? e->length + 1 : 0;
+		e->length += n;
+	}
+
+	e->last = *r;
+	e->step = delta;
+	e->count++;
+	e->sinceKey++;
+	return 1;
+}
+
+/**
+ * Starts reading a block
+ */
+static inline void sampleDecoderBegin(struct sample_decoder *d, const uint8_t *data, uint16_t length)
+{
+	memset( &d->last, 0, sizeof(d->last) );
+	d->step = 1;
+	d->data = data;
+	d->length = length;
+	d->pos = 0;
+	d->run = 0;
+}
+
+static inline uint8_t sampleGetVarint(struct sample_decoder *d, uint32_t *value)
+{
+	uint8_t shift = 0;
+	uint8_t c;
+
+	*value = 0;
+	do
+	{
+		if( d->pos >= d->length || shift > 28 )
+		{
+			return 0;
+		}
+		c = d->data[d->pos++];
+		*value |= (uint32_t)(c & 0x7F) << shift;
+		shift += 7;
+	} while( c & 0x80 );
+	return 1;
+}
+
+/**
+ * Reads the next record.  Returns 1 for a record, 0 at the end of the
+ * block and -1 if the block is corrupt.
+ */
+static inline int8_t sampleDecode(struct sample_decoder *d, struct sample_record *r)
+{
+	uint32_t value;
+	uint8_t tag;
+
+	if( d->run )
+	{
+		d->run--;
+		d->last.epoch += d->step;
+		*r = d->last;
+		return 1;
+	}
+	if( d->pos >= d->length || d->data[d->pos] == SAMPLE_CODEC_END )
+	{
+		return 0;
+	}
+
+	tag = d->data[d->pos++];
+	if( tag == SAMPLE_CODEC_KEY )
+	{
+		if( d->length - d->pos < SAMPLE_CODEC_KEY_SIZE - 1 )
+		{
+			return -1;
+		}
+		memcpy( &d->last.epoch, d->data + d->pos, 4 );
+		memcpy( &d->last.temp, d->data + d->pos + 4, 2 );
+		memcpy( &d->last.ph, d->data + d->pos + 6, 2 );
+		memcpy( &d->last.errors, d->data + d->pos + 8, 2 );
+		d->pos += SAMPLE_CODEC_KEY_SIZE - 1;
+		d->step = 1;
+	}
+	else if( d->pos == 1 )
+	{
+		return -1;		// blocks start with a keyframe
+	}
+	else if( tag < SAMPLE_CODEC_RUN + SAMPLE_CODEC_RUN_MAX )
+	{
+		d->run = tag - SAMPLE_CODEC_RUN;
+		d->last.epoch += d->step;
+	}
+	else if( (tag & 0xF0) == SAMPLE_CODEC_PH_SMALL )
+	{
+		d->last.epoch += d->step;
+		d->last.ph += (tag & 0x0F) - 8;
+	}
+	else if( (tag & 0xF0) == SAMPLE_CODEC_DELTA )
+	{
+		if( tag & SAMPLE_CODEC_STEP )
+		{
+			if( !sampleGetVarint( d, &value ) ) return -1;
+			d->step = sampleUnzigzag( value );
+		}
+		d->last.epoch += d->step;
+		if( tag & SAMPLE_CODEC_TEMP )
+		{
+			if( !sampleGetVarint( d, &value ) ) return -1;
+			d->last.temp += sampleUnzigzag( value );
+		}
+		if( tag & SAMPLE_CODEC_PH )
+		{
+			if( !sampleGetVarint( d, &value ) ) return -1;
+			d->last.ph += sampleUnzigzag( value );
+		}
+		if( tag & SAMPLE_CODEC_ERRORS )
+		{
+			if( !sampleGetVarint( d, &value ) ) return -1;
+			d->last.errors += sampleUnzigzag( value );
+		}
+	}
+	else
+	{
+		return -1;
+	}
+
+	*r = d->last;
+	return 1;
+}
+
+#endif /* SAMPLECODEC_H_ */
@@ -0,0 +1,177 @@
+/*
+ * Telemetry.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include "Telemetry.h"
+
+/** Instance */
+Telemetry TELEMETRY = Telemetry();
+
+/**
+ * Constructor
+ */
+Telemetry::Telemetry()
+{
+	mode = TELEMETRY_OFF;
+	sequence = 0;
+	sampleEncoderBegin( &encoder, block, sizeof(block), 0 );
+
+} // end constructor
+
+/**
+ * Selects the output: TELEMETRY_OFF, _SAMPLES or _BLOCKS.  A block in
+ * progress is sent first.
+ */
+void Telemetry::setMode(uint8_t m)
+{
+	flush();
+	mode = m;
+
+} // end setMode
+
+uint8_t Telemetry::getMode()
+{
+	return mode;
+}
+
+boolean Telemetry::isEnabled()
+{
+	return mode != TELEMETRY_OFF;
+}
+
+/**
+ * Sends one sample cycle's readings
+ */
+void Telemetry::sendSample(unsigned long epoch, int16_t temp, int16_t ph, uint16_t errors)
+{
+	uint8_t payload[TELEMETRY_SAMPLE_SIZE];
+	sample_record record;
+
+	if( mode == TELEMETRY_BLOCKS )
+	{
+		record.epoch = epoch;
+		record.temp = temp;
+		record.ph = ph;
+		record.errors = errors;
+		if( !sampleEncode( &encoder, &record ) )
+		{
+			flush();
+			sampleEncode( &encoder, &record );
+		}
+		// bound the delay while readings hold steady
+		if( encoder.count >= TELEMETRY_BLOCK_SAMPLES )
+		{
+			flush();
+		}
+		return;
+	}
+
+	payload[0] = epoch;
+	payload[1] = epoch >> 8;
+	payload[2] = epoch >> 16;
+	payload[3] = epoch >> 24;
+	payload[4] = temp;
+	payload[5] = temp >> 8;
+	payload[6] = ph;
+	payload[7] = ph >> 8;
+	payload[8] = errors;
+	payload[9] = errors >> 8;
+
+	sendFrame( TELEMETRY_TYPE_SAMPLE, payload, sizeof(payload) );
+
+} // end sendSample
+
+/**
+ * Sends one record of a history query
+ */
+void Telemetry::sendHistory(uint8_t resolution, const HistoryRecord *record)
+{
+	uint8_t payload[TELEMETRY_HISTORY_SIZE];
+	const int16_t *values = &record->tempMin;
+	uint8_t n = 0;
+	uint8_t i;
+
+	payload[n++] = resolution;
+	payload[n++] = record->start;
+	payload[n++] = record->start >> 8;
+	payload[n++] = record->start >> 16;
+	payload[n++] = record->start >> 24;
+	payload[n++] = record->count;
+	payload[n++] = record->count >> 8;
+	// tempMin..phMean are consecutive int16 members
+	for(i=0; i < 6; i++)
+	{
+		payload[n++] = values[i];
+		payload[n++] = values[i] >> 8;
+	}
+
+	sendFrame( TELEMETRY_TYPE_HISTORY, payload, sizeof(payload) );
+
+} // end sendHistory
+
+/**
+ * Sends the block in progress, if any
+ */
+void Telemetry::flush()
+{
+	if( encoder.length )
+	{
+		sendFrame( TELEMETRY_TYPE_BLOCK, block, encoder.length );
+		sampleEncoderBegin( &encoder, block, sizeof(block), 0 );
+	}
+
+} // end flush
+
+/**
+ * Frames a payload and hands it to the serial port in one write
+ */
+void Telemetry::sendFrame(uint8_t type, const uint8_t *payload, uint8_t length)
+{
+	uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE];
+
+	if( mode == TELEMETRY_OFF || length > TELEMETRY_MAX_PAYLOAD )
+	{
+		return;
+	}
+
+	Serial.write( frame, buildFrame( frame, type, payload, length ) );
+
+} // end sendFrame
+
+/**
+ * Builds a frame in frame and returns its size.  The payload may already
+ * be in place at frame + TELEMETRY_HEADER_SIZE.
+ */
+uint8_t Telemetry::buildFrame(uint8_t *frame, uint8_t type, const uint8_t *payload, uint8_t length)
+{
+	uint16_t crc = TELEMETRY_CRC_START;
+	uint8_t n = 0;
+	uint8_t i;
+
+	frame[n++] = TELEMETRY_SYNC;
+	frame[n++] = type;
+	frame[n++] = length;
+	frame[n++] = sequence++;
+	if( payload != frame + n )
+	{
+		memcpy( frame + n, payload, length );
+	}
+	n += length;
+	for(i=1; i < n; i++)
+	{
+		crc = telemetryCrcUpdate( crc, frame[i] );
+	}
+	frame[n++] = crc;
+	frame[n++] = crc >> 8;
+	return n;
+
+} // end buildFrame
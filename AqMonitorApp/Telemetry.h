@@ -0,0 +1,52 @@
+/*
+ * Telemetry.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <WProgram.h>
+#include "TelemetryFrame.h"
+#include "History.h"
+#include "SampleCodec.h"
+
+/** Modes */
+#define TELEMETRY_OFF			0
+#define TELEMETRY_SAMPLES		1	// a frame per sample
+#define TELEMETRY_BLOCKS		2	// compressed frames of up to TELEMETRY_BLOCK_SAMPLES
+
+#define TELEMETRY_BLOCK_SAMPLES	30
+
+class Telemetry
+{
+public:
+	Telemetry();
+	void setMode(uint8_t m);
+	uint8_t getMode();
+	boolean isEnabled();
+	void sendSample(unsigned long epoch, int16_t temp, int16_t ph, uint16_t errors);
+	void sendHistory(uint8_t resolution, const HistoryRecord *record);
+	void sendFrame(uint8_t type, const uint8_t *payload, uint8_t length);
+	uint8_t buildFrame(uint8_t *frame, uint8_t type, const uint8_t *payload, uint8_t length);
+	void flush();
+
+private:
+	uint8_t mode;
+	uint8_t sequence;
+	sample_encoder encoder;
+	uint8_t block[TELEMETRY_MAX_PAYLOAD];
+
+};
+
+extern Telemetry TELEMETRY;
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,89 @@
+/*
+ * TelemetryFrame.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ *
+ * Wire format of the binary telemetry frames.  Plain C so the host tools
+ * can share it.
+ *
+ *   sync  type  length  sequence  payload[length]  crc(lo)  crc(hi)
+ *
+ * The CRC is CRC-CCITT (avr-libc _crc_ccitt_update, start 0xFFFF) over
+ * type, length, sequence and payload.  Multi-byte fields are little
+ * endian.
+ */
+
+#ifndef TELEMETRYFRAME_H_
+#define TELEMETRYFRAME_H_
+
+#include <stdint.h>
+#include "Crc16.h"
+
+#define TELEMETRY_SYNC				0xA5
+#define TELEMETRY_HEADER_SIZE		4
+#define TELEMETRY_CRC_SIZE			2
+#define TELEMETRY_MAX_PAYLOAD		64
+#define TELEMETRY_CRC_START			CRC16_START
+
+/** Frame types */
+#define TELEMETRY_TYPE_SAMPLE		0x01
+#define TELEMETRY_TYPE_HISTORY		0x02
+#define TELEMETRY_TYPE_BLOCK		0x03
+#define TELEMETRY_TYPE_DUMP			0x04
+#define TELEMETRY_TYPE_DUMP_END		0x05
+
+/**
+ * Sample payload:
+ *   epoch    uint32  seconds since 2000-01-01 00:00:00
+ *   temp     int16   hundredths of a degree F
+ *   ph       int16   hundredths of pH
+ *   errors   uint16  failed pH samples since power up
+ */
+#define TELEMETRY_SAMPLE_SIZE		10
+
+/**
+ * History payload, one record of a history query:
+ *   resolution uint8  0 raw, 1 minute, 2 hour
+ *   start    uint32  seconds since 2000 of the reading or period
+ *   count    uint16  readings in the period
+ *   temp     int16 x3  min, max, mean in hundredths of a degree F
+ *   ph       int16 x3  min, max, mean in hundredths of pH
+ */
+#define TELEMETRY_HISTORY_SIZE		19
+
+/**
+ * Block payload: up to TELEMETRY_MAX_PAYLOAD bytes of samples encoded as
+ * described in SampleCodec.h, one keyframe at the start
+ */
+
+/**
+ * Dump payload:
+ *   first    uint32  sequence of the first record the frame covers
+ *   next     uint32  sequence after the last; records in between that are
+ *                    missing were skipped (unreadable or out of range)
+ *   records  log records as read back from the EEPROM, 16 bytes each:
+ *            sequence uint32, epoch uint32, temp int16, ph int16,
+ *            errors uint16, crc uint16 (CRC16 of the 14 bytes before it)
+ */
+#define TELEMETRY_DUMP_HEADER_SIZE	8
+#define TELEMETRY_DUMP_RECORD_SIZE	16
+
+/**
+ * Dump end payload:
+ *   next     uint32  sequence after the last record sent
+ *   status   uint8   TELEMETRY_DUMP_DONE or TELEMETRY_DUMP_ABORTED
+ */
+#define TELEMETRY_DUMP_END_SIZE		5
+#define TELEMETRY_DUMP_DONE			0
+#define TELEMETRY_DUMP_ABORTED		1
+
+#define telemetryCrcUpdate crc16Update
+
+#endif /* TELEMETRYFRAME_H_ */
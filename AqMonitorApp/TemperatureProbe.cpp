@@ -15,6 +15,7 @@
  */
 
 #include "TemperatureProbe.h"
+#include "Config.h"
 
 /** Instance */
 TemperatureProbe TEMP = TemperatureProbe();
@@ -23,8 +24,10 @@ TemperatureProbe TEMP = TemperatureProbe();
 TemperatureProbe::TemperatureProbe()
 {
 	index = 0;
+	sampleSize = TEMP_SAMPLE_SIZE;
 	averageSample = 0;
 	currentSample = 0;
+	sampleSum = 0;
 	filled = false;
 
 } // end constructor
@@ -35,32 +38,43 @@ TemperatureProbe::TemperatureProbe()
  */
 void TemperatureProbe::initialize()
 {
-	 pinMode( TEMP_PIN, INPUT ); // set LM34 temp sensor pin as an input
-	 pinMode( FEEDBACK_PIN, INPUT ); // Ref voltage feedback
+	 pinModeFast( TEMP_PIN, INPUT ); // set LM34 temp sensor pin as an input
+	 pinModeFast( FEEDBACK_PIN, INPUT ); // Ref voltage feedback
 
 	 analogReference(EXTERNAL); // set the analog reference to external
 
+	 // Let the ADC interrupt keep the probe converted in the background;
+	 // the reference feedback is never read, so it is not scanned
+	 analogScanAdd( TEMP_PIN, TEMP_OVERSAMPLE );
+	 analogScanStart();
+
 } // end initialize
 
 /**
- * Samples the temperature from probe
+ * Samples the temperature from probe.  Values are kept in hundredths of a
+ * degree so no floating point is needed.
  */
 void TemperatureProbe::sample()
 {
 	uint16_t sample;
-	float voltage;
 
-	// Do sampling
-	analogRead(TEMP_PIN); // throw away value
-	delay(20);
-	sample = analogRead(TEMP_PIN); // actual value
-	delay(20);
+	// Latest oversampled value from the scan table; the scan engine
+	// already discards the settling conversion after each mux switch
+	sample = analogRead(TEMP_PIN);
 
-	voltage = sample * TEMP_V_REF;
-	voltage /= 1024;
+	// LM34 is 10mV per degree, so hundredths of a degree are the
+	// millivolts times ten
+	currentSample = ( ( (uint32_t)sample * CONFIG.data.tempVRef * 10 + 512 ) >> 10 )
+			+ CONFIG.data.tempOffset;
 
-//	currentSample = ( TEMP_V_REF * sample * 100.0) / 1024.0;
-	currentSample = voltage*100;
+	// Start the average over if the window size was changed
+	if( sampleSize != CONFIG.data.tempSamples )
+	{
+		sampleSize = CONFIG.data.tempSamples;
+		index = 0;
+		sampleSum = 0;
+		filled = false;
+	}
 
 //	Serial.print("Voltage: ");
 //	Serial.print(voltage);
@@ -70,30 +84,26 @@ void TemperatureProbe::sample()
 //	Serial.println(currentSample);
 
 
-	// Compute average value
+	// Compute average value; keep a running sum instead of re-adding
+	// the whole list
+	if( filled )
+	{
+		sampleSum -= sampleList[index];
+	}
 	sampleList[index++] = currentSample;
-	averageSample = 0;
+	sampleSum += currentSample;
 	if( filled )
 	{
-		// Compute new average
-		for(int i=0; i<TEMP_SAMPLE_SIZE; i++)
-		{
-			averageSample += sampleList[i];
-		}
-		averageSample /= TEMP_SAMPLE_SIZE;
+		averageSample = sampleSum / sampleSize;
 	}
 	else
 	{
-		for(int i=0; i<index; i++)
-		{
-			averageSample += sampleList[i];
-		}
-		averageSample /= index;
+		averageSample = sampleSum / index;
 	}
 //	Serial.print("Temp: ");
 //	Serial.println( averageSample, 2 );
 
-	if( index == TEMP_SAMPLE_SIZE )
+	if( index == sampleSize )
 	{
 		index = 0;
 		filled = true;
@@ -101,18 +111,70 @@ void TemperatureProbe::sample()
 }
 
 /**
- * Returns the last temp sampled
+ * Copies the averaging filter into TEMP_STATE_SIZE bytes
+ */
+void TemperatureProbe::saveState(uint8_t *state)
+{
+	*state++ = sampleSize;
+	*state++ = index;
+	*state++ = filled;
+	for(uint8_t i=0; i<TEMP_SAMPLE_SIZE; i++)
+	{
+		*state++ = sampleList[i];
+		*state++ = sampleList[i] >> 8;
+	}
+
+} // end saveState
+
+/**
+ * Reloads the averaging filter from saveState() output.  Returns false,
+ * leaving the filter alone, if the state makes no sense or was saved with
+ * another window size.
+ */
+boolean TemperatureProbe::restoreState(const uint8_t *state)
+{
+	uint8_t count;
+
+	if( state[0] != CONFIG.data.tempSamples || state[1] >= state[0] ||
+			state[2] > 1 || (!state[2] && !state[1]) )
+	{
+		return false;
+	}
+	sampleSize = state[0];
+	index = state[1];
+	filled = state[2];
+	state += 3;
+
+	sampleSum = 0;
+	for(uint8_t i=0; i<TEMP_SAMPLE_SIZE; i++, state += 2)
+	{
+		sampleList[i] = state[0] | (state[1] << 8);
+	}
+	count = filled ? sampleSize : index;
+	for(uint8_t i=0; i<count; i++)
+	{
+		sampleSum += sampleList[i];
+	}
+	averageSample = sampleSum / count;
+	currentSample = sampleList[ (index + sampleSize - 1) % sampleSize ];
+	return true;
+
+} // end restoreState
+
+/**
+ * Returns the last temp sampled, in hundredths of a degree
  */
-double TemperatureProbe::getLastValue()
+int16_t TemperatureProbe::getLastValue()
 {
 	return currentSample;
 }
 
 
 /**
- * Returns the average value sampled over the last TEMP_SAMPLE_SIZE
+ * Returns the average value sampled over the last TEMP_SAMPLE_SIZE, in
+ * hundredths of a degree
  */
-double TemperatureProbe::getAverageValue()
+int16_t TemperatureProbe::getAverageValue()
 {
 	return averageSample;
 }
@@ -23,8 +23,12 @@
 #define TEMP_PIN			0
 #define FEEDBACK_PIN		1
 
-#define TEMP_SAMPLE_SIZE 	10
-#define TEMP_V_REF			3.32
+#define TEMP_SAMPLE_SIZE 	10		// largest averaging window; CONFIG picks the size
+#define TEMP_OVERSAMPLE		16
+#define TEMP_V_REF_MV		3320	// reference voltage in millivolts
+
+/** Bytes used by saveState(): size, index, filled and the sample list */
+#define TEMP_STATE_SIZE		(3 + 2*TEMP_SAMPLE_SIZE)
 
 class TemperatureProbe
 {
@@ -32,14 +36,18 @@ public:
 	TemperatureProbe();
 	void initialize();
 	void sample();
-	double getLastValue();
-	double getAverageValue();
+	int16_t getLastValue();
+	int16_t getAverageValue();
+	void saveState(uint8_t *state);
+	boolean restoreState(const uint8_t *state);
 
 private:
 	volatile uint8_t index;
-	volatile double sampleList[TEMP_SAMPLE_SIZE];
-	volatile double currentSample;
-	volatile double averageSample;
+	volatile uint8_t sampleSize;
+	volatile int16_t sampleList[TEMP_SAMPLE_SIZE];
+	volatile int16_t currentSample;
+	volatile int16_t averageSample;
+	volatile int32_t sampleSum;
 	volatile boolean filled;
 
 };
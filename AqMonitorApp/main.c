@@ -22,8 +22,7 @@
 #include "AqMonitorApp.h"
 void sample();
 void initialize();
-void processCommand();
-int SerialReadPosInt();
+void serviceConsole();
 
 /**
  * Main routine
@@ -40,22 +39,23 @@ int main(void)
 	Serial.begin(115200);
 
 	// Print start as FYI
-	Serial.println("PROGRAM START");
+	Serial.println(F("PROGRAM START"));
 
 	// Initialize hardware and modules
 	initialize();
 
+	// Keep answering commands while drivers wait on their devices
+	yieldHook( serviceConsole );
+
 	while(1)
 	{
-		// Check serial port for cmd
-		if(Serial.available())
-		{
-			processCommand();
-		}
-
-		// Keep reading clock until seconds change
+		// Keep reading clock until seconds change, serving commands, the
+		// EEPROM log and any export meanwhile
 		while(!sampleReady)
 		{
+			CONSOLE.poll();
+			LOGGER.poll();
+			DUMP.poll();
 			RTC.readClock();
 			if( seconds != RTC.getSeconds() )
 			{
@@ -67,6 +67,18 @@ int main(void)
 		// Sample values
 		sample();
 
+		// Keep the filters in the clock's RAM for a warm start
+		CHECKPOINT.save();
+
+		// Fold readings into the minute and hour history
+		HISTORY.add( RTC.getEpoch(), TEMP.getLastValue(), PH.getLastValue() );
+
+		// Send readings to the collector
+		TELEMETRY.sendSample( RTC.getEpoch(), TEMP.getLastValue(), PH.getLastValue(), PH.getErrors() );
+
+		// Queue readings for the EEPROM log
+		LOGGER.add( RTC.getEpoch(), TEMP.getLastValue(), PH.getLastValue(), PH.getErrors() );
+
 		// Update Display
 		LCD.updatepH( PH.getAverageValue() );
 		LCD.updateTemp( TEMP.getAverageValue() );
@@ -78,7 +90,7 @@ int main(void)
 	}
 
 	// never get here, but...
-	Serial.println("PROGRAM END");
+	Serial.println(F("PROGRAM END"));
 
 	// Just in case
 	while(1);
@@ -86,15 +98,25 @@ int main(void)
 } // end main
 
 /**
- * Main initialization routine.  Inits LCD, Temp, pH, and RTC.
+ * Main initialization routine.  Loads the settings, inits RTC, Temp, pH,
+ * and LCD, then restores the last checkpoint and history.  The RTC goes first since
+ * the checkpoint lives in its RAM.
  *
  */
 void initialize()
 {
+	CONFIG.load();
+	TELEMETRY.setMode( CONFIG.data.telemetry );
+
+	RTC.initialize();
 	TEMP.initialize();
 	PH.initialize();
 	LCD.initialize();
-	RTC.initialize();
+
+	RTC.readClock();
+	CHECKPOINT.restore();
+	HISTORY.initialize();
+	LOGGER.initialize();
 }
 
 /**
@@ -111,197 +133,25 @@ void sample()
 } // end sample
 
 /**
- * Processes command from serial port
+ * Yield hook; runs the command handler, the EEPROM log and any export
+ * during delays.  Nothing runs from PH_REPLY_QUIET after a pH request
+ * until the stamp's reply is in: the bus, the USART and EEPROM writes
+ * would hold off the SoftwareSerial receive and corrupt the reading, so
+ * commands that come then wait for it, about 160ms at most.  The LCD is
+ * never refreshed here, its writes run with interrupts off.
  */
-void processCommand()
-{
-	if(!Serial.available()) { return; }
-
-	char command = Serial.read();
-	int in,in2;
-	switch(command)
-	{
-
-		case 'H':
-		case 'h':
-			in=SerialReadPosInt();
-			RTC.setHours(in);
-			RTC.setClock();
-			Serial.print("Setting hours to: ");
-			Serial.println(in);
-			break;
-		case 'I':
-		case 'i':
-			in=SerialReadPosInt();
-			RTC.setMinutes(in);
-			RTC.setClock();
-			Serial.print("Setting minutes to: ");
-			Serial.println(in);
-			break;
-		case 'S':
-		case 's':
-			in=SerialReadPosInt();
-			RTC.setSeconds(in);
-			RTC.setClock();
-			Serial.print("Setting seconds to: ");
-			Serial.println(in);
-			break;
-		case 'Y':
-		case 'y':
-			in=SerialReadPosInt();
-			RTC.setYear(in);
-			RTC.setClock();
-			Serial.print("Setting year to: ");
-			Serial.println(in);
-			break;
-		case 'M':
-		case 'm':
-			in=SerialReadPosInt();
-			RTC.setMonth(in);
-			RTC.setClock();
-			Serial.print("Setting month to: ");
-			Serial.println(in);
-			break;
-		case 'D':
-		case 'd':
-			in=SerialReadPosInt();
-			RTC.setDate(in);
-			RTC.setClock();
-			Serial.print("Setting date to: ");
-			Serial.println(in);
-			break;
-		case 'W':
-			Serial.print("Day of week is: ");
-			Serial.println((int) RTC.getDayOfWeek());
-			break;
-		case 'w':
-			in=SerialReadPosInt();
-			RTC.setDayOfWeek(in);
-			RTC.setClock();
-			Serial.print("Setting day of week to: ");
-			Serial.println(in);
-			break;
-
-		case 't':
-		case 'T':
-			if(RTC.is12hour())
-			{
-				RTC.switchTo24h();
-				Serial.println("Switching to 24-hour clock.");
-			}
-			else
-			{
-				RTC.switchTo12h();
-				Serial.println("Switching to 12-hour clock.");
-			}
-			RTC.setClock();
-			break;
-
-		case 'A':
-		case 'a':
-			if(RTC.is12hour())
-			{
-				RTC.setAM();
-				RTC.setClock();
-				Serial.println("Set AM.");
-			}
-			else
-			{
-				Serial.println("(Set hours only in 24-hour mode.)");
-			}
-			break;
-
-		case 'P':
-		case 'p':
-			if(RTC.is12hour())
-			{
-				RTC.setPM();
-				RTC.setClock();
-				Serial.println("Set PM.");
-			}
-			else
-			{
-				Serial.println("(Set hours only in 24-hour mode.)");
-			}
-			break;
-
-		case 'q':
-			RTC.sqwEnable(RTC.SQW_1Hz);
-			Serial.println("Square wave output set to 1Hz");
-			break;
-		case 'Q':
-			RTC.sqwDisable(0);
-			Serial.println("Square wave output disabled (low)");
-			break;
-
-		case 'z':
-			RTC.start();
-			Serial.println("Clock oscillator started.");
-			break;
-		case 'Z':
-			RTC.stop();
-			Serial.println("Clock oscillator stopped.");
-			break;
-
-		case '>':
-			in=SerialReadPosInt();
-			in2=SerialReadPosInt();
-			RTC.writeData(in, in2);
-			Serial.print("Write to register ");
-			Serial.print(in);
-			Serial.print(" the value ");
-			Serial.println(in2);
-			break;
-		case '<':
-			in=SerialReadPosInt();
-			in2=RTC.readData(in);
-			Serial.print("Read from register ");
-			Serial.print(in);
-			Serial.print(" the value ");
-			Serial.println(in2);
-			break;
-
-		default:
-			Serial.println("Unknown command. Try these:");
-			Serial.println(" h## - set Hours d## - set Date");
-			Serial.println(" i## - set mInutes m## - set Month");
-			Serial.println(" s## - set Seconds y## - set Year");
-			Serial.println(" w## - set arbitrary day of Week");
-			Serial.println(" t - toggle 24-hour mode");
-			Serial.println(" a - set AM p - set PM");
-			Serial.println();
-			Serial.println(" z - start clock Z - stop clock");
-			Serial.println(" q - SQW/OUT = 1Hz Q - stop SQW/OUT");
-			Serial.println();
-			Serial.println(" >##,### - write to register ## the value ###");
-			Serial.println(" <## - read the value in register ##");
-
-	}//switch on command
-
-}
-
-//read in numeric characters until something else
-//or no more data is available on serial.
-int SerialReadPosInt()
+void serviceConsole()
 {
-	uint16_t i = 0;
-	boolean done=false;
-	while(Serial.available() && !done)
+	if( PH.isReceiving() )
 	{
-		uint8_t c = Serial.read();
-		if (c >= '0' && c <='9')
-		{
-			i = i * 10 + (c-'0');
-		}
-		else
-		{
-			done = true;
-		}
+		return;
 	}
-	return i;
-}
 
+	CONSOLE.poll();
+	LOGGER.poll();
+	DUMP.poll();
 
+} // end serviceConsole
 
 extern "C" void __cxa_pure_virtual()
 {
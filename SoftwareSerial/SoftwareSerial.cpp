@@ -40,6 +40,7 @@ http://arduiniana.org.
 // 
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <util/delay_basic.h>
 #include "WConstants.h"
 #include "pins_arduino.h"
 #include "SoftwareSerial.h"
@@ -161,6 +162,7 @@ inline void DebugPulse(uint8_t pin, uint8_t count)
 
 /* static */ 
 inline void SoftwareSerial::tunedDelay(uint16_t delay) { 
+#if defined(__AVR__)
   uint8_t tmp=0;
 
   asm volatile("sbiw    %0, 0x01 \n\t"
@@ -171,6 +173,12 @@ inline void SoftwareSerial::tunedDelay(uint16_t delay) {
     : "+r" (delay), "+a" (tmp)
     : "0" (delay)
     );
+#else
+  // host build: the loop above runs delay + 1 times at 7 cycles each; the
+  // tables also allow for the bit loop around each call, about 28 cycles
+  // of code the host clock does not count
+  hal_delay_cycles(7UL * (delay + 1UL) + 28);
+#endif
 }
 
 // This function sets the current object as the "listening"
@@ -336,21 +344,6 @@ SoftwareSerial::SoftwareSerial()
 
 }
 
-//
-// Constructor
-//
-SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic /* = false */) : 
-  _rx_delay_centering(0),
-  _rx_delay_intrabit(0),
-  _rx_delay_stopbit(0),
-  _tx_delay(0),
-  _buffer_overflow(false),
-  _inverse_logic(inverse_logic)
-{
-  setTX(transmitPin);
-  setRX(receivePin);
-}
-
 //
 // Destructor
 //
@@ -359,26 +352,6 @@ SoftwareSerial::~SoftwareSerial()
   end();
 }
 
-void SoftwareSerial::setTX(uint8_t tx)
-{
-  pinMode(tx, OUTPUT);
-  digitalWrite(tx, HIGH);
-  _transmitBitMask = digitalPinToBitMask(tx);
-  uint8_t port = digitalPinToPort(tx);
-  _transmitPortRegister = portOutputRegister(port);
-}
-
-void SoftwareSerial::setRX(uint8_t rx)
-{
-  pinMode(rx, INPUT);
-  if (!_inverse_logic)
-    digitalWrite(rx, HIGH);  // pullup for normal logic!
-  _receivePin = rx;
-  _receiveBitMask = digitalPinToBitMask(rx);
-  uint8_t port = digitalPinToPort(rx);
-  _receivePortRegister = portInputRegister(port);
-}
-
 //
 // Public methods
 //
@@ -496,6 +469,18 @@ void SoftwareSerial::write(uint8_t b)
   tunedDelay(_tx_delay);
 }
 
+// Bulk write: one virtual call for the whole buffer.  Interrupts are still
+// re-enabled during each stop bit so millis() and the other receivers keep
+// running between characters.
+void SoftwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (_tx_delay == 0)
+    return;
+
+  while (size--)
+    SoftwareSerial::write(*buffer++);
+}
+
 #if !defined(cbi)
 #define cbi(sfr, bit) (_SFR_BYTE(sfr) &= ~_BV(bit))
 #define sbi(sfr, bit) (_SFR_BYTE(sfr) |= _BV(bit))
@@ -34,6 +34,8 @@ http://arduiniana.org.
 
 #include <inttypes.h>
 #include <Stream.h>
+#include <wiring.h>
+#include <pins_arduino.h>
 
 /******************************************************************************
 * Definitions
@@ -73,8 +75,8 @@ private:
   void recv();
   uint8_t rx_pin_read();
   void tx_pin_write(uint8_t pin_state);
-  void setTX(uint8_t transmitPin);
-  void setRX(uint8_t receivePin);
+  inline void setTX(uint8_t transmitPin) __attribute__ ((always_inline));
+  inline void setRX(uint8_t receivePin) __attribute__ ((always_inline));
 
   // private static method for timing
   static inline void tunedDelay(uint16_t delay);
@@ -94,6 +96,8 @@ public:
   int peek();
 
   virtual void write(uint8_t byte);
+  virtual void write(const uint8_t *buffer, size_t size);
+  using Print::write; // pull in write(str) from Print
   virtual int read();
   virtual int available();
   virtual void flush();
@@ -102,6 +106,45 @@ public:
   static inline void handle_interrupt();
 };
 
+//
+// Constructor
+//
+// The constructor and pin setup live here so that objects built with
+// constant pin numbers resolve their port registers at compile time
+// instead of reading the pin tables from flash.
+//
+inline SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic /* = false */) : 
+  _rx_delay_centering(0),
+  _rx_delay_intrabit(0),
+  _rx_delay_stopbit(0),
+  _tx_delay(0),
+  _buffer_overflow(false),
+  _inverse_logic(inverse_logic)
+{
+  setTX(transmitPin);
+  setRX(receivePin);
+}
+
+inline void SoftwareSerial::setTX(uint8_t tx)
+{
+  pinModeFast(tx, OUTPUT);
+  digitalWriteFast(tx, HIGH);
+  _transmitBitMask = digitalPinToBitMask(tx);
+  uint8_t port = digitalPinToPort(tx);
+  _transmitPortRegister = portOutputRegister(port);
+}
+
+inline void SoftwareSerial::setRX(uint8_t rx)
+{
+  pinModeFast(rx, INPUT);
+  if (!_inverse_logic)
+    digitalWriteFast(rx, HIGH);  // pullup for normal logic!
+  _receivePin = rx;
+  _receiveBitMask = digitalPinToBitMask(rx);
+  uint8_t port = digitalPinToPort(rx);
+  _receivePortRegister = portInputRegister(port);
+}
+
 // Arduino 0012 workaround
 #undef int
 #undef char
@@ -121,6 +121,32 @@ uint8_t TwoWire::endTransmission(void)
   return ret;
 }
 
+// sends the buffer and then length bytes of data straight from the
+// caller's memory, without waiting: data must stay untouched until
+// busy() returns 0, then result() has what endTransmission() would
+// have returned, however many transfers have run since.  Returns 0 if
+// started, 1 if the buffer is too long and 5 if the bus is busy.
+uint8_t TwoWire::startTransmission(const uint8_t* data, uint8_t length)
+{
+  uint8_t ret = twi_writeStart(txAddress, txBuffer, txBufferLength, data, length);
+  if(ret != 5){
+    txBufferIndex = 0;
+    txBufferLength = 0;
+    transmitting = 0;
+  }
+  return ret;
+}
+
+uint8_t TwoWire::busy(void)
+{
+  return twi_busy();
+}
+
+uint8_t TwoWire::result(void)
+{
+  return twi_startResult();
+}
+
 // must be called in:
 // slave tx event callback
 // or after beginTransmission(address)
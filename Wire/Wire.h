@@ -49,6 +49,9 @@ class TwoWire
     void beginTransmission(uint8_t);
     void beginTransmission(int);
     uint8_t endTransmission(void);
+    uint8_t startTransmission(const uint8_t*, uint8_t);
+    uint8_t busy(void);
+    uint8_t result(void);
     uint8_t requestFrom(uint8_t, uint8_t);
     uint8_t requestFrom(int, int);
     void send(uint8_t);
@@ -44,6 +44,10 @@ static uint8_t twi_masterBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_masterBufferIndex;
 static uint8_t twi_masterBufferLength;
 
+// caller's bytes sent straight after the master buffer by twi_writeStart
+static const uint8_t* volatile twi_masterStream;
+static volatile uint8_t twi_masterStreamLength;
+
 static uint8_t twi_txBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_txBufferIndex;
 static volatile uint8_t twi_txBufferLength;
@@ -53,6 +57,11 @@ static volatile uint8_t twi_rxBufferIndex;
 
 static volatile uint8_t twi_error;
 
+// outcome of the last twi_writeStart, kept apart from twi_error so that
+// transfers run after it finished do not overwrite it
+static volatile uint8_t twi_startPending;
+static volatile uint8_t twi_startError;
+
 /* 
  * Function twi_init
  * Desc     readys twi pins and sets twi bitrate
@@ -194,6 +203,7 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
   // initialize buffer iteration vars
   twi_masterBufferIndex = 0;
   twi_masterBufferLength = length;
+  twi_masterStreamLength = 0;
   
   // copy data to twi buffer
   for(i = 0; i < length; ++i){
@@ -212,16 +222,106 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
     continue;
   }
   
-  if (twi_error == 0xFF)
+  return twi_writeResult();
+}
+
+/* 
+ * Function twi_writeStart
+ * Desc     starts a write to a device on the bus and returns without
+ *          waiting: data is copied to the buffer and sent first, then
+ *          stream is sent from the caller's memory, which must stay
+ *          untouched until twi_busy() returns 0.  A write with no bytes
+ *          at all only addresses the device, which is how an eeprom is
+ *          polled for the end of its write cycle.
+ * Input    address: 7bit i2c device address
+ *          data: pointer to byte array, copied
+ *          length: number of bytes in array
+ *          stream: pointer to byte array, not copied
+ *          streamLength: number of bytes in stream
+ * Output   0 .. started, twi_startResult() has the outcome once done
+ *          1 .. length to long for buffer
+ *          5 .. bus busy, nothing started
+ */
+uint8_t twi_writeStart(uint8_t address, uint8_t* data, uint8_t length, const uint8_t* stream, uint8_t streamLength)
+{
+  uint8_t i;
+
+  if(TWI_BUFFER_LENGTH < length){
+    return 1;
+  }
+  if(TWI_READY != twi_state){
+    return 5;
+  }
+  twi_state = TWI_MTX;
+  twi_error = 0xFF;
+
+  twi_masterBufferIndex = 0;
+  twi_masterBufferLength = length;
+  for(i = 0; i < length; ++i){
+    twi_masterBuffer[i] = data[i];
+  }
+  twi_masterStream = stream;
+  twi_masterStreamLength = streamLength;
+  twi_startPending = 1;
+
+  twi_slarw = TW_WRITE;
+  twi_slarw |= address << 1;
+
+  // send start condition, the interrupt does the rest
+  TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+
+  return 0;
+}
+
+/* 
+ * Function twi_busy
+ * Desc     tells whether a master operation is still running
+ * Input    none
+ * Output   1 .. busy, 0 .. ready
+ */
+uint8_t twi_busy(void)
+{
+  return TWI_READY != twi_state;
+}
+
+static uint8_t twi_resultOf(uint8_t error)
+{
+  if (error == 0xFF)
     return 0;	// success
-  else if (twi_error == TW_MT_SLA_NACK)
+  else if (error == TW_MT_SLA_NACK)
     return 2;	// error: address send, nack received
-  else if (twi_error == TW_MT_DATA_NACK)
+  else if (error == TW_MT_DATA_NACK)
     return 3;	// error: data send, nack received
   else
     return 4;	// other twi error
 }
 
+/* 
+ * Function twi_writeResult
+ * Desc     outcome of the last master write
+ * Input    none
+ * Output   0 .. success
+ *          2 .. address send, NACK received
+ *          3 .. data send, NACK received
+ *          4 .. other twi error (lost bus arbitration, bus error, ..)
+ */
+uint8_t twi_writeResult(void)
+{
+  return twi_resultOf(twi_error);
+}
+
+/* 
+ * Function twi_startResult
+ * Desc     outcome of the last write begun with twi_writeStart, however
+ *          many transfers have run since it finished
+ * Input    none
+ * Output   as twi_writeResult
+ */
+uint8_t twi_startResult(void)
+{
+  return twi_resultOf(twi_startError);
+}
+
 /* 
  * Function twi_transmit
  * Desc     fills slave tx buffer with data
@@ -293,6 +393,21 @@ void twi_reply(uint8_t ack)
   }
 }
 
+/* 
+ * Function twi_latchStart
+ * Desc     keeps the outcome of a twi_writeStart transfer as it ends;
+ *          no other master transfer can begin before then
+ * Input    none
+ * Output   none
+ */
+static void twi_latchStart(void)
+{
+  if(twi_startPending){
+    twi_startError = twi_error;
+    twi_startPending = 0;
+  }
+}
+
 /* 
  * Function twi_stop
  * Desc     relinquishes bus master status
@@ -310,6 +425,8 @@ void twi_stop(void)
     continue;
   }
 
+  twi_latchStart();
+
   // update twi state
   twi_state = TWI_READY;
 }
@@ -325,6 +442,8 @@ void twi_releaseBus(void)
   // release bus
   TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT);
 
+  twi_latchStart();
+
   // update twi state
   twi_state = TWI_READY;
 }
@@ -348,6 +467,11 @@ SIGNAL(TWI_vect)
         // copy data to output register and ack
         TWDR = twi_masterBuffer[twi_masterBufferIndex++];
         twi_reply(1);
+      }else if(twi_masterStreamLength){
+        // then the caller's bytes, in place
+        TWDR = *twi_masterStream++;
+        twi_masterStreamLength--;
+        twi_reply(1);
       }else{
         twi_stop();
       }
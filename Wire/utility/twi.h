@@ -46,6 +46,10 @@
   void twi_setAddress(uint8_t);
   uint8_t twi_readFrom(uint8_t, uint8_t*, uint8_t);
   uint8_t twi_writeTo(uint8_t, uint8_t*, uint8_t, uint8_t);
+  uint8_t twi_writeStart(uint8_t, uint8_t*, uint8_t, const uint8_t*, uint8_t);
+  uint8_t twi_busy(void);
+  uint8_t twi_writeResult(void);
+  uint8_t twi_startResult(void);
   uint8_t twi_transmit(uint8_t*, uint8_t);
   void twi_attachSlaveRxEvent( void (*)(uint8_t*, int) );
   void twi_attachSlaveTxEvent( void (*)(void) );
@@ -39,8 +39,10 @@
 // is the index of the location from which to read.
 #if (RAMEND < 1000)
   #define RX_BUFFER_SIZE 32
+  #define TX_BUFFER_SIZE 16
 #else
   #define RX_BUFFER_SIZE 128
+  #define TX_BUFFER_SIZE 64
 #endif
 
 struct ring_buffer
@@ -50,17 +52,30 @@ struct ring_buffer
   int tail;
 };
 
+// Outgoing data is queued here and fed to the UART by the data register
+// empty interrupt, so write() only waits when the buffer is full.
+struct tx_ring_buffer
+{
+  unsigned char buffer[TX_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+};
+
 #if defined(UBRRH) || defined(UBRR0H)
   ring_buffer rx_buffer  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer  =  { { 0 }, 0, 0 };
 #endif
 #if defined(UBRR1H)
   ring_buffer rx_buffer1  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer1  =  { { 0 }, 0, 0 };
 #endif
 #if defined(UBRR2H)
   ring_buffer rx_buffer2  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer2  =  { { 0 }, 0, 0 };
 #endif
 #if defined(UBRR3H)
   ring_buffer rx_buffer3  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer3  =  { { 0 }, 0, 0 };
 #endif
 
 inline void store_char(unsigned char c, ring_buffer *rx_buffer)
@@ -168,15 +183,78 @@ inline void store_char(unsigned char c, ring_buffer *rx_buffer)
 
 
 
+// Sends the next queued byte, or turns the interrupt off once the buffer
+// has drained.  Only the interrupt (or write() with interrupts disabled)
+// ever writes the data register while the buffer is in use.
+inline void send_char(tx_ring_buffer *tx_buffer, volatile uint8_t *udr,
+  volatile uint8_t *ucsrb, uint8_t udrie)
+{
+  if (tx_buffer->head == tx_buffer->tail) {
+    *ucsrb &= ~(1 << udrie);
+  } else {
+    uint8_t tail = tx_buffer->tail;
+    *udr = tx_buffer->buffer[tail];
+    tx_buffer->tail = (tail + 1) % TX_BUFFER_SIZE;
+  }
+}
+
+#if defined(UBRRH) || defined(UBRR0H)
+#if defined(USART_UDRE_vect) && defined(UDR0)
+  SIGNAL(USART_UDRE_vect)
+  {
+    send_char(&tx_buffer, &UDR0, &UCSR0B, UDRIE0);
+  }
+#elif defined(USART0_UDRE_vect) && defined(UDR0)
+  SIGNAL(USART0_UDRE_vect)
+  {
+    send_char(&tx_buffer, &UDR0, &UCSR0B, UDRIE0);
+  }
+#elif defined(USART_UDRE_vect) && defined(UDR)
+  SIGNAL(USART_UDRE_vect)
+  {
+    send_char(&tx_buffer, &UDR, &UCSRB, UDRIE);
+  }
+#elif defined(UART0_UDRE_vect) && defined(UDR0)
+  SIGNAL(UART0_UDRE_vect)
+  {
+    send_char(&tx_buffer, &UDR0, &UCSR0B, UDRIE0);
+  }
+#else
+  #error No data register empty interrupt handler for usart 0
+#endif
+#endif
+
+#if defined(USART1_UDRE_vect) && defined(UDR1)
+  SIGNAL(USART1_UDRE_vect)
+  {
+    send_char(&tx_buffer1, &UDR1, &UCSR1B, UDRIE1);
+  }
+#endif
+
+#if defined(USART2_UDRE_vect) && defined(UDR2)
+  SIGNAL(USART2_UDRE_vect)
+  {
+    send_char(&tx_buffer2, &UDR2, &UCSR2B, UDRIE2);
+  }
+#endif
+
+#if defined(USART3_UDRE_vect) && defined(UDR3)
+  SIGNAL(USART3_UDRE_vect)
+  {
+    send_char(&tx_buffer3, &UDR3, &UCSR3B, UDRIE3);
+  }
+#endif
+
 // Constructors ////////////////////////////////////////////////////////////////
 
-HardwareSerial::HardwareSerial(ring_buffer *rx_buffer,
+HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, tx_ring_buffer *tx_buffer,
   volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
   volatile uint8_t *udr,
-  uint8_t rxen, uint8_t txen, uint8_t rxcie, uint8_t udre, uint8_t u2x)
+  uint8_t rxen, uint8_t txen, uint8_t rxcie, uint8_t udrie, uint8_t udre, uint8_t u2x)
 {
   _rx_buffer = rx_buffer;
+  _tx_buffer = tx_buffer;
   _ubrrh = ubrrh;
   _ubrrl = ubrrl;
   _ucsra = ucsra;
@@ -185,6 +263,7 @@ HardwareSerial::HardwareSerial(ring_buffer *rx_buffer,
   _rxen = rxen;
   _txen = txen;
   _rxcie = rxcie;
+  _udrie = udrie;
   _udre = udre;
   _u2x = u2x;
 }
@@ -224,6 +303,11 @@ void HardwareSerial::begin(long baud)
 
 void HardwareSerial::end()
 {
+  // let anything still queued go out first
+  while (_tx_buffer->head != _tx_buffer->tail && (SREG & (1 << SREG_I)))
+    ;
+
+  cbi(*_ucsrb, _udrie);
   cbi(*_ucsrb, _rxen);
   cbi(*_ucsrb, _txen);
   cbi(*_ucsrb, _rxcie);  
@@ -269,20 +353,56 @@ void HardwareSerial::flush()
   _rx_buffer->head = _rx_buffer->tail;
 }
 
+// bytes that can be written without waiting
+int HardwareSerial::availableForWrite(void)
+{
+  uint8_t head = _tx_buffer->head;
+  uint8_t tail = _tx_buffer->tail;
+
+  return (TX_BUFFER_SIZE - 1 + tail - head) % TX_BUFFER_SIZE;
+}
+
+void HardwareSerial::queue(uint8_t c)
+{
+  uint8_t head = _tx_buffer->head;
+  uint8_t i = (head + 1) % TX_BUFFER_SIZE;
+
+  // If the output buffer is full, there's nothing for it other than to
+  // wait for the interrupt handler to empty it a bit.  With interrupts
+  // disabled the handler cannot run, so do its job here.
+  while (i == _tx_buffer->tail) {
+    if (!(SREG & (1 << SREG_I)) && ((*_ucsra) & (1 << _udre)))
+      send_char(_tx_buffer, _udr, _ucsrb, _udrie);
+  }
+
+  _tx_buffer->buffer[head] = c;
+  _tx_buffer->head = i;
+}
+
 void HardwareSerial::write(uint8_t c)
 {
-  while (!((*_ucsra) & (1 << _udre)))
-    ;
+  queue(c);
+  sbi(*_ucsrb, _udrie);
+}
 
-  *_udr = c;
+void HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  // start the interrupt after the first byte so the uart is busy while
+  // the rest of the buffer is copied in
+  if (size == 0)
+    return;
+  queue(*buffer++);
+  sbi(*_ucsrb, _udrie);
+  while (--size)
+    queue(*buffer++);
 }
 
 // Preinstantiate Objects //////////////////////////////////////////////////////
 
 #if defined(UBRRH) && defined(UBRRL)
-  HardwareSerial Serial(&rx_buffer, &UBRRH, &UBRRL, &UCSRA, &UCSRB, &UDR, RXEN, TXEN, RXCIE, UDRE, U2X);
+  HardwareSerial Serial(&rx_buffer, &tx_buffer, &UBRRH, &UBRRL, &UCSRA, &UCSRB, &UDR, RXEN, TXEN, RXCIE, UDRIE, UDRE, U2X);
 #elif defined(UBRR0H) && defined(UBRR0L)
-  HardwareSerial Serial(&rx_buffer, &UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UDR0, RXEN0, TXEN0, RXCIE0, UDRE0, U2X0);
+  HardwareSerial Serial(&rx_buffer, &tx_buffer, &UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UDR0, RXEN0, TXEN0, RXCIE0, UDRIE0, UDRE0, U2X0);
 #elif defined(USBCON)
   #warning no serial port defined  (port 0)
 #else
@@ -290,13 +410,13 @@ void HardwareSerial::write(uint8_t c)
 #endif
 
 #if defined(UBRR1H)
-  HardwareSerial Serial1(&rx_buffer1, &UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UDR1, RXEN1, TXEN1, RXCIE1, UDRE1, U2X1);
+  HardwareSerial Serial1(&rx_buffer1, &tx_buffer1, &UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UDR1, RXEN1, TXEN1, RXCIE1, UDRIE1, UDRE1, U2X1);
 #endif
 #if defined(UBRR2H)
-  HardwareSerial Serial2(&rx_buffer2, &UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UDR2, RXEN2, TXEN2, RXCIE2, UDRE2, U2X2);
+  HardwareSerial Serial2(&rx_buffer2, &tx_buffer2, &UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UDR2, RXEN2, TXEN2, RXCIE2, UDRIE2, UDRE2, U2X2);
 #endif
 #if defined(UBRR3H)
-  HardwareSerial Serial3(&rx_buffer3, &UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UDR3, RXEN3, TXEN3, RXCIE3, UDRE3, U2X3);
+  HardwareSerial Serial3(&rx_buffer3, &tx_buffer3, &UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UDR3, RXEN3, TXEN3, RXCIE3, UDRIE3, UDRE3, U2X3);
 #endif
 
 #endif // whole file
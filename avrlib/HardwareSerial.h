@@ -27,11 +27,13 @@
 #include "Stream.h"
 
 struct ring_buffer;
+struct tx_ring_buffer;
 
 class HardwareSerial : public Stream
 {
   private:
     ring_buffer *_rx_buffer;
+    tx_ring_buffer *_tx_buffer;
     volatile uint8_t *_ubrrh;
     volatile uint8_t *_ubrrl;
     volatile uint8_t *_ucsra;
@@ -40,22 +42,26 @@ class HardwareSerial : public Stream
     uint8_t _rxen;
     uint8_t _txen;
     uint8_t _rxcie;
+    uint8_t _udrie;
     uint8_t _udre;
     uint8_t _u2x;
+    void queue(uint8_t);
   public:
-    HardwareSerial(ring_buffer *rx_buffer,
+    HardwareSerial(ring_buffer *rx_buffer, tx_ring_buffer *tx_buffer,
       volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
       volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
       volatile uint8_t *udr,
-      uint8_t rxen, uint8_t txen, uint8_t rxcie, uint8_t udre, uint8_t u2x);
+      uint8_t rxen, uint8_t txen, uint8_t rxcie, uint8_t udrie, uint8_t udre, uint8_t u2x);
     void begin(long);
     void end();
     virtual int available(void);
     virtual int peek(void);
     virtual int read(void);
     virtual void flush(void);
+    int availableForWrite(void);
     virtual void write(uint8_t);
-    using Print::write; // pull in write(str) and write(buf, size) from Print
+    virtual void write(const uint8_t *buffer, size_t size);
+    using Print::write; // pull in write(str) from Print
 };
 
 #if defined(UBRRH) || defined(UBRR0H)
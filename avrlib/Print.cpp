@@ -32,8 +32,7 @@
 /* default implementation: may be overridden */
 void Print::write(const char *str)
 {
-  while (*str)
-    write(*str++);
+  write((const uint8_t *)str, strlen(str));
 }
 
 /* default implementation: may be overridden */
@@ -45,9 +44,26 @@ void Print::write(const uint8_t *buffer, size_t size)
 
 void Print::print(const String &s)
 {
-  for (int i = 0; i < s.length(); i++) {
-    write(s[i]);
+  write((const uint8_t *)s.c_str(), s.length());
+}
+
+void Print::print(const __FlashStringHelper *ifsh)
+{
+  const prog_char *p = (const prog_char *)ifsh;
+  uint8_t buf[PRINT_BUFFER_SIZE];
+  uint8_t n = 0;
+  char c;
+
+  // copy out of flash a chunk at a time and hand each chunk over whole
+  while ((c = pgm_read_byte(p++)) != 0) {
+    buf[n++] = c;
+    if (n == sizeof(buf)) {
+      write(buf, n);
+      n = 0;
+    }
   }
+  if (n)
+    write(buf, n);
 }
 
 void Print::print(const char str[])
@@ -79,12 +95,12 @@ void Print::print(long n, int base)
 {
   if (base == 0) {
     write(n);
-  } else if (base == 10) {
-    if (n < 0) {
-      print('-');
-      n = -n;
-    }
-    printNumber(n, 10);
+  } else if (base == 10 && n < 0) {
+    uint8_t buf[8 * sizeof(long) + 1];
+    uint8_t *p = formatNumber(buf + sizeof(buf), -n, 10);
+
+    *--p = '-';
+    write(p, buf + sizeof(buf) - p);
   } else {
     printNumber(n, base);
   }
@@ -101,10 +117,19 @@ void Print::print(double n, int digits)
   printFloat(n, digits);
 }
 
+void Print::printFixed(long value, uint8_t decimals)
+{
+  uint8_t buf[8 * sizeof(long) + PRINT_MAX_DECIMALS + 2];
+  uint8_t *p = formatFixed(buf + sizeof(buf), value, decimals);
+
+  write(p, buf + sizeof(buf) - p);
+}
+
 void Print::println(void)
 {
-  print('\r');
-  print('\n');  
+  static const uint8_t crlf[2] = { '\r', '\n' };
+
+  write(crlf, sizeof(crlf));
 }
 
 void Print::println(const String &s)
@@ -113,6 +138,12 @@ void Print::println(const String &s)
   println();
 }
 
+void Print::println(const __FlashStringHelper *ifsh)
+{
+  print(ifsh);
+  println();
+}
+
 void Print::println(const char c[])
 {
   print(c);
@@ -161,35 +192,262 @@ void Print::println(double n, int digits)
   println();
 }
 
+void Print::printf(const __FlashStringHelper *format, ...)
+{
+  va_list ap;
+
+  va_start(ap, format);
+  vprintf(format, ap);
+  va_end(ap);
+}
+
+// output collected by vprintf() and handed to write(buf, size) when full
+struct print_buffer_t {
+  Print *out;
+  uint8_t n;
+  uint8_t buf[PRINT_BUFFER_SIZE];
+};
+
+static void print_put(print_buffer_t *b, uint8_t c)
+{
+  b->buf[b->n++] = c;
+  if (b->n == sizeof(b->buf)) {
+    b->out->write(b->buf, b->n);
+    b->n = 0;
+  }
+}
+
+static void print_pad(print_buffer_t *b, uint8_t c, int8_t count)
+{
+  while (count-- > 0)
+    print_put(b, c);
+}
+
+void Print::vprintf(const __FlashStringHelper *format, va_list ap)
+{
+  const prog_char *f = (const prog_char *)format;
+  uint8_t num[8 * sizeof(long) + PRINT_MAX_DECIMALS + 2];
+  uint8_t *end = num + sizeof(num);
+  print_buffer_t b;
+  uint8_t *p;
+  uint8_t len, fill, left, wide, flash, decimals;
+  int8_t width;
+  unsigned long n;
+  char c;
+
+  b.out = this;
+  b.n = 0;
+
+  while ((c = pgm_read_byte(f++)) != 0) {
+    if (c != '%') {
+      print_put(&b, c);
+      continue;
+    }
+
+    fill = ' ';
+    left = 0;
+    width = 0;
+    decimals = 0xff;
+    wide = 0;
+
+    // flags
+    for (;;) {
+      c = pgm_read_byte(f++);
+      if (c == '0') fill = '0';
+      else if (c == '-') left = 1;
+      else break;
+    }
+    // width and precision
+    while (c >= '0' && c <= '9') {
+      width = width * 10 + c - '0';
+      c = pgm_read_byte(f++);
+    }
+    if (c == '.') {
+      decimals = 0;
+      while ((c = pgm_read_byte(f++)) >= '0' && c <= '9')
+        decimals = decimals * 10 + c - '0';
+    }
+    // length
+    while (c == 'l' || c == 'h') {
+      if (c == 'l') wide = 1;
+      c = pgm_read_byte(f++);
+    }
+
+    flash = 0;
+    switch (c) {
+    case 'Q':
+      n = wide ? va_arg(ap, long) : (long)va_arg(ap, int);
+      p = formatFixed(end, n, decimals == 0xff ? 0 : decimals);
+      break;
+    case 'd':
+    case 'i':
+      n = wide ? va_arg(ap, long) : (long)va_arg(ap, int);
+      p = formatFixed(end, n, 0);
+      break;
+    case 'u':
+    case 'x':
+    case 'X':
+      n = wide ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+      p = formatNumber(end, n, c == 'u' ? 10 : 16);
+      // formatNumber() yields upper case digits
+      if (c == 'x')
+        for (uint8_t *q = p; q < end; q++)
+          if (*q >= 'A') *q += 'a' - 'A';
+      break;
+    case 'c':
+      p = end - 1;
+      *p = va_arg(ap, int);
+      break;
+    case 'S':
+      flash = 1;
+      // fall through
+    case 's':
+      p = (uint8_t *)va_arg(ap, char *);
+      break;
+    case '%':
+      print_put(&b, '%');
+      continue;
+    case 0:
+      f--;
+      // fall through
+    default:
+      continue;
+    }
+
+    if (c == 's' || c == 'S') {
+      len = flash ? strlen_P((const prog_char *)p) : strlen((char *)p);
+      if (decimals != 0xff && decimals < len)
+        len = decimals;
+      if (!left)
+        print_pad(&b, ' ', width - len);
+      for (uint8_t i = 0; i < len; i++)
+        print_put(&b, flash ? pgm_read_byte(p + i) : p[i]);
+    } else {
+      // a precision on the integer conversions is a minimum digit count
+      if (c != 'Q' && c != 'c' && decimals != 0xff) {
+        uint8_t negative = (*p == '-');
+
+        p += negative;
+        while (end - p < decimals && p > num + 1)
+          *--p = '0';
+        if (negative)
+          *--p = '-';
+      }
+      len = end - p;
+      if (left) {
+        fill = ' ';
+      } else if (fill == '0' && *p == '-') {
+        // zero padding goes between the sign and the digits
+        print_put(&b, *p++);
+        width--;
+        len--;
+      }
+      if (!left)
+        print_pad(&b, fill, width - len);
+      while (p < end)
+        print_put(&b, *p++);
+    }
+    if (left)
+      print_pad(&b, ' ', width - len);
+  }
+
+  if (b.n)
+    write(b.buf, b.n);
+}
+
 // Private Methods /////////////////////////////////////////////////////////////
 
-void Print::printNumber(unsigned long n, uint8_t base)
+// Divides by ten with shifts and adds; the avr has no divide instruction
+// and the general 32-bit division routine costs several hundred cycles.
+static inline unsigned long divu10(unsigned long n, uint8_t *rem)
 {
-  unsigned char buf[8 * sizeof(long)]; // Assumes 8-bit chars. 
-  unsigned long i = 0;
+  unsigned long q = (n >> 1) + (n >> 2);
+  uint8_t r;
+
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  r = n - ((q << 3) + (q << 1));
+  if (r > 9) {
+    q++;
+    r -= 10;
+  }
+  *rem = r;
+  return q;
+}
 
-  if (n == 0) {
-    print('0');
-    return;
-  } 
+// Formats n backwards from end and returns the first digit; the caller
+// supplies at least 8 * sizeof(long) bytes before end.
+uint8_t *Print::formatNumber(uint8_t *end, unsigned long n, uint8_t base)
+{
+  uint8_t digit;
+
+  if (base == 10) {
+    do {
+      n = divu10(n, &digit);
+      *--end = '0' + digit;
+    } while (n > 0);
+  } else if (base == 16) {
+    do {
+      digit = n & 0x0f;
+      n >>= 4;
+      *--end = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    } while (n > 0);
+  } else {
+    if (base < 2) base = 10;
+    do {
+      digit = n % base;
+      n /= base;
+      *--end = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    } while (n > 0);
+  }
+
+  return end;
+}
+
+// Formats value / 10^decimals backwards from end, e.g. 2375 with two
+// decimals as "23.75", using integer operations only.
+uint8_t *Print::formatFixed(uint8_t *end, long value, uint8_t decimals)
+{
+  unsigned long n = value < 0 ? -value : value;
+  uint8_t digit;
+
+  if (decimals > PRINT_MAX_DECIMALS) decimals = PRINT_MAX_DECIMALS;
 
-  while (n > 0) {
-    buf[i++] = n % base;
-    n /= base;
+  if (decimals > 0) {
+    while (decimals--) {
+      n = divu10(n, &digit);
+      *--end = '0' + digit;
+    }
+    *--end = '.';
   }
+  end = formatNumber(end, n, 10);
+  if (value < 0)
+    *--end = '-';
 
-  for (; i > 0; i--)
-    print((char) (buf[i - 1] < 10 ?
-      '0' + buf[i - 1] :
-      'A' + buf[i - 1] - 10));
+  return end;
+}
+
+void Print::printNumber(unsigned long n, uint8_t base)
+{
+  uint8_t buf[8 * sizeof(long)]; // Assumes 8-bit chars. 
+  uint8_t *p = formatNumber(buf + sizeof(buf), n, base);
+
+  write(p, buf + sizeof(buf) - p);
 }
 
 void Print::printFloat(double number, uint8_t digits) 
 { 
+  uint8_t buf[PRINT_BUFFER_SIZE + 8 * sizeof(long)];
+  uint8_t *end = buf + 8 * sizeof(long) + 1;
+  uint8_t *p;
+  uint8_t negative = 0;
+
   // Handle negative numbers
   if (number < 0.0)
   {
-     print('-');
+     negative = 1;
      number = -number;
   }
 
@@ -200,21 +458,31 @@ void Print::printFloat(double number, uint8_t digits)
   
   number += rounding;
 
-  // Extract the integer part of the number and print it
+  // Extract the integer part of the number and format it
   unsigned long int_part = (unsigned long)number;
   double remainder = number - (double)int_part;
-  print(int_part);
+  p = formatNumber(end, int_part, 10);
+  if (negative)
+    *--p = '-';
 
-  // Print the decimal point, but only if there are digits beyond
+  // Add the decimal point, but only if there are digits beyond
   if (digits > 0)
-    print("."); 
+    *end++ = '.';
 
-  // Extract digits from the remainder one at a time
+  // Extract digits from the remainder one at a time, sending the buffer
+  // whenever it fills up
   while (digits-- > 0)
   {
     remainder *= 10.0;
     int toPrint = int(remainder);
-    print(toPrint);
+    *end++ = '0' + toPrint;
     remainder -= toPrint; 
+    if (end == buf + sizeof(buf)) {
+      write(p, end - p);
+      p = end = buf;
+    }
   } 
+
+  if (end != p)
+    write(p, end - p);
 }
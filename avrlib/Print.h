@@ -21,7 +21,9 @@
 #define Print_h
 
 #include <inttypes.h>
+#include <stdarg.h>
 #include <stdio.h> // for size_t
+#include <avr/pgmspace.h>
 
 #include "WString.h"
 
@@ -31,17 +33,54 @@
 #define BIN 2
 #define BYTE 0
 
+// stack space used to batch characters into a single write(buf, size)
+#define PRINT_BUFFER_SIZE 16
+
+// largest scale accepted by printFixed()
+#define PRINT_MAX_DECIMALS 9
+
+// A string that lives in flash.  F("text") keeps a literal out of SRAM;
+// the print() overloads below read it back with pgm_read_byte().
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+// Formatted output with the format string in flash.  The literal is first
+// checked against the arguments by the compiler (-Wformat) through a call
+// that is never made, e.g.
+//
+//   PRINTF(Serial, "%02u:%02u %5d\r\n", hour, min, count);
+//
+// Supported: %d %i %u %x %X %c %s %S (string in flash) %%, the flags '-'
+// and '0', a field width, a precision and 'l' for long arguments.  %Q
+// prints an int or long as fixed point with the precision as the number
+// of decimals: %.2Q of 2375 gives "23.75".  The compiler warns about %S,
+// %Q and '0' with a precision, so formats using those go straight to
+// printf(F(...)).
+static inline void print_format_check(const char *, ...)
+  __attribute__((format(printf, 1, 2)));
+static inline void print_format_check(const char *, ...) { }
+
+#define PRINTF(out, fmt, ...) \
+  do { \
+    if (0) print_format_check(fmt, ##__VA_ARGS__); \
+    (out).printf(F(fmt), ##__VA_ARGS__); \
+  } while (0)
+
 class Print
 {
   private:
     void printNumber(unsigned long, uint8_t);
     void printFloat(double, uint8_t);
+  protected:
+    static uint8_t *formatNumber(uint8_t *, unsigned long, uint8_t);
+    static uint8_t *formatFixed(uint8_t *, long, uint8_t);
   public:
     virtual void write(uint8_t) = 0;
     virtual void write(const char *str);
     virtual void write(const uint8_t *buffer, size_t size);
     
     void print(const String &);
+    void print(const __FlashStringHelper *);
     void print(const char[]);
     void print(char, int = BYTE);
     void print(unsigned char, int = BYTE);
@@ -50,8 +89,12 @@ class Print
     void print(long, int = DEC);
     void print(unsigned long, int = DEC);
     void print(double, int = 2);
+    void printFixed(long value, uint8_t decimals);
+    void printf(const __FlashStringHelper *format, ...);
+    void vprintf(const __FlashStringHelper *format, va_list ap);
 
     void println(const String &s);
+    void println(const __FlashStringHelper *);
     void println(const char[]);
     void println(char, int = BYTE);
     void println(unsigned char, int = BYTE);
@@ -0,0 +1,76 @@
+/*
+  StaticString.h - fixed capacity String that never uses the heap
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef StaticString_h
+#define StaticString_h
+
+#include "WString.h"
+#include "Print.h"
+
+// A String holding up to N characters in its own storage.  Anything past
+// N is cut off instead of reallocated.  It is also a Print, so a reply can
+// be built with print() or PRINTF() and sent in one go:
+//
+//   StaticString<20> line;
+//   PRINTF(line, "%02u:%02u", hour, min);
+//   Serial.print(line);
+template <unsigned int N>
+class StaticString : public String, public Print
+{
+  public:
+    StaticString( const char *value = "" ) : String( _storage, N )
+    {
+      if ( value != NULL )
+        assign( value, strlen( value ) );
+    }
+    StaticString( const String &value ) : String( _storage, N )
+    {
+      assign( value.c_str(), value.length() );
+    }
+    StaticString( const StaticString &value ) : String( _storage, N )
+    {
+      assign( value._buffer, value._length );
+    }
+
+    const StaticString & operator = ( const String &rhs )
+    {
+      String::operator=( rhs );
+      return *this;
+    }
+    const StaticString & operator = ( const StaticString &rhs )
+    {
+      String::operator=( rhs );
+      return *this;
+    }
+
+    virtual void write( uint8_t c )
+    {
+      char ch = c;
+      append( &ch, 1 );
+    }
+    virtual void write( const uint8_t *buffer, size_t size )
+    {
+      append( (const char *)buffer, size );
+    }
+    using Print::write;
+
+  private:
+    char _storage[ N + 1 ];
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <avr/interrupt.h>
 
 #include "wiring.h"
+#include "pins_arduino.h"
 
 #ifdef __cplusplus
 #include "WCharacter.h"
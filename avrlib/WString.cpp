@@ -24,74 +24,121 @@
 
 String::String( const char *value )
 {
+  init();
   if ( value == NULL )
     value = "";
-  getBuffer( _length = strlen( value ) );
-  if ( _buffer != NULL )
-    strcpy( _buffer, value );
+  assign( value, strlen( value ) );
 }
 
 String::String( const String &value )
 {
-  getBuffer( _length = value._length );
-  if ( _buffer != NULL )
-    strcpy( _buffer, value._buffer );
+  init();
+  assign( value._buffer, value._length );
 }
 
 String::String( const char value )
 {
-  _length = 1;
-  getBuffer(1);
-  if ( _buffer != NULL ) {
-    _buffer[0] = value;
-    _buffer[1] = 0;
-  }
+  init();
+  assign( &value, 1 );
 }
 
 String::String( const unsigned char value )
 {
-  _length = 1;
-  getBuffer(1);
-  if ( _buffer != NULL) {
-    _buffer[0] = value;
-    _buffer[1] = 0;
-  }
+  init();
+  assign( (const char *)&value, 1 );
 }
 
 String::String( const int value, const int base )
 {
   char buf[33];   
   itoa((signed long)value, buf, base);
-  getBuffer( _length = strlen(buf) );
-  if ( _buffer != NULL )
-    strcpy( _buffer, buf );
+  init();
+  assign( buf, strlen(buf) );
 }
 
 String::String( const unsigned int value, const int base )
 {
   char buf[33];   
   ultoa((unsigned long)value, buf, base);
-  getBuffer( _length = strlen(buf) );
-  if ( _buffer != NULL )
-    strcpy( _buffer, buf );
+  init();
+  assign( buf, strlen(buf) );
 }
 
 String::String( const long value, const int base )
 {
   char buf[33];   
   ltoa(value, buf, base);
-  getBuffer( _length = strlen(buf) );
-  if ( _buffer != NULL )
-    strcpy( _buffer, buf );
+  init();
+  assign( buf, strlen(buf) );
 }
 
 String::String( const unsigned long value, const int base )
 {
   char buf[33];   
   ultoa(value, buf, 10);
-  getBuffer( _length = strlen(buf) );
-  if ( _buffer != NULL )
-    strcpy( _buffer, buf );
+  init();
+  assign( buf, strlen(buf) );
+}
+
+String::String( char *storage, unsigned int capacity )
+{
+  init();
+  _buffer = storage;
+  _buffer[0] = 0;
+  _capacity = capacity;
+  _fixed = 1;
+}
+
+String::String( const String &lhs, const String &rhs )
+{
+  init();
+  reserve( lhs._length + rhs._length );
+  assign( lhs._buffer, lhs._length );
+  append( rhs._buffer, rhs._length );
+}
+
+// make room for size characters; fails for fixed strings or when the
+// heap is exhausted, leaving the contents as they were
+unsigned char String::reserve( unsigned int size )
+{
+  char *temp;
+
+  if ( size <= _capacity )
+    return 1;
+  if ( _fixed )
+    return 0;
+
+  if ( _buffer == _inline ) {
+    temp = (char *)malloc( size + 1 );
+    if ( temp != NULL )
+      memcpy( temp, _inline, _length + 1 );
+  } else {
+    temp = (char *)realloc( _buffer, size + 1 );
+  }
+  if ( temp == NULL )
+    return 0;
+
+  _buffer = temp;
+  _capacity = size;
+  return 1;
+}
+
+// replace the contents; whatever does not fit is cut off
+void String::assign( const char *value, unsigned int length )
+{
+  if ( !reserve( length ) )
+    length = _capacity;
+  memmove( _buffer, value, length );
+  _buffer[ _length = length ] = 0;
+}
+
+// add to the end; whatever does not fit is cut off
+void String::append( const char *value, unsigned int length )
+{
+  if ( !reserve( _length + length ) )
+    length = _capacity - _length;
+  memmove( _buffer + _length, value, length );
+  _buffer[ _length += length ] = 0;
 }
 
 char String::charAt( unsigned int loc ) const
@@ -122,16 +169,7 @@ const String & String::operator=( const String &rhs )
   if ( this == &rhs )
     return *this;
 
-  if ( rhs._length > _length )
-  {
-    free(_buffer);
-    getBuffer( rhs._length );
-  }
-  
-  if ( _buffer != NULL ) {
-    _length = rhs._length;
-    strcpy( _buffer, rhs._buffer );
-  }
+  assign( rhs._buffer, rhs._length );
   return *this;
 }
 
@@ -147,19 +185,7 @@ const String & String::operator=( const String &rhs )
 
 const String & String::operator+=( const String &other )
 {
-  _length += other._length;
-  if ( _length > _capacity )
-  {
-    char *temp = (char *)realloc(_buffer, _length + 1);
-    if ( temp != NULL ) {
-      _buffer = temp;
-      _capacity = _length;
-    } else {
-      _length -= other._length;
-      return *this;
-    }
-  }
-  strcat( _buffer, other._buffer );
+  append( other._buffer, other._length );
   return *this;
 }
 
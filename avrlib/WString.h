@@ -25,6 +25,12 @@
 #include <string.h>
 #include <ctype.h>
 
+// Strings up to this many characters are held inside the object itself
+// and never touch the heap.
+#ifndef STRING_INLINE_SIZE
+#define STRING_INLINE_SIZE 10
+#endif
+
 class String
 {
   public:
@@ -37,7 +43,7 @@ class String
     String( const unsigned int, const int base=10 );
     String( const long, const int base=10 );
     String( const unsigned long, const int base=10 );
-    ~String() { free(_buffer); _length = _capacity = 0;}     //added _length = _capacity = 0;
+    ~String() { if (_buffer != _inline && !_fixed) free(_buffer); _length = _capacity = 0;}     //added _length = _capacity = 0;
 
     // operators
     const String & operator = ( const String &rhs );
@@ -68,6 +74,9 @@ class String
     int	lastIndexOf( const String &str ) const;
     int	lastIndexOf( const String &str, unsigned int fromIndex ) const;
     const unsigned int length( ) const { return _length; }
+    const char *c_str( ) const { return _buffer; }
+    unsigned char reserve( unsigned int size );
+    void clear( ) { _buffer[ _length = 0 ] = 0; }
     void setCharAt(unsigned int index, const char ch);
     unsigned char startsWith( const String &prefix ) const;
     unsigned char startsWith( const String &prefix, unsigned int toffset ) const;
@@ -82,30 +91,41 @@ class String
     const String& concat( const String &str );
     String replace( char oldChar, char newChar );
     String replace( const String& match, const String& replace );
-    friend String operator + ( String lhs, const String &rhs );
+    friend String operator + ( const String &lhs, const String &rhs );
 
   protected:
     char *_buffer;	     // the actual char array
     unsigned int _capacity;  // the array length minus one (for the '\0')
     unsigned int _length;    // the String length (not counting the '\0')
+    unsigned char _fixed;    // _buffer is caller storage that cannot grow
+    char _inline[ STRING_INLINE_SIZE + 1 ];
+
+    // fixed capacity string over storage of capacity + 1 chars
+    String( char *storage, unsigned int capacity );
+    // lhs followed by rhs, allocated once
+    String( const String &lhs, const String &rhs );
 
-    void getBuffer(unsigned int maxStrLen);
+    void init( );
+    void assign( const char *value, unsigned int length );
+    void append( const char *value, unsigned int length );
 
   private:
 
 };
 
-// allocate buffer space
-inline void String::getBuffer(unsigned int maxStrLen)
+// start out empty, in the inline buffer
+inline void String::init()
 {
-  _capacity = maxStrLen;
-  _buffer = (char *) malloc(_capacity + 1);
-  if (_buffer == NULL) _length = _capacity = 0;
+  _buffer = _inline;
+  _capacity = STRING_INLINE_SIZE;
+  _length = 0;
+  _fixed = 0;
+  _inline[0] = 0;
 }
 
-inline String operator+( String lhs, const String &rhs )
+inline String operator+( const String &lhs, const String &rhs )
 {
-  return lhs += rhs;
+  return String( lhs, rhs );
 }
 
 
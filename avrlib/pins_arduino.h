@@ -25,6 +25,8 @@
 #ifndef Pins_Arduino_h
 #define Pins_Arduino_h
 
+#include <avr/io.h>
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 
 #define NOT_A_PIN 0
@@ -59,6 +61,143 @@ const static uint8_t SS   = 10;
 const static uint8_t MOSI = 11;
 const static uint8_t MISO = 12;
 const static uint8_t SCK  = 13;
+
+// the timer 1 input capture pin (ICP1)
+#define CAPTURE_PIN 8
+#endif
+
+// port numbers used by the tables below.  these are spelled out rather
+// than the old PA..PL names, which clash with sketch level identifiers.
+#define BOARD_PORT_A 1
+#define BOARD_PORT_B 2
+#define BOARD_PORT_C 3
+#define BOARD_PORT_D 4
+#define BOARD_PORT_E 5
+#define BOARD_PORT_F 6
+#define BOARD_PORT_G 7
+#define BOARD_PORT_H 8
+#define BOARD_PORT_J 10
+#define BOARD_PORT_K 11
+#define BOARD_PORT_L 12
+
+// Board descriptions.  A board is one table of PIN(number, port, bit,
+// timer) rows in pin order plus the list of ports it uses.  pins_arduino.c
+// expands the same table into the PROGMEM arrays used for run-time pin
+// numbers, and the inline functions further down expand it into switch
+// statements that the compiler folds away for constant pin numbers.
+// Adding a board means adding a table here.
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+#define NUM_DIGITAL_PINS 70
+
+#define BOARD_PORTS(PORT) \
+	PORT(A) PORT(B) PORT(C) PORT(D) PORT(E) PORT(F) \
+	PORT(G) PORT(H) PORT(J) PORT(K) PORT(L)
+
+#define BOARD_PINS(PIN) \
+	PIN( 0, E, 0, NOT_ON_TIMER) /* USART0_RX */ \
+	PIN( 1, E, 1, NOT_ON_TIMER) /* USART0_TX */ \
+	PIN( 2, E, 4, TIMER3B     ) /* PWM2      */ \
+	PIN( 3, E, 5, TIMER3C     ) /* PWM3      */ \
+	PIN( 4, G, 5, TIMER0B     ) /* PWM4      */ \
+	PIN( 5, E, 3, TIMER3A     ) /* PWM5      */ \
+	PIN( 6, H, 3, TIMER4A     ) /* PWM6      */ \
+	PIN( 7, H, 4, TIMER4B     ) /* PWM7      */ \
+	PIN( 8, H, 5, TIMER4C     ) /* PWM8      */ \
+	PIN( 9, H, 6, TIMER2B     ) /* PWM9      */ \
+	PIN(10, B, 4, TIMER2A     ) /* PWM10     */ \
+	PIN(11, B, 5, TIMER1A     ) /* PWM11     */ \
+	PIN(12, B, 6, TIMER1B     ) /* PWM12     */ \
+	PIN(13, B, 7, TIMER0A     ) /* PWM13     */ \
+	PIN(14, J, 1, NOT_ON_TIMER) /* USART3_TX */ \
+	PIN(15, J, 0, NOT_ON_TIMER) /* USART3_RX */ \
+	PIN(16, H, 1, NOT_ON_TIMER) /* USART2_TX */ \
+	PIN(17, H, 0, NOT_ON_TIMER) /* USART2_RX */ \
+	PIN(18, D, 3, NOT_ON_TIMER) /* USART1_TX */ \
+	PIN(19, D, 2, NOT_ON_TIMER) /* USART1_RX */ \
+	PIN(20, D, 1, NOT_ON_TIMER) /* I2C_SDA   */ \
+	PIN(21, D, 0, NOT_ON_TIMER) /* I2C_SCL   */ \
+	PIN(22, A, 0, NOT_ON_TIMER) /* D22       */ \
+	PIN(23, A, 1, NOT_ON_TIMER) /* D23       */ \
+	PIN(24, A, 2, NOT_ON_TIMER) /* D24       */ \
+	PIN(25, A, 3, NOT_ON_TIMER) /* D25       */ \
+	PIN(26, A, 4, NOT_ON_TIMER) /* D26       */ \
+	PIN(27, A, 5, NOT_ON_TIMER) /* D27       */ \
+	PIN(28, A, 6, NOT_ON_TIMER) /* D28       */ \
+	PIN(29, A, 7, NOT_ON_TIMER) /* D29       */ \
+	PIN(30, C, 7, NOT_ON_TIMER) /* D30       */ \
+	PIN(31, C, 6, NOT_ON_TIMER) /* D31       */ \
+	PIN(32, C, 5, NOT_ON_TIMER) /* D32       */ \
+	PIN(33, C, 4, NOT_ON_TIMER) /* D33       */ \
+	PIN(34, C, 3, NOT_ON_TIMER) /* D34       */ \
+	PIN(35, C, 2, NOT_ON_TIMER) /* D35       */ \
+	PIN(36, C, 1, NOT_ON_TIMER) /* D36       */ \
+	PIN(37, C, 0, NOT_ON_TIMER) /* D37       */ \
+	PIN(38, D, 7, NOT_ON_TIMER) /* D38       */ \
+	PIN(39, G, 2, NOT_ON_TIMER) /* D39       */ \
+	PIN(40, G, 1, NOT_ON_TIMER) /* D40       */ \
+	PIN(41, G, 0, NOT_ON_TIMER) /* D41       */ \
+	PIN(42, L, 7, NOT_ON_TIMER) /* D42       */ \
+	PIN(43, L, 6, NOT_ON_TIMER) /* D43       */ \
+	PIN(44, L, 5, TIMER5C     ) /* D44       */ \
+	PIN(45, L, 4, TIMER5B     ) /* D45       */ \
+	PIN(46, L, 3, TIMER5A     ) /* D46       */ \
+	PIN(47, L, 2, NOT_ON_TIMER) /* D47       */ \
+	PIN(48, L, 1, NOT_ON_TIMER) /* D48       */ \
+	PIN(49, L, 0, NOT_ON_TIMER) /* D49       */ \
+	PIN(50, B, 3, NOT_ON_TIMER) /* SPI_MISO  */ \
+	PIN(51, B, 2, NOT_ON_TIMER) /* SPI_MOSI  */ \
+	PIN(52, B, 1, NOT_ON_TIMER) /* SPI_SCK   */ \
+	PIN(53, B, 0, NOT_ON_TIMER) /* SPI_SS    */ \
+	PIN(54, F, 0, NOT_ON_TIMER) /* A0        */ \
+	PIN(55, F, 1, NOT_ON_TIMER) /* A1        */ \
+	PIN(56, F, 2, NOT_ON_TIMER) /* A2        */ \
+	PIN(57, F, 3, NOT_ON_TIMER) /* A3        */ \
+	PIN(58, F, 4, NOT_ON_TIMER) /* A4        */ \
+	PIN(59, F, 5, NOT_ON_TIMER) /* A5        */ \
+	PIN(60, F, 6, NOT_ON_TIMER) /* A6        */ \
+	PIN(61, F, 7, NOT_ON_TIMER) /* A7        */ \
+	PIN(62, K, 0, NOT_ON_TIMER) /* A8        */ \
+	PIN(63, K, 1, NOT_ON_TIMER) /* A9        */ \
+	PIN(64, K, 2, NOT_ON_TIMER) /* A10       */ \
+	PIN(65, K, 3, NOT_ON_TIMER) /* A11       */ \
+	PIN(66, K, 4, NOT_ON_TIMER) /* A12       */ \
+	PIN(67, K, 5, NOT_ON_TIMER) /* A13       */ \
+	PIN(68, K, 6, NOT_ON_TIMER) /* A14       */ \
+	PIN(69, K, 7, NOT_ON_TIMER) /* A15       */
+
+#else
+#define NUM_DIGITAL_PINS 20
+
+#define BOARD_PORTS(PORT) PORT(B) PORT(C) PORT(D)
+
+// the ATmega168/328 have pwm on pins 3, 5 and 6; the ATmega8 does not
+#if defined(__AVR_ATmega8__)
+#define BOARD_ATMEGA8(mega8, mega168) mega8
+#else
+#define BOARD_ATMEGA8(mega8, mega168) mega168
+#endif
+
+#define BOARD_PINS(PIN) \
+	PIN( 0, D, 0, NOT_ON_TIMER) \
+	PIN( 1, D, 1, NOT_ON_TIMER) \
+	PIN( 2, D, 2, NOT_ON_TIMER) \
+	PIN( 3, D, 3, BOARD_ATMEGA8(NOT_ON_TIMER, TIMER2B)) \
+	PIN( 4, D, 4, NOT_ON_TIMER) \
+	PIN( 5, D, 5, BOARD_ATMEGA8(NOT_ON_TIMER, TIMER0B)) \
+	PIN( 6, D, 6, BOARD_ATMEGA8(NOT_ON_TIMER, TIMER0A)) \
+	PIN( 7, D, 7, NOT_ON_TIMER) \
+	PIN( 8, B, 0, NOT_ON_TIMER) \
+	PIN( 9, B, 1, TIMER1A) \
+	PIN(10, B, 2, TIMER1B) \
+	PIN(11, B, 3, BOARD_ATMEGA8(TIMER2, TIMER2A)) \
+	PIN(12, B, 4, NOT_ON_TIMER) \
+	PIN(13, B, 5, NOT_ON_TIMER) \
+	PIN(14, C, 0, NOT_ON_TIMER) \
+	PIN(15, C, 1, NOT_ON_TIMER) \
+	PIN(16, C, 2, NOT_ON_TIMER) \
+	PIN(17, C, 3, NOT_ON_TIMER) \
+	PIN(18, C, 4, NOT_ON_TIMER) \
+	PIN(19, C, 5, NOT_ON_TIMER)
 #endif
 
 // On the ATmega1280, the addresses of some of the port registers are
@@ -72,17 +211,279 @@ extern const uint8_t PROGMEM digital_pin_to_port_PGM[];
 extern const uint8_t PROGMEM digital_pin_to_bit_mask_PGM[];
 extern const uint8_t PROGMEM digital_pin_to_timer_PGM[];
 
+// Compile-time lookups generated from the board description.  These are
+// only worth calling with a constant argument, where the switch collapses
+// to the single matching value.
+#define BOARD_CASE_PORT(n, port, bit, timer) case n: return BOARD_PORT_##port;
+#define BOARD_CASE_BIT_MASK(n, port, bit, timer) case n: return _BV(bit);
+#define BOARD_CASE_TIMER(n, port, bit, timer) case n: return timer;
+#define BOARD_CASE_OUTPUT(port) case BOARD_PORT_##port: return &PORT##port;
+#define BOARD_CASE_INPUT(port) case BOARD_PORT_##port: return &PIN##port;
+#define BOARD_CASE_MODE(port) case BOARD_PORT_##port: return &DDR##port;
+#define BOARD_CASE_LOW_IO(port) case BOARD_PORT_##port: return _SFR_IO_REG_P(PORT##port);
+
+static inline uint8_t digitalPinToPortConst(uint8_t pin) __attribute__ ((always_inline));
+static inline uint8_t digitalPinToPortConst(uint8_t pin)
+{
+	switch (pin) { BOARD_PINS(BOARD_CASE_PORT) }
+	return NOT_A_PIN;
+}
+
+static inline uint8_t digitalPinToBitMaskConst(uint8_t pin) __attribute__ ((always_inline));
+static inline uint8_t digitalPinToBitMaskConst(uint8_t pin)
+{
+	switch (pin) { BOARD_PINS(BOARD_CASE_BIT_MASK) }
+	return 0;
+}
+
+static inline uint8_t digitalPinToTimerConst(uint8_t pin) __attribute__ ((always_inline));
+static inline uint8_t digitalPinToTimerConst(uint8_t pin)
+{
+	switch (pin) { BOARD_PINS(BOARD_CASE_TIMER) }
+	return NOT_ON_TIMER;
+}
+
+static inline volatile uint8_t *portOutputRegisterConst(uint8_t port) __attribute__ ((always_inline));
+static inline volatile uint8_t *portOutputRegisterConst(uint8_t port)
+{
+	switch (port) { BOARD_PORTS(BOARD_CASE_OUTPUT) }
+	return 0;
+}
+
+static inline volatile uint8_t *portInputRegisterConst(uint8_t port) __attribute__ ((always_inline));
+static inline volatile uint8_t *portInputRegisterConst(uint8_t port)
+{
+	switch (port) { BOARD_PORTS(BOARD_CASE_INPUT) }
+	return 0;
+}
+
+static inline volatile uint8_t *portModeRegisterConst(uint8_t port) __attribute__ ((always_inline));
+static inline volatile uint8_t *portModeRegisterConst(uint8_t port)
+{
+	switch (port) { BOARD_PORTS(BOARD_CASE_MODE) }
+	return 0;
+}
+
+// true when the port sits in the low i/o space, where sbi/cbi are atomic
+static inline uint8_t portIsLowIOConst(uint8_t port) __attribute__ ((always_inline));
+static inline uint8_t portIsLowIOConst(uint8_t port)
+{
+	switch (port) { BOARD_PORTS(BOARD_CASE_LOW_IO) }
+	return 0;
+}
+
 // Get the bit location within the hardware port of the given virtual pin.
-// This comes from the pins_*.c file for the active board configuration.
+// Constant pin numbers resolve at compile time; anything else is read
+// from the PROGMEM tables generated in pins_arduino.c.
 // 
 // These perform slightly better as macros compared to inline functions
 //
-#define digitalPinToPort(P) ( pgm_read_byte( digital_pin_to_port_PGM + (P) ) )
-#define digitalPinToBitMask(P) ( pgm_read_byte( digital_pin_to_bit_mask_PGM + (P) ) )
-#define digitalPinToTimer(P) ( pgm_read_byte( digital_pin_to_timer_PGM + (P) ) )
+#define digitalPinToPort(P) ( __builtin_constant_p(P) ? digitalPinToPortConst(P) : \
+	pgm_read_byte( digital_pin_to_port_PGM + (P) ) )
+#define digitalPinToBitMask(P) ( __builtin_constant_p(P) ? digitalPinToBitMaskConst(P) : \
+	pgm_read_byte( digital_pin_to_bit_mask_PGM + (P) ) )
+#define digitalPinToTimer(P) ( __builtin_constant_p(P) ? digitalPinToTimerConst(P) : \
+	pgm_read_byte( digital_pin_to_timer_PGM + (P) ) )
 #define analogInPinToBit(P) (P)
-#define portOutputRegister(P) ( (volatile uint8_t *)( pgm_read_word( port_to_output_PGM + (P))) )
-#define portInputRegister(P) ( (volatile uint8_t *)( pgm_read_word( port_to_input_PGM + (P))) )
-#define portModeRegister(P) ( (volatile uint8_t *)( pgm_read_word( port_to_mode_PGM + (P))) )
+#define portOutputRegister(P) ( __builtin_constant_p(P) ? portOutputRegisterConst(P) : \
+	&_MMIO_BYTE( pgm_read_word( port_to_output_PGM + (P))) )
+#define portInputRegister(P) ( __builtin_constant_p(P) ? portInputRegisterConst(P) : \
+	&_MMIO_BYTE( pgm_read_word( port_to_input_PGM + (P))) )
+#define portModeRegister(P) ( __builtin_constant_p(P) ? portModeRegisterConst(P) : \
+	&_MMIO_BYTE( pgm_read_word( port_to_mode_PGM + (P))) )
+
+// The *Fast() calls below collapse to a single sbi/cbi/sbis instruction
+// for a constant pin number.  Anything else falls through to the table
+// driven functions.
+#define digitalPinIsConst(P) (__builtin_constant_p(P) && (P) < NUM_DIGITAL_PINS)
+#define digitalPinToOutputReg(P) portOutputRegisterConst(digitalPinToPortConst(P))
+#define digitalPinToInputReg(P) portInputRegisterConst(digitalPinToPortConst(P))
+#define digitalPinToModeReg(P) portModeRegisterConst(digitalPinToPortConst(P))
+
+// constant folded counterpart of turnOffPWM() in wiring_digital.c
+static inline void turnOffPWMConst(uint8_t timer) __attribute__ ((always_inline));
+static inline void turnOffPWMConst(uint8_t timer)
+{
+	switch (timer)
+	{
+		#if defined(TCCR1A) && defined(COM1A1)
+		case TIMER1A:   TCCR1A &= ~_BV(COM1A1);    break;
+		#endif
+		#if defined(TCCR1A) && defined(COM1B1)
+		case TIMER1B:   TCCR1A &= ~_BV(COM1B1);    break;
+		#endif
+		#if defined(TCCR2) && defined(COM21)
+		case  TIMER2:   TCCR2 &= ~_BV(COM21);      break;
+		#endif
+		#if defined(TCCR0A) && defined(COM0A1)
+		case  TIMER0A:  TCCR0A &= ~_BV(COM0A1);    break;
+		#endif
+		#if defined(TCCR0A) && defined(COM0B1)
+		case  TIMER0B:  TCCR0A &= ~_BV(COM0B1);    break;
+		#endif
+		#if defined(TCCR2A) && defined(COM2A1)
+		case  TIMER2A:  TCCR2A &= ~_BV(COM2A1);    break;
+		#endif
+		#if defined(TCCR2A) && defined(COM2B1)
+		case  TIMER2B:  TCCR2A &= ~_BV(COM2B1);    break;
+		#endif
+		#if defined(TCCR3A) && defined(COM3A1)
+		case  TIMER3A:  TCCR3A &= ~_BV(COM3A1);    break;
+		case  TIMER3B:  TCCR3A &= ~_BV(COM3B1);    break;
+		case  TIMER3C:  TCCR3A &= ~_BV(COM3C1);    break;
+		#endif
+		#if defined(TCCR4A) && defined(COM4A1)
+		case  TIMER4A:  TCCR4A &= ~_BV(COM4A1);    break;
+		case  TIMER4B:  TCCR4A &= ~_BV(COM4B1);    break;
+		case  TIMER4C:  TCCR4A &= ~_BV(COM4C1);    break;
+		#endif
+		#if defined(TCCR5A) && defined(COM5A1)
+		case  TIMER5A:  TCCR5A &= ~_BV(COM5A1);    break;
+		case  TIMER5B:  TCCR5A &= ~_BV(COM5B1);    break;
+		case  TIMER5C:  TCCR5A &= ~_BV(COM5C1);    break;
+		#endif
+	}
+}
+
+// read-modify-write of a constant pin register.  ports in the low i/o
+// space compile to a single sbi/cbi; the extended ports on the ATmega1280
+// need interrupts off like digitalWrite() does.  SREG is volatile, so it
+// is only read on that path.
+#define digitalPinRegWriteBitConst(P, REG, V) \
+	do { \
+		if (V) *REG(P) |= digitalPinToBitMaskConst(P); \
+		else *REG(P) &= ~digitalPinToBitMaskConst(P); \
+	} while (0)
+
+#define digitalPinRegWriteConst(P, REG, V) \
+	do { \
+		if (portIsLowIOConst(digitalPinToPortConst(P))) { \
+			digitalPinRegWriteBitConst(P, REG, V); \
+		} else { \
+			uint8_t _sreg = SREG; \
+			cli(); \
+			digitalPinRegWriteBitConst(P, REG, V); \
+			SREG = _sreg; \
+		} \
+	} while (0)
+
+// digitalWriteFast() turns off pwm like digitalWrite() does; for pins
+// without a timer that check disappears at compile time.
+#define digitalWriteFast(P, V) \
+	do { \
+		if (digitalPinIsConst(P) && __builtin_constant_p(V)) { \
+			turnOffPWMConst(digitalPinToTimerConst(P)); \
+			digitalPinRegWriteConst(P, digitalPinToOutputReg, V); \
+		} else { \
+			digitalWrite((P), (V)); \
+		} \
+	} while (0)
+
+#define pinModeFast(P, M) \
+	do { \
+		if (digitalPinIsConst(P) && __builtin_constant_p(M)) { \
+			digitalPinRegWriteConst(P, digitalPinToModeReg, M); \
+		} else { \
+			pinMode((P), (M)); \
+		} \
+	} while (0)
+
+// The shift*Fast() calls inline the bit loop with sbi/cbi when both pins
+// are constant.  The MOSI/SCK and MISO/SCK pairs go to the buffer
+// functions instead, which shift them with the spi hardware; so does
+// anything not constant.  Input is read after the rising clock edge,
+// like shiftIn().
+#define shiftPinsAreConst(dataPin, clockPin, spiPin) \
+	(digitalPinIsConst(dataPin) && digitalPinIsConst(clockPin) && \
+	 !((dataPin) == (spiPin) && (clockPin) == SCK))
+
+#define shiftOutByteConst(dataPin, clockPin, bitOrder, val) \
+	do { \
+		uint8_t _v = (val); \
+		uint8_t _i; \
+		for (_i = 0; _i < 8; _i++) { \
+			if ((bitOrder) == LSBFIRST) { \
+				digitalPinRegWriteConst(dataPin, digitalPinToOutputReg, _v & 0x01); \
+				_v >>= 1; \
+			} else { \
+				digitalPinRegWriteConst(dataPin, digitalPinToOutputReg, _v & 0x80); \
+				_v <<= 1; \
+			} \
+			digitalPinRegWriteConst(clockPin, digitalPinToOutputReg, HIGH); \
+			digitalPinRegWriteConst(clockPin, digitalPinToOutputReg, LOW); \
+		} \
+	} while (0)
+
+#define shiftInByteConst(dataPin, clockPin, bitOrder) \
+	({ \
+		uint8_t _v = 0; \
+		uint8_t _i; \
+		for (_i = 0; _i < 8; _i++) { \
+			digitalPinRegWriteConst(clockPin, digitalPinToOutputReg, HIGH); \
+			if ((bitOrder) == LSBFIRST) { \
+				_v >>= 1; \
+				if (*digitalPinToInputReg(dataPin) & digitalPinToBitMaskConst(dataPin)) _v |= 0x80; \
+			} else { \
+				_v <<= 1; \
+				if (*digitalPinToInputReg(dataPin) & digitalPinToBitMaskConst(dataPin)) _v |= 0x01; \
+			} \
+			digitalPinRegWriteConst(clockPin, digitalPinToOutputReg, LOW); \
+		} \
+		_v; \
+	})
+
+#define shiftOutFast(dataPin, clockPin, bitOrder, val) \
+	do { \
+		if (shiftPinsAreConst(dataPin, clockPin, MOSI)) { \
+			turnOffPWMConst(digitalPinToTimerConst(dataPin)); \
+			turnOffPWMConst(digitalPinToTimerConst(clockPin)); \
+			shiftOutByteConst(dataPin, clockPin, bitOrder, val); \
+		} else { \
+			shiftOut((dataPin), (clockPin), (bitOrder), (val)); \
+		} \
+	} while (0)
+
+#define shiftOutBufferFast(dataPin, clockPin, bitOrder, buf, len) \
+	do { \
+		if (shiftPinsAreConst(dataPin, clockPin, MOSI)) { \
+			const uint8_t *_b = (buf); \
+			uint16_t _n = (len); \
+			turnOffPWMConst(digitalPinToTimerConst(dataPin)); \
+			turnOffPWMConst(digitalPinToTimerConst(clockPin)); \
+			while (_n--) \
+				shiftOutByteConst(dataPin, clockPin, bitOrder, *_b++); \
+		} else { \
+			shiftOutBuffer((dataPin), (clockPin), (bitOrder), (buf), (len)); \
+		} \
+	} while (0)
+
+#define shiftInFast(dataPin, clockPin, bitOrder) \
+	(shiftPinsAreConst(dataPin, clockPin, MISO) ? \
+		({ \
+			turnOffPWMConst(digitalPinToTimerConst(dataPin)); \
+			turnOffPWMConst(digitalPinToTimerConst(clockPin)); \
+			shiftInByteConst(dataPin, clockPin, bitOrder); \
+		}) : \
+		shiftIn((dataPin), (clockPin), (bitOrder)))
+
+#define shiftInBufferFast(dataPin, clockPin, bitOrder, buf, len) \
+	do { \
+		if (shiftPinsAreConst(dataPin, clockPin, MISO)) { \
+			uint8_t *_b = (buf); \
+			uint16_t _n = (len); \
+			turnOffPWMConst(digitalPinToTimerConst(dataPin)); \
+			turnOffPWMConst(digitalPinToTimerConst(clockPin)); \
+			while (_n--) \
+				*_b++ = shiftInByteConst(dataPin, clockPin, bitOrder); \
+		} else { \
+			shiftInBuffer((dataPin), (clockPin), (bitOrder), (buf), (len)); \
+		} \
+	} while (0)
+
+// unlike digitalRead(), the constant path leaves pwm running on the pin
+#define digitalReadFast(P) \
+	(digitalPinIsConst(P) ? \
+		((*digitalPinToInputReg(P) & digitalPinToBitMaskConst(P)) ? HIGH : LOW) : \
+		digitalRead(P))
 
 #endif
@@ -22,6 +22,7 @@
   $Id$
 */
 
+#include <util/delay_basic.h>
 #include "wiring_private.h"
 
 // the prescaler is set so that timer0 ticks every 64 clock cycles, and the
@@ -102,12 +103,74 @@ unsigned long micros() {
 	return ((m << 8) + t) * (64 / clockCyclesPerMicrosecond());
 }
 
+static voidFuncPtr yield_hook = 0;
+static volatile uint8_t yield_busy = 0;
+
+void yieldHook(void (*hook)(void))
+{
+	yield_hook = hook;
+}
+
+void yield(void)
+{
+	voidFuncPtr hook = yield_hook;
+
+	// the hook may itself wait (serial output, i2c, a nested delay());
+	// those waits must not call back into it.
+	if (hook == 0 || yield_busy)
+		return;
+
+	yield_busy = 1;
+	hook();
+	yield_busy = 0;
+}
+
+void deadlineSet(deadline_t *d, unsigned long ms)
+{
+	d->start = millis();
+	d->length = ms;
+}
+
+boolean deadlineExpired(const deadline_t *d)
+{
+	return (millis() - d->start) >= d->length;
+}
+
+unsigned long deadlineRemaining(const deadline_t *d)
+{
+	unsigned long elapsed = millis() - d->start;
+
+	return (elapsed >= d->length) ? 0 : d->length - elapsed;
+}
+
+void deadlineWait(const deadline_t *d)
+{
+	while (!deadlineExpired(d))
+		yield();
+}
+
+boolean waitFor(boolean (*ready)(void), unsigned long ms)
+{
+	deadline_t d;
+
+	deadlineSet(&d, ms);
+	while (!ready()) {
+		if (deadlineExpired(&d))
+			return false;
+		yield();
+	}
+	return true;
+}
+
+// the yield hook runs while waiting, so delay() keeps its own microsecond
+// reference and catches up on any milliseconds the hook used.
 void delay(unsigned long ms)
 {
-	uint16_t start = (uint16_t)micros();
+	unsigned long start = micros();
 
 	while (ms > 0) {
-		if (((uint16_t)micros() - start) >= 1000) {
+		yield();
+		while (ms > 0 && (micros() - start) >= 1000) {
 			ms--;
 			start += 1000;
 		}
@@ -158,10 +221,15 @@ void delayMicroseconds(unsigned int us)
 #endif
 
 	// busy wait
+#if defined(__AVR__)
 	__asm__ __volatile__ (
 		"1: sbiw %0,1" "\n\t" // 2 cycles
 		"brne 1b" : "=w" (us) : "0" (us) // 2 cycles
 	);
+#else
+	// the same four cycle loop, for the host build's virtual clock
+	_delay_loop_2(us);
+#endif
 }
 
 void init()
@@ -266,13 +334,10 @@ void init()
 #endif
 
 #if defined(ADCSRA)
-	// set a2d prescale factor to 128
-	// 16 MHz / 128 = 125 KHz, inside the desired 50-200 KHz range.
-	// XXX: this will not work properly for other clock speeds, and
-	// this code should use F_CPU to determine the prescale factor.
-	sbi(ADCSRA, ADPS2);
-	sbi(ADCSRA, ADPS1);
-	sbi(ADCSRA, ADPS0);
+	// set the a2d prescale factor from F_CPU so the adc clock lands
+	// inside the 50-200 KHz range needed for full 10 bit resolution
+	// (16 MHz / 128 = 125 KHz, 8 MHz / 64 = 125 KHz, 20 MHz / 128 = 156 KHz).
+	ADCSRA = (ADCSRA & ~ADC_PRESCALE_MASK) | ADC_PRESCALE_PRECISE;
 
 	// enable a2d conversions
 	sbi(ADCSRA, ADEN);
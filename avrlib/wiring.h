@@ -67,6 +67,10 @@ extern "C"{
 #define DEFAULT 1
 #define EXTERNAL 0
 
+// adc clock profiles for analogProfile()
+#define ADC_PRECISE 0
+#define ADC_FAST 1
+
 // undefine stdlib's abs if encountered
 #ifdef abs
 #undef abs
@@ -111,16 +115,72 @@ void digitalWrite(uint8_t, uint8_t);
 int digitalRead(uint8_t);
 int analogRead(uint8_t);
 void analogReference(uint8_t mode);
+void analogProfile(uint8_t profile);
 void analogWrite(uint8_t, int);
 
+// background adc scanning: registered channels are converted round-robin
+// by the adc interrupt and read back from a results table.  each channel
+// keeps the analogProfile() that was active when it was added.
+#define ADC_SCAN_MAX_CHANNELS 8
+#define ADC_SCAN_MAX_OVERSAMPLE 64
+
+uint8_t analogScanAdd(uint8_t pin, uint8_t oversample);
+void analogScanClear(void);
+void analogScanStart(void);
+void analogScanStop(void);
+int analogScanRead(uint8_t pin);
+unsigned long analogScanTime(uint8_t pin);
+uint8_t analogScanCount(uint8_t pin);
+
+// sram usage.  freeMemory() counts the gap between heap and stack plus
+// the heap's free list; stackHighWater() is the deepest the stack has
+// been since reset, in bytes.
+int freeMemory(void);
+unsigned int heapTop(void);
+unsigned int largestFreeBlock(void);
+unsigned int stackUnused(void);
+unsigned int stackHighWater(void);
+
 unsigned long millis(void);
 unsigned long micros(void);
 void delay(unsigned long);
 void delayMicroseconds(unsigned int us);
+
+// timed waits.  while waiting, delay(), deadlineWait() and waitFor() call
+// the function registered with yieldHook() so other work can carry on.
+typedef struct {
+	unsigned long start;
+	unsigned long length;
+} deadline_t;
+
+void yieldHook(void (*hook)(void));
+void yield(void);
+void deadlineSet(deadline_t *d, unsigned long ms);
+boolean deadlineExpired(const deadline_t *d);
+unsigned long deadlineRemaining(const deadline_t *d);
+void deadlineWait(const deadline_t *d);
+boolean waitFor(boolean (*ready)(void), unsigned long ms);
 unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout);
 
+// timer 1 input capture on CAPTURE_PIN.  pulse captures are started and
+// then polled until they finish; frequency capture runs continuously and
+// reports the average frequency in millihertz since the previous read.
+#define CAPTURE_IDLE 0
+#define CAPTURE_BUSY 1
+#define CAPTURE_DONE 2
+#define CAPTURE_TIMEOUT 3
+
+uint8_t pulseCaptureStart(uint8_t state, unsigned long timeout);
+uint8_t pulseCapturePoll(unsigned long *width);
+uint8_t frequencyCaptureStart(uint8_t edge);
+unsigned long frequencyCaptureRead(void);
+uint8_t captureActive(void);
+void captureEnd(void);
+
 void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
 uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
+void shiftOutBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, const uint8_t *buf, uint16_t len);
+void shiftInBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t *buf, uint16_t len);
 
 void attachInterrupt(uint8_t, void (*)(void), int mode);
 void detachInterrupt(uint8_t);
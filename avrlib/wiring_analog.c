@@ -28,25 +28,58 @@
 #include "pins_arduino.h"
 
 uint8_t analog_reference = DEFAULT;
+static uint8_t analog_prescale = ADC_PRESCALE_PRECISE;
 
-void analogReference(uint8_t mode)
-{
-	// can't actually set the register here because the default setting
-	// will connect AVCC and the AREF pin, which would cause a short if
-	// there's something connected to AREF.
-	analog_reference = mode;
-}
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+#define ADC_NUM_CHANNELS 16
+#else
+#define ADC_NUM_CHANNELS 8
+#endif
 
-int analogRead(uint8_t pin)
-{
-	uint8_t low, high;
+#define ADC_SCAN_NO_SLOT 0xff
+
+// one entry per registered channel.  the isr accumulates oversample
+// conversions into sum and publishes the total to value, stamping it
+// with millis() and bumping count.  the division is left to the reader
+// to keep the isr short; it shares the cpu with the software serial
+// receive interrupts.
+typedef struct {
+	uint8_t channel;
+	uint8_t prescale;
+	uint8_t oversample;
+	uint8_t taken;
+	uint16_t sum;
+	volatile uint16_t value;
+	volatile unsigned long stamp;
+	volatile uint8_t count;
+} adc_scan_slot_t;
+
+static adc_scan_slot_t adc_scan_slots[ADC_SCAN_MAX_CHANNELS];
+static uint8_t adc_scan_map[ADC_NUM_CHANNELS] = {
+	ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT,
+	ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT,
+#if ADC_NUM_CHANNELS > 8
+	ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT,
+	ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT, ADC_SCAN_NO_SLOT,
+#endif
+};
+static volatile uint8_t adc_scan_used = 0;
+static volatile uint8_t adc_scan_current = 0;
+static volatile uint8_t adc_scan_discard = 0;
+static volatile uint8_t adc_scan_running = 0;
 
+static uint8_t adc_channel(uint8_t pin)
+{
 #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
 	if (pin >= 54) pin -= 54; // allow for channel or pin numbers
 #else
 	if (pin >= 14) pin -= 14; // allow for channel or pin numbers
 #endif
+	return pin & (ADC_NUM_CHANNELS - 1);
+}
 
+static void adc_select(uint8_t pin)
+{
 #if defined(ADCSRB) && defined(MUX5)
 	// the MUX5 bit of ADCSRB selects whether we're reading from channels
 	// 0 to 7 (MUX5 low) or 8 to 15 (MUX5 high).
@@ -59,6 +92,238 @@ int analogRead(uint8_t pin)
 #if defined(ADMUX)
 	ADMUX = (analog_reference << 6) | (pin & 0x07);
 #endif
+}
+
+#if defined(ADCSRA) && defined(ADCL)
+// point the mux at the current slot and start a conversion.  the sample
+// and hold capacitor needs a conversion to settle after the mux (or the
+// reference) moves, so the first result on each channel is thrown away.
+static void adc_scan_arm(void)
+{
+	adc_scan_slot_t *s = &adc_scan_slots[adc_scan_current];
+
+	adc_select(s->channel);
+	adc_scan_discard = 1;
+
+	// writing a one to ADIF clears any stale completion flag
+	ADCSRA = (ADCSRA & ~ADC_PRESCALE_MASK) | s->prescale |
+		_BV(ADIF) | _BV(ADIE) | _BV(ADSC);
+}
+
+SIGNAL(ADC_vect)
+{
+	uint8_t low, high;
+	adc_scan_slot_t *s;
+
+	low  = ADCL;
+	high = ADCH;
+
+	if (!adc_scan_running || adc_scan_used == 0) {
+		cbi(ADCSRA, ADIE);
+		return;
+	}
+
+	if (adc_scan_discard) {
+		adc_scan_discard = 0;
+		sbi(ADCSRA, ADSC);
+		return;
+	}
+
+	s = &adc_scan_slots[adc_scan_current];
+	s->sum += (high << 8) | low;
+	if (++s->taken < s->oversample) {
+		sbi(ADCSRA, ADSC);
+		return;
+	}
+
+	s->value = s->sum;
+	s->stamp = millis();
+	s->count++;
+	s->sum = 0;
+	s->taken = 0;
+
+	if (adc_scan_used == 1) {
+		// a single channel never moves the mux, so no settling needed
+		sbi(ADCSRA, ADSC);
+		return;
+	}
+
+	if (++adc_scan_current >= adc_scan_used)
+		adc_scan_current = 0;
+	adc_scan_arm();
+}
+#endif
+
+uint8_t analogScanAdd(uint8_t pin, uint8_t oversample)
+{
+	uint8_t ch = adc_channel(pin);
+	uint8_t slot, oldSREG;
+	adc_scan_slot_t *s;
+
+	// the accumulator is 16 bits, so 64 ten bit samples is the limit
+	if (oversample == 0) oversample = 1;
+	if (oversample > ADC_SCAN_MAX_OVERSAMPLE) oversample = ADC_SCAN_MAX_OVERSAMPLE;
+
+	oldSREG = SREG;
+	cli();
+	slot = adc_scan_map[ch];
+	if (slot == ADC_SCAN_NO_SLOT) {
+		if (adc_scan_used >= ADC_SCAN_MAX_CHANNELS) {
+			SREG = oldSREG;
+			return 0;
+		}
+		slot = adc_scan_used++;
+		adc_scan_map[ch] = slot;
+	}
+	s = &adc_scan_slots[slot];
+	s->channel = ch;
+	s->prescale = analog_prescale;
+	s->oversample = oversample;
+	s->taken = 0;
+	s->sum = 0;
+	s->value = 0;
+	s->count = 0;
+	SREG = oldSREG;
+
+	return 1;
+}
+
+void analogScanClear(void)
+{
+	uint8_t i;
+
+	analogScanStop();
+	for (i = 0; i < ADC_NUM_CHANNELS; i++)
+		adc_scan_map[i] = ADC_SCAN_NO_SLOT;
+	adc_scan_used = 0;
+	adc_scan_current = 0;
+}
+
+void analogScanStart(void)
+{
+#if defined(ADCSRA) && defined(ADCL)
+	uint8_t oldSREG;
+
+	if (adc_scan_used == 0 || adc_scan_running)
+		return;
+
+	oldSREG = SREG;
+	cli();
+	// let any conversion started by analogRead() finish first
+	while (bit_is_set(ADCSRA, ADSC));
+	adc_scan_current = 0;
+	adc_scan_running = 1;
+	adc_scan_arm();
+	SREG = oldSREG;
+#endif
+}
+
+void analogScanStop(void)
+{
+#if defined(ADCSRA) && defined(ADCL)
+	uint8_t oldSREG = SREG;
+
+	cli();
+	adc_scan_running = 0;
+	cbi(ADCSRA, ADIE);
+	SREG = oldSREG;
+
+	// the conversion in flight completes on its own; wait it out so
+	// the next user of the adc starts from a clean state.
+	while (bit_is_set(ADCSRA, ADSC));
+	sbi(ADCSRA, ADIF);
+	adc_scan_slots[adc_scan_current].sum = 0;
+	adc_scan_slots[adc_scan_current].taken = 0;
+#endif
+}
+
+int analogScanRead(uint8_t pin)
+{
+	uint8_t slot = adc_scan_map[adc_channel(pin)];
+	uint8_t oldSREG, n;
+	uint16_t v;
+
+	if (slot == ADC_SCAN_NO_SLOT)
+		return -1;
+
+	// the isr writes the value a byte at a time
+	oldSREG = SREG;
+	cli();
+	v = adc_scan_slots[slot].value;
+	n = adc_scan_slots[slot].oversample;
+	SREG = oldSREG;
+
+	return (v + (n >> 1)) / n;
+}
+
+unsigned long analogScanTime(uint8_t pin)
+{
+	uint8_t slot = adc_scan_map[adc_channel(pin)];
+	uint8_t oldSREG;
+	unsigned long t;
+
+	if (slot == ADC_SCAN_NO_SLOT)
+		return 0;
+
+	oldSREG = SREG;
+	cli();
+	t = adc_scan_slots[slot].stamp;
+	SREG = oldSREG;
+
+	return t;
+}
+
+uint8_t analogScanCount(uint8_t pin)
+{
+	uint8_t slot = adc_scan_map[adc_channel(pin)];
+
+	if (slot == ADC_SCAN_NO_SLOT)
+		return 0;
+	return adc_scan_slots[slot].count;
+}
+
+void analogReference(uint8_t mode)
+{
+	// can't actually set the register here because the default setting
+	// will connect AVCC and the AREF pin, which would cause a short if
+	// there's something connected to AREF.
+	analog_reference = mode;
+}
+
+// pick the adc clock used by analogRead() and by channels added to the
+// scan from now on.  ADC_PRECISE keeps the adc clock within the 10 bit
+// range; ADC_FAST runs it near 1 MHz, where only the top 8 bits of the
+// result are meaningful but a conversion takes about 13 us.
+void analogProfile(uint8_t profile)
+{
+	analog_prescale = (profile == ADC_FAST) ?
+		ADC_PRESCALE_FAST : ADC_PRESCALE_PRECISE;
+}
+
+int analogRead(uint8_t pin)
+{
+	uint8_t low, high;
+	uint8_t ch = adc_channel(pin);
+	uint8_t scanning = adc_scan_running;
+
+	if (scanning) {
+		uint8_t slot = adc_scan_map[ch];
+
+		// a scanned channel is just a table lookup once the first
+		// average has been published
+		if (slot != ADC_SCAN_NO_SLOT) {
+			while (adc_scan_slots[slot].count == 0);
+			return analogScanRead(pin);
+		}
+
+		// otherwise borrow the adc and resume the scan afterwards
+		analogScanStop();
+	}
+
+	adc_select(ch);
+#if defined(ADCSRA)
+	ADCSRA = (ADCSRA & ~ADC_PRESCALE_MASK) | analog_prescale;
+#endif
 
 	// without a delay, we seem to read from the wrong channel
 	//delay(1);
@@ -82,6 +347,9 @@ int analogRead(uint8_t pin)
 	high = 0;
 #endif
 
+	if (scanning)
+		analogScanStart();
+
 	// combine the two bytes
 	return (high << 8) | low;
 }
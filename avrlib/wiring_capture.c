@@ -0,0 +1,218 @@
+/*
+  wiring_capture.c - timer 1 input capture pulse and frequency measurement
+  Part of Arduino - http://www.arduino.cc/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  $Id$
+*/
+
+#include "wiring_private.h"
+#include "pins_arduino.h"
+
+// Timer 1 is taken out of its pwm mode while a capture is running, so
+// analogWrite() on the timer 1 pins has no effect until captureEnd().
+// The timer runs free with a prescaler of 8 (0.5 us per tick at 16 MHz)
+// and its overflow count extends the 16 bit capture register to 32 bits.
+
+#if defined(CAPTURE_PIN) && defined(TIMSK1) && defined(ICIE1)
+
+#define CAPTURE_PRESCALE 8
+
+#define CAPTURE_STATE_IDLE 0
+#define CAPTURE_STATE_PULSE_START 1
+#define CAPTURE_STATE_PULSE_END 2
+#define CAPTURE_STATE_PULSE_DONE 3
+#define CAPTURE_STATE_FREQUENCY 4
+
+static volatile uint8_t capture_state = CAPTURE_STATE_IDLE;
+static volatile uint16_t capture_overflows;
+static volatile unsigned long capture_first;
+static volatile unsigned long capture_width;
+static volatile unsigned long capture_sum;
+static volatile uint16_t capture_count;
+static volatile uint8_t capture_primed;
+static unsigned long capture_started;
+static unsigned long capture_timeout;
+static unsigned long capture_frequency;
+
+SIGNAL(TIMER1_OVF_vect)
+{
+	capture_overflows++;
+}
+
+SIGNAL(TIMER1_CAPT_vect)
+{
+	uint16_t icr = ICR1;
+	uint16_t high = capture_overflows;
+	unsigned long t;
+
+	// an overflow that is still pending belongs before this capture if
+	// the captured count is in the bottom half of the timer range
+	if (bit_is_set(TIFR1, TOV1) && icr < 0x8000)
+		high++;
+	t = ((unsigned long)high << 16) | icr;
+
+	switch (capture_state) {
+	case CAPTURE_STATE_PULSE_START:
+		capture_first = t;
+		TCCR1B ^= _BV(ICES1);
+		// changing the edge can raise a spurious capture flag
+		TIFR1 = _BV(ICF1);
+		capture_state = CAPTURE_STATE_PULSE_END;
+		break;
+	case CAPTURE_STATE_PULSE_END:
+		capture_width = t - capture_first;
+		capture_state = CAPTURE_STATE_PULSE_DONE;
+		cbi(TIMSK1, ICIE1);
+		break;
+	case CAPTURE_STATE_FREQUENCY:
+		// the sum holds about 35 minutes of ticks; past that, or 65535
+		// periods, later periods are left out until the next read
+		if (capture_primed && capture_count != 0xffff &&
+		    capture_sum + (t - capture_first) >= capture_sum) {
+			capture_sum += t - capture_first;
+			capture_count++;
+		}
+		capture_first = t;
+		capture_primed = 1;
+		break;
+	}
+}
+
+static unsigned long captureTicksToMicroseconds(unsigned long ticks)
+{
+	return (ticks * CAPTURE_PRESCALE) / clockCyclesPerMicrosecond();
+}
+
+static void captureBegin(uint8_t rising)
+{
+	uint8_t oldSREG = SREG;
+
+	cli();
+	TIMSK1 &= ~(_BV(ICIE1) | _BV(TOIE1));
+	TCCR1A = 0;
+	// normal mode, noise canceler on, prescale factor 8
+	TCCR1B = _BV(ICNC1) | _BV(CS11) | (rising ? _BV(ICES1) : 0);
+	TCNT1 = 0;
+	capture_overflows = 0;
+	capture_primed = 0;
+	capture_sum = 0;
+	capture_count = 0;
+	TIFR1 = _BV(ICF1) | _BV(TOV1);
+	TIMSK1 |= _BV(ICIE1) | _BV(TOIE1);
+	SREG = oldSREG;
+}
+
+void captureEnd(void)
+{
+	uint8_t oldSREG = SREG;
+
+	cli();
+	TIMSK1 &= ~(_BV(ICIE1) | _BV(TOIE1));
+	capture_state = CAPTURE_STATE_IDLE;
+
+	// back to the configuration init() leaves timer 1 in: prescale
+	// factor 64, 8-bit phase correct pwm
+	TCCR1B = _BV(CS11) | _BV(CS10);
+	TCCR1A = _BV(WGM10);
+	SREG = oldSREG;
+}
+
+uint8_t captureActive(void)
+{
+	return capture_state != CAPTURE_STATE_IDLE;
+}
+
+uint8_t pulseCaptureStart(uint8_t state, unsigned long timeout)
+{
+	if (capture_state == CAPTURE_STATE_FREQUENCY)
+		return 0;
+
+	pinModeFast(CAPTURE_PIN, INPUT);
+	capture_state = CAPTURE_STATE_PULSE_START;
+	capture_started = micros();
+	capture_timeout = timeout;
+	// a HIGH pulse starts on the rising edge, a LOW one on the falling
+	captureBegin(state != LOW);
+	return 1;
+}
+
+uint8_t pulseCapturePoll(unsigned long *width)
+{
+	unsigned long w;
+	uint8_t oldSREG;
+
+	switch (capture_state) {
+	case CAPTURE_STATE_PULSE_DONE:
+		oldSREG = SREG;
+		cli();
+		w = capture_width;
+		SREG = oldSREG;
+		captureEnd();
+		if (width) *width = captureTicksToMicroseconds(w);
+		return CAPTURE_DONE;
+	case CAPTURE_STATE_PULSE_START:
+	case CAPTURE_STATE_PULSE_END:
+		if (capture_timeout && micros() - capture_started >= capture_timeout) {
+			captureEnd();
+			return CAPTURE_TIMEOUT;
+		}
+		return CAPTURE_BUSY;
+	}
+	return CAPTURE_IDLE;
+}
+
+uint8_t frequencyCaptureStart(uint8_t edge)
+{
+	if (capture_state != CAPTURE_STATE_IDLE &&
+	    capture_state != CAPTURE_STATE_FREQUENCY)
+		return 0;
+
+	pinModeFast(CAPTURE_PIN, INPUT);
+	capture_state = CAPTURE_STATE_FREQUENCY;
+	capture_frequency = 0;
+	captureBegin(edge != FALLING);
+	return 1;
+}
+
+unsigned long frequencyCaptureRead(void)
+{
+	unsigned long sum;
+	uint16_t count;
+	uint8_t oldSREG;
+
+	if (capture_state != CAPTURE_STATE_FREQUENCY)
+		return 0;
+
+	oldSREG = SREG;
+	cli();
+	sum = capture_sum;
+	count = capture_count;
+	capture_sum = 0;
+	capture_count = 0;
+	SREG = oldSREG;
+
+	// average over every period seen since the last read; with no new
+	// edges the previous result stands
+	if (count && sum) {
+		sum = (sum + count / 2) / count;
+		capture_frequency = ((F_CPU / CAPTURE_PRESCALE) * 1000UL + sum / 2) / sum;
+	}
+	return capture_frequency;
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+  wiring_memory.c - free memory, heap and stack usage
+  Part of Arduino - http://www.arduino.cc/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General
+  Public License along with this library; if not, write to the
+  Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+  Boston, MA  02111-1307  USA
+
+  $Id$
+*/
+
+#include <stdlib.h>
+#include "wiring_private.h"
+
+// The heap grows up from the end of .bss and the stack grows down from
+// RAMEND.  Everything between the two is painted with STACK_CANARY before
+// main() runs; bytes that still hold the pattern were never reached by
+// either, which gives the deepest the stack has ever been.
+
+#define STACK_CANARY 0xc5
+
+extern char _end;
+extern char __heap_start;
+extern char *__brkval;
+extern size_t __malloc_margin;
+
+// avr-libc's free list; not in any header, but the symbol is global
+struct __freelist {
+	size_t sz;
+	struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+void memoryPaint(void) __attribute__((naked, used, section(".init1")));
+
+// runs straight after reset, before the stack or r1 are set up, so it
+// may only use registers
+void memoryPaint(void)
+{
+	__asm__ __volatile__ (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(%1)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(%1)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		: : "M" (STACK_CANARY), "i" (RAMEND)
+	);
+}
+
+static char *memory_heap_top(void)
+{
+	return __brkval ? __brkval : &__heap_start;
+}
+
+unsigned int heapTop(void)
+{
+	return (unsigned int)memory_heap_top();
+}
+
+int freeMemory(void)
+{
+	struct __freelist *fp;
+	int total = (char *)SP - memory_heap_top();
+
+	// blocks returned to the heap below its top can be reused too
+	for (fp = __flp; fp; fp = fp->nx)
+		total += fp->sz + sizeof(size_t);
+	return total;
+}
+
+unsigned int largestFreeBlock(void)
+{
+	struct __freelist *fp;
+	unsigned int largest = 0;
+	int gap;
+
+	for (fp = __flp; fp; fp = fp->nx)
+		if (fp->sz > largest)
+			largest = fp->sz;
+
+	// malloc() keeps __malloc_margin bytes clear below the stack pointer
+	gap = (char *)SP - __malloc_margin - memory_heap_top() - sizeof(size_t);
+	if (gap > 0 && (unsigned int)gap > largest)
+		largest = gap;
+	return largest;
+}
+
+unsigned int stackUnused(void)
+{
+	const uint8_t *p = (const uint8_t *)memory_heap_top();
+	unsigned int n = 0;
+
+	// memory the heap released keeps its old contents, so this can only
+	// under-report
+	while (p <= (const uint8_t *)RAMEND && *p++ == STACK_CANARY)
+		n++;
+	return n;
+}
+
+unsigned int stackHighWater(void)
+{
+	return RAMEND + 1 - (unsigned int)memory_heap_top() - stackUnused();
+}
@@ -61,6 +61,21 @@ extern "C"{
 
 typedef void (*voidFuncPtr)(void);
 
+// ADPS2:0 value for the smallest adc prescaler that keeps the adc clock
+// at or below f.  the datasheet wants 50-200 KHz for 10 bit results;
+// up to about 1 MHz still gives 8 good bits.
+#define ADC_PRESCALE_FOR(f) \
+	((F_CPU / 2 <= (f)) ? 1 : \
+	 (F_CPU / 4 <= (f)) ? 2 : \
+	 (F_CPU / 8 <= (f)) ? 3 : \
+	 (F_CPU / 16 <= (f)) ? 4 : \
+	 (F_CPU / 32 <= (f)) ? 5 : \
+	 (F_CPU / 64 <= (f)) ? 6 : 7)
+
+#define ADC_PRESCALE_MASK (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))
+#define ADC_PRESCALE_PRECISE ADC_PRESCALE_FOR(200000L)
+#define ADC_PRESCALE_FAST ADC_PRESCALE_FOR(1000000L)
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
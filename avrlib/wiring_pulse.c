@@ -31,11 +31,28 @@
  * before the start of the pulse. */
 unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout)
 {
+#if defined(CAPTURE_PIN) && defined(TIMSK1) && defined(ICIE1)
+	// on the input capture pin let timer 1 time the edges instead; this
+	// is exact even with interrupts firing, but needs them enabled.  a
+	// timeout of 0 gives up at once in the loops below, where to the
+	// capture it would mean no timeout at all.
+	if (pin == CAPTURE_PIN && timeout && bit_is_set(SREG, SREG_I) &&
+	    pulseCaptureStart(state, timeout)) {
+		unsigned long us = 0;
+		uint8_t result;
+
+		while ((result = pulseCapturePoll(&us)) == CAPTURE_BUSY)
+			;
+		return (result == CAPTURE_DONE) ? us : 0;
+	}
+#endif
+
 	// cache the port and bit of the pin in order to speed up the
 	// pulse width measuring loop and achieve finer resolution.  calling
 	// digitalRead() instead yields much coarser resolution.
 	uint8_t bit = digitalPinToBitMask(pin);
 	uint8_t port = digitalPinToPort(pin);
+	volatile uint8_t *reg = portInputRegister(port);
 	uint8_t stateMask = (state ? bit : 0);
 	unsigned long width = 0; // keep initialization out of time critical area
 	
@@ -45,17 +62,17 @@ unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout)
 	unsigned long maxloops = microsecondsToClockCycles(timeout) / 16;
 	
 	// wait for any previous pulse to end
-	while ((*portInputRegister(port) & bit) == stateMask)
+	while ((*reg & bit) == stateMask)
 		if (numloops++ == maxloops)
 			return 0;
 	
 	// wait for the pulse to start
-	while ((*portInputRegister(port) & bit) != stateMask)
+	while ((*reg & bit) != stateMask)
 		if (numloops++ == maxloops)
 			return 0;
 	
 	// wait for the pulse to stop
-	while ((*portInputRegister(port) & bit) == stateMask) {
+	while ((*reg & bit) == stateMask) {
 		if (numloops++ == maxloops)
 			return 0;
 		width++;
@@ -23,33 +23,160 @@
 */
 
 #include "wiring_private.h"
+#include "pins_arduino.h"
 
-uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
-	uint8_t value = 0;
+// the port registers and masks are looked up once per call rather than
+// once per bit as digitalWrite()/digitalRead() would.
+typedef struct {
+	volatile uint8_t *data;
+	uint8_t dataMask;
+	volatile uint8_t *clock;
+	uint8_t clockMask;
+} shift_pins_t;
+
+static uint8_t shift_resolve(shift_pins_t *p, uint8_t dataPin, uint8_t clockPin, uint8_t input)
+{
+	uint8_t dataPort = digitalPinToPort(dataPin);
+	uint8_t clockPort = digitalPinToPort(clockPin);
+
+	if (dataPort == NOT_A_PIN || clockPort == NOT_A_PIN) return 0;
+
+	// digitalRead() disconnects pwm from a pin without changing its
+	// output, which is what digitalWrite() would have done on the first bit
+	if (digitalPinToTimer(dataPin) != NOT_ON_TIMER) digitalRead(dataPin);
+	if (digitalPinToTimer(clockPin) != NOT_ON_TIMER) digitalRead(clockPin);
+
+	p->data = input ? portInputRegister(dataPort) : portOutputRegister(dataPort);
+	p->dataMask = digitalPinToBitMask(dataPin);
+	p->clock = portOutputRegister(clockPort);
+	p->clockMask = digitalPinToBitMask(clockPin);
+	return 1;
+}
+
+// other pins on the same port may be driven from interrupts (software
+// serial, tone), so each read-modify-write is done with them off.
+static inline void shift_write(volatile uint8_t *reg, uint8_t mask, uint8_t high)
+{
+	uint8_t oldSREG = SREG;
+
+	cli();
+	if (high)
+		*reg |= mask;
+	else
+		*reg &= ~mask;
+	SREG = oldSREG;
+}
+
+#if defined(SPCR) && defined(SPDR)
+// The spi peripheral shifts a byte in 2 us at F_CPU / 4, with the clock
+// idling low like the bit-banged version.  Output uses mode 0: data is
+// set before the rising edge, where the other end samples it.  Input
+// uses mode 1: the bit-banged version reads just after raising the
+// clock, so it gets the bit a shift register moves out on that edge,
+// and mode 1 samples it on the falling edge that follows.  the spi is
+// only borrowed when nobody else has it enabled and SS is already an
+// output; with SS as an input the hardware could drop out of master mode.
+static uint8_t shift_spi_begin(uint8_t bitOrder, uint8_t input)
+{
+	if (SPCR & _BV(SPE)) return 0;
+	if (!(*portModeRegister(digitalPinToPort(SS)) & digitalPinToBitMask(SS))) return 0;
+
+	SPCR = _BV(SPE) | _BV(MSTR) | (bitOrder == LSBFIRST ? _BV(DORD) : 0) |
+		(input ? _BV(CPHA) : 0);
+	return 1;
+}
+
+static inline uint8_t shift_spi_transfer(uint8_t val)
+{
+	SPDR = val;
+	while (!(SPSR & _BV(SPIF)));
+	return SPDR;
+}
+
+static inline void shift_spi_end(void)
+{
+	// hand the pins back to the port registers
+	SPCR = 0;
+}
+#endif
+
+void shiftInBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t *buf, uint16_t len)
+{
+	shift_pins_t p;
+	uint8_t value;
 	uint8_t i;
 
-	for (i = 0; i < 8; ++i) {
-		digitalWrite(clockPin, HIGH);
-		if (bitOrder == LSBFIRST)
-			value |= digitalRead(dataPin) << i;
-		else
-			value |= digitalRead(dataPin) << (7 - i);
-		digitalWrite(clockPin, LOW);
+#if defined(SPCR) && defined(SPDR)
+	if (dataPin == MISO && clockPin == SCK && shift_spi_begin(bitOrder, 1)) {
+		// while reading, the spi also drives MOSI if it is an output;
+		// shifting out its current level keeps it where it was
+		value = (*portOutputRegister(digitalPinToPort(MOSI)) & digitalPinToBitMask(MOSI)) ? 0xff : 0;
+		while (len--)
+			*buf++ = shift_spi_transfer(value);
+		shift_spi_end();
+		return;
+	}
+#endif
+
+	if (!shift_resolve(&p, dataPin, clockPin, 1)) {
+		while (len--)
+			*buf++ = 0;
+		return;
+	}
+
+	while (len--) {
+		value = 0;
+		for (i = 0; i < 8; ++i) {
+			shift_write(p.clock, p.clockMask, HIGH);
+			if (bitOrder == LSBFIRST)
+				value |= ((*p.data & p.dataMask) ? 1 : 0) << i;
+			else
+				value |= ((*p.data & p.dataMask) ? 1 : 0) << (7 - i);
+			shift_write(p.clock, p.clockMask, LOW);
+		}
+		*buf++ = value;
 	}
-	return value;
 }
 
-void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+void shiftOutBuffer(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, const uint8_t *buf, uint16_t len)
 {
+	shift_pins_t p;
+	uint8_t val;
 	uint8_t i;
 
-	for (i = 0; i < 8; i++)  {
-		if (bitOrder == LSBFIRST)
-			digitalWrite(dataPin, !!(val & (1 << i)));
-		else	
-			digitalWrite(dataPin, !!(val & (1 << (7 - i))));
-			
-		digitalWrite(clockPin, HIGH);
-		digitalWrite(clockPin, LOW);		
+#if defined(SPCR) && defined(SPDR)
+	if (dataPin == MOSI && clockPin == SCK && shift_spi_begin(bitOrder, 0)) {
+		while (len--)
+			shift_spi_transfer(*buf++);
+		shift_spi_end();
+		return;
+	}
+#endif
+
+	if (!shift_resolve(&p, dataPin, clockPin, 0)) return;
+
+	while (len--) {
+		val = *buf++;
+		for (i = 0; i < 8; i++)  {
+			if (bitOrder == LSBFIRST)
+				shift_write(p.data, p.dataMask, val & (1 << i));
+			else	
+				shift_write(p.data, p.dataMask, val & (1 << (7 - i)));
+				
+			shift_write(p.clock, p.clockMask, HIGH);
+			shift_write(p.clock, p.clockMask, LOW);		
+		}
 	}
 }
+
+uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
+	uint8_t value;
+
+	shiftInBuffer(dataPin, clockPin, bitOrder, &value, 1);
+	return value;
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+{
+	shiftOutBuffer(dataPin, clockPin, bitOrder, &val, 1);
+}
@@ -0,0 +1,600 @@
+/*
+ * bench.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hal.h"
+#include "hal_board.h"
+
+/**
+ * Loop benchmark.  Runs the app's main() (built as aq_main) against the
+ * board devices on the virtual clock and measures, after a warm-up:
+ *
+ * - each stage of the main loop, by wrapping the calls main.c makes at
+ *   link time; a stage's time includes whatever runs inside it, such as
+ *   the console served from PH.sample()'s delay;
+ * - the loop period, from one TEMP.sample() to the next;
+ * - command latency: "r" is typed every BENCH_COMMAND_INTERVAL and timed
+ *   from its CR arriving to the first byte and the end of the reply line;
+ * - bytes per second on the USART, the TWI bus and both soft serial lines.
+ *
+ * Each stage gets two times.  The i/o time is virtual (see hal.h): the
+ * bus transfers and waits, with computation free.  The cpu time comes
+ * from a cost model: the HAL counts every instruction the program runs
+ * while measuring, interrupt handlers included, and each costs
+ * BENCH_CYCLES_PER_INSTRUCTION AVR cycles.  That factor stands for an
+ * 8 bit core doing the work of one x86-64 instruction, so the cpu times
+ * are estimates; they move with the code, which is what the compare
+ * needs.  Wait loops the clock skips are not counted, but a handler that
+ * runs during a wait is, so on the chip the two overlap there.  Each
+ * counted instruction is a trap, so only the first BENCH_CPU_LOOPS loops
+ * after the warm-up are counted.
+ *
+ * Results go to a flat JSON file, one key per line, which a later run
+ * compares against:
+ *
+ *   aqbench [-s seconds] [-w warmup] [-k cycles] [-l loops] [-o results.json]
+ *   aqbench -c baseline.json results.json [-t percent]
+ *
+ * The compare exits 1 if any time grew by more than the tolerance.
+ */
+#define BENCH_SECONDS			30.0
+#define BENCH_WARMUP			3.0
+#define BENCH_TOLERANCE			5.0			// percent
+#define BENCH_CYCLES_PER_INSTRUCTION	3.0		// AVR cycles per counted instruction
+#define BENCH_CPU_LOOPS			2			// loops with instructions counted
+#define BENCH_COMMAND			"r\r"
+#define BENCH_COMMAND_INTERVAL	(F_CPU * 137 / 100)	// out of step with the loop
+#define BENCH_LATENCIES			256
+#define BENCH_LINE				128
+#define BENCH_DATE_LENGTH		19
+#define BENCH_KEYS				128
+
+int aq_main();
+
+/**
+ * Main loop stages, in the order main.c runs them
+ */
+enum BenchStage
+{
+	STAGE_CONSOLE_POLL,
+	STAGE_RTC_READ,
+	STAGE_TEMP_SAMPLE,
+	STAGE_PH_SAMPLE,
+	STAGE_CHECKPOINT,
+	STAGE_HISTORY,
+	STAGE_TELEMETRY,
+	STAGE_LOGGER_ADD,
+	STAGE_LCD_PH,
+	STAGE_LCD_TEMP,
+	STAGE_LCD_TIME,
+	STAGE_LCD_DATE,
+	STAGE_COUNT
+};
+
+static const char *stageNames[STAGE_COUNT] = {
+	"console_poll", "rtc_read", "temp_sample", "ph_sample", "checkpoint",
+	"history", "telemetry", "logger_add", "lcd_ph", "lcd_temp", "lcd_time",
+	"lcd_date"
+};
+
+struct BenchTimes
+{
+	uint32_t count;
+	uint64_t total;
+	uint64_t max;
+	uint32_t counted;			// of count, those with instructions counted
+	uint64_t instructions;
+
+	void add( uint64_t cycles )
+	{
+		count++;
+		total += cycles;
+		max = cycles > max ? cycles : max;
+	}
+
+	void addInstructions( uint64_t n )
+	{
+		counted++;
+		instructions += n;
+	}
+};
+
+static double toMs( double cycles )
+{
+	return cycles * 1000.0 / F_CPU;
+}
+
+static int compareCycles( const void *a, const void *b )
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * The harness is a device on the board: it types the commands, watches
+ * the serial port and writes the results when the run ends.
+ */
+class Bench : public HalDevice
+{
+public:
+	Bench() : output( "bench.json" ), seconds( BENCH_SECONDS ), warmup( BENCH_WARMUP ),
+		cyclesPerInstruction( BENCH_CYCLES_PER_INSTRUCTION ), cpuLoops( BENCH_CPU_LOOPS ),
+		commandAt( HAL_NEVER ) {}
+
+	void reset();
+	/** Starts typing commands, and measuring, after the warm-up */
+	void begin() { commandAt = (uint64_t)(warmup * F_CPU); }
+	uint64_t next();
+	void event( uint64_t now );
+	void serialOut( uint8_t c );
+	void finish();
+
+	void stageStart( uint8_t stage );
+	void stageEnd( uint8_t stage );
+
+	const char *output;
+	double seconds;
+	double warmup;
+	double cyclesPerInstruction;
+	uint32_t cpuLoops;
+
+private:
+	void start();
+	void report( FILE *f );
+	void line( FILE *f, const char *key, double value );
+	double cpuMs( double instructions );
+
+	bool measuring;
+	bool counting;
+	uint8_t depth;				// stages open, the outermost timed
+	uint64_t started;
+	uint64_t startedInstructions;
+	BenchTimes stages[STAGE_COUNT];
+
+	uint64_t lastLoop;
+	uint64_t lastLoopInstructions;
+	BenchTimes loops;
+	uint64_t loopMin;
+
+	uint64_t commandAt;
+	uint64_t receivedAt;
+	bool pending;
+	uint32_t sent;
+	uint32_t lost;
+	uint8_t lineBytes[BENCH_LINE];
+	uint64_t lineTimes[BENCH_LINE];
+	uint8_t lineLength;
+	uint64_t latencies[BENCH_LATENCIES];
+	uint64_t responses[BENCH_LATENCIES];
+	uint16_t answered;
+
+	// counters when measuring started
+	uint64_t from;
+	HalStats stats;
+	uint32_t rtcBytes;
+	uint32_t eepromBytes;
+	uint32_t phBytes;
+	uint32_t lcdBytes;
+};
+
+static Bench bench;
+
+void Bench::reset()
+{
+	measuring = false;
+	counting = false;
+	depth = 0;
+	memset( stages, 0, sizeof(stages) );
+	memset( &loops, 0, sizeof(loops) );
+	lastLoop = 0;
+	lastLoopInstructions = 0;
+	loopMin = HAL_NEVER;
+	pending = false;
+	sent = lost = 0;
+	lineLength = 0;
+	answered = 0;
+}
+
+uint64_t Bench::next()
+{
+	return commandAt;
+}
+
+void Bench::event( uint64_t now )
+{
+	if( !measuring )
+	{
+		start();
+	}
+
+	// an unanswered command is lost once the next is due
+	if( pending )
+	{
+		lost++;
+	}
+
+	hal_serial_input( (const uint8_t *)BENCH_COMMAND, strlen( BENCH_COMMAND ) );
+	receivedAt = now + strlen( BENCH_COMMAND ) * hal_serial_char_cycles();
+	pending = true;
+	lineLength = 0;
+	sent++;
+	commandAt = now + BENCH_COMMAND_INTERVAL;
+}
+
+void Bench::start()
+{
+	measuring = true;
+	from = hal_now();
+	stats = *hal_stats();
+	rtcBytes = hal_ds1307.bytesIn + hal_ds1307.bytesOut;
+	eepromBytes = hal_24lc256.bytesIn + hal_24lc256.bytesOut;
+	phBytes = hal_ph_stamp.bytesIn + hal_ph_stamp.bytesOut;
+	lcdBytes = hal_lcd.bytesIn;
+}
+
+/**
+ * Finds the reply among the telemetry frames by its " epoch "; the reply
+ * starts with the date, "2011-07-23 10:00:04".
+ */
+void Bench::serialOut( uint8_t c )
+{
+	if( !pending )
+	{
+		return;
+	}
+	// telemetry frames can run long between newlines; keep the latest half
+	if( lineLength == BENCH_LINE )
+	{
+		lineLength = BENCH_LINE / 2;
+		memmove( lineBytes, lineBytes + lineLength, lineLength );
+		memmove( lineTimes, lineTimes + lineLength, lineLength * sizeof(lineTimes[0]) );
+	}
+	lineBytes[lineLength] = c;
+	lineTimes[lineLength++] = hal_now();
+	if( c != '\n' )
+	{
+		return;
+	}
+
+	// frames carry zeros, so no string functions
+	const uint8_t *epoch = (const uint8_t *)memmem( lineBytes, lineLength, " epoch ", 7 );
+	int first = epoch ? epoch - lineBytes - BENCH_DATE_LENGTH : -1;
+
+	if( first >= 0 && lineBytes[first] == '2' )
+	{
+		if( answered < BENCH_LATENCIES )
+		{
+			latencies[answered] = lineTimes[first] - receivedAt;
+			responses[answered] = hal_now() - receivedAt;
+			answered++;
+		}
+		pending = false;
+	}
+	lineLength = 0;
+}
+
+/**
+ * Only the calls main.c makes from its loop are stages; a clock read from
+ * the checkpoint or an "r" command, or the console served from a delay,
+ * counts towards the stage it runs inside.
+ */
+void Bench::stageStart( uint8_t stage )
+{
+	if( depth++ )
+	{
+		return;
+	}
+	started = hal_now();
+	startedInstructions = hal_instructions();
+
+	if( stage == STAGE_TEMP_SAMPLE )
+	{
+		if( measuring && lastLoop >= from )
+		{
+			uint64_t period = started - lastLoop;
+
+			loops.add( period );
+			loopMin = period < loopMin ? period : loopMin;
+		}
+		lastLoop = started;
+
+		// instructions are counted over whole loops, the first measured
+		if( counting )
+		{
+			loops.addInstructions( startedInstructions - lastLoopInstructions );
+		}
+		if( measuring && loops.counted < cpuLoops )
+		{
+			if( !counting )
+			{
+				hal_count_instructions( true );
+				counting = true;
+			}
+		}
+		else if( counting )
+		{
+			hal_count_instructions( false );
+			counting = false;
+		}
+		lastLoopInstructions = startedInstructions = hal_instructions();
+	}
+}
+
+void Bench::stageEnd( uint8_t stage )
+{
+	if( --depth == 0 && measuring && started >= from )
+	{
+		stages[stage].add( hal_now() - started );
+		if( counting )
+		{
+			stages[stage].addInstructions( hal_instructions() - startedInstructions );
+		}
+	}
+}
+
+void Bench::finish()
+{
+	FILE *f = fopen( output, "w" );
+
+	if( !f )
+	{
+		perror( output );
+		return;
+	}
+	report( f );
+	fclose( f );
+	report( stdout );
+}
+
+void Bench::line( FILE *f, const char *key, double value )
+{
+	if( f == stdout )
+	{
+		fprintf( f, "  %-36s %12.3f\n", key, value );
+	}
+	else
+	{
+		fprintf( f, "  \"%s\": %.6g,\n", key, value );
+	}
+}
+
+double Bench::cpuMs( double instructions )
+{
+	return toMs( instructions * cyclesPerInstruction );
+}
+
+void Bench::report( FILE *f )
+{
+	double elapsed = measuring ? (hal_now() - from) / (double)F_CPU : 0;
+	uint32_t samples = stages[STAGE_TEMP_SAMPLE].count;
+	double perLoop = samples ? 1.0 / samples : 0;
+	HalStats *s = hal_stats();
+	char key[64];
+
+	if( f != stdout )
+	{
+		fprintf( f, "{\n" );
+	}
+	line( f, "seconds", elapsed );
+	line( f, "loops", samples );
+	line( f, "loop_period_ms_mean", loops.count ? toMs( (double)loops.total / loops.count ) : 0 );
+	line( f, "loop_period_ms_min", loops.count ? toMs( loopMin ) : 0 );
+	line( f, "loop_period_ms_max", toMs( loops.max ) );
+	line( f, "loop_cpu_ms_mean", loops.counted ? cpuMs( (double)loops.instructions / loops.counted ) : 0 );
+	line( f, "cycles_per_instruction", cyclesPerInstruction );
+
+	for( uint8_t i = 0; i < STAGE_COUNT; i++ )
+	{
+		BenchTimes *t = &stages[i];
+
+		snprintf( key, sizeof(key), "stage_%s_calls_per_loop", stageNames[i] );
+		line( f, key, t->count * perLoop );
+		snprintf( key, sizeof(key), "stage_%s_io_ms_mean", stageNames[i] );
+		line( f, key, t->count ? toMs( (double)t->total / t->count ) : 0 );
+		snprintf( key, sizeof(key), "stage_%s_io_ms_max", stageNames[i] );
+		line( f, key, toMs( t->max ) );
+		snprintf( key, sizeof(key), "stage_%s_io_ms_per_loop", stageNames[i] );
+		line( f, key, toMs( t->total * perLoop ) );
+		snprintf( key, sizeof(key), "stage_%s_cpu_ms_mean", stageNames[i] );
+		line( f, key, t->counted ? cpuMs( (double)t->instructions / t->counted ) : 0 );
+		snprintf( key, sizeof(key), "stage_%s_cpu_ms_per_loop", stageNames[i] );
+		line( f, key, loops.counted ? cpuMs( (double)t->instructions / loops.counted ) : 0 );
+	}
+
+	// command latency, median and worst
+	qsort( latencies, answered, sizeof(latencies[0]), compareCycles );
+	qsort( responses, answered, sizeof(responses[0]), compareCycles );
+	line( f, "command_sent", sent );
+	line( f, "command_lost", lost + (pending ? 1 : 0) );
+	line( f, "command_first_byte_ms_p50", answered ? toMs( latencies[answered / 2] ) : 0 );
+	line( f, "command_first_byte_ms_max", answered ? toMs( latencies[answered - 1] ) : 0 );
+	line( f, "command_reply_ms_p50", answered ? toMs( responses[answered / 2] ) : 0 );
+	line( f, "command_reply_ms_max", answered ? toMs( responses[answered - 1] ) : 0 );
+
+	// buses
+	double rate = elapsed > 0 ? 1 / elapsed : 0;
+	line( f, "bus_uart_tx_bytes_per_s", (s->serialTx - stats.serialTx) * rate );
+	line( f, "bus_uart_rx_bytes_per_s", (s->serialRx - stats.serialRx) * rate );
+	line( f, "bus_twi_bytes_per_s", (s->twiBytes - stats.twiBytes) * rate );
+	line( f, "bus_twi_rtc_bytes_per_s",
+		(hal_ds1307.bytesIn + hal_ds1307.bytesOut - rtcBytes) * rate );
+	line( f, "bus_twi_eeprom_bytes_per_s",
+		(hal_24lc256.bytesIn + hal_24lc256.bytesOut - eepromBytes) * rate );
+	line( f, "bus_ph_serial_bytes_per_s",
+		(hal_ph_stamp.bytesIn + hal_ph_stamp.bytesOut - phBytes) * rate );
+	line( f, "bus_lcd_serial_bytes_per_s", (hal_lcd.bytesIn - lcdBytes) * rate );
+	line( f, "adc_conversions_per_s", (s->adcConversions - stats.adcConversions) * rate );
+
+	// correctness
+	line( f, "soft_serial_framing_errors", hal_ph_stamp.framingErrors + hal_lcd.framingErrors );
+	line( f, "lcd_labels_ok", !strncmp( hal_lcd.row( 0 ), "Date:", 5 ) &&
+		!strncmp( hal_lcd.row( 1 ), "Time:", 5 ) && !strncmp( hal_lcd.row( 2 ), "Temp:", 5 ) &&
+		!strncmp( hal_lcd.row( 3 ), "pH  :", 5 ) );
+
+	if( f != stdout )
+	{
+		fprintf( f, "  \"stores\": %llu\n}\n", (unsigned long long)s->stores );
+	}
+}
+
+/**
+ * Stage wrappers.  The link wraps each call main.c makes with
+ * -Wl,--wrap=symbol; the wrapper times the real function.
+ */
+class BenchStageTimer
+{
+public:
+	BenchStageTimer( uint8_t stage ) : stage( stage ) { bench.stageStart( stage ); }
+	~BenchStageTimer() { bench.stageEnd( stage ); }
+
+private:
+	uint8_t stage;
+};
+
+#define BENCH_WRAP(stage, symbol, params, args) \
+	extern "C" void __real_##symbol params; \
+	extern "C" void __wrap_##symbol params \
+	{ \
+		BenchStageTimer timer( stage ); \
+		__real_##symbol args; \
+	}
+
+BENCH_WRAP(STAGE_CONSOLE_POLL, _ZN7Console4pollEv, (void *p), (p))
+BENCH_WRAP(STAGE_RTC_READ, _ZN13RealTimeClock9readClockEv, (void *p), (p))
+BENCH_WRAP(STAGE_TEMP_SAMPLE, _ZN16TemperatureProbe6sampleEv, (void *p), (p))
+BENCH_WRAP(STAGE_PH_SAMPLE, _ZN7PhStamp6sampleEs, (void *p, int16_t t), (p, t))
+BENCH_WRAP(STAGE_CHECKPOINT, _ZN10Checkpoint4saveEv, (void *p), (p))
+BENCH_WRAP(STAGE_HISTORY, _ZN7History3addEmss,
+	(void *p, unsigned long e, int16_t t, int16_t ph), (p, e, t, ph))
+BENCH_WRAP(STAGE_TELEMETRY, _ZN9Telemetry10sendSampleEmsst,
+	(void *p, unsigned long e, int16_t t, int16_t ph, uint16_t n), (p, e, t, ph, n))
+BENCH_WRAP(STAGE_LOGGER_ADD, _ZN6Logger3addEmsst,
+	(void *p, unsigned long e, int16_t t, int16_t ph, uint16_t n), (p, e, t, ph, n))
+BENCH_WRAP(STAGE_LCD_PH, _ZN3Lcd8updatepHEs, (void *p, int16_t v), (p, v))
+BENCH_WRAP(STAGE_LCD_TEMP, _ZN3Lcd10updateTempEs, (void *p, int16_t v), (p, v))
+BENCH_WRAP(STAGE_LCD_TIME, _ZN3Lcd10updateTimeEhhhhh,
+	(void *p, uint8_t h, uint8_t m, uint8_t s, uint8_t is12, uint8_t pm), (p, h, m, s, is12, pm))
+BENCH_WRAP(STAGE_LCD_DATE, _ZN3Lcd10updateDateEhhh,
+	(void *p, uint8_t m, uint8_t d, uint8_t y), (p, m, d, y))
+
+/**
+ * Compare
+ */
+struct BenchKey
+{
+	char name[64];
+	double value;
+};
+
+static int readResults( const char *path, BenchKey *keys )
+{
+	FILE *f = fopen( path, "r" );
+	char text[256];
+	int n = 0;
+
+	if( !f )
+	{
+		perror( path );
+		exit( 2 );
+	}
+	while( n < BENCH_KEYS && fgets( text, sizeof(text), f ) )
+	{
+		if( sscanf( text, " \"%63[^\"]\": %lf", keys[n].name, &keys[n].value ) == 2 )
+		{
+			n++;
+		}
+	}
+	fclose( f );
+	return n;
+}
+
+/**
+ * Prints every key of both files with its change; a time (_ms_) that grew
+ * by more than tolerance percent, and by more than a microsecond, is a
+ * regression.
+ */
+static int compare( const char *baselinePath, const char *resultsPath, double tolerance )
+{
+	static BenchKey baseline[BENCH_KEYS], results[BENCH_KEYS];
+	int nb = readResults( baselinePath, baseline );
+	int nr = readResults( resultsPath, results );
+	int regressions = 0;
+
+	printf( "  %-36s %12s %12s %8s\n", "", "baseline", "now", "change" );
+	for( int i = 0; i < nr; i++ )
+	{
+		int j;
+
+		for( j = 0; j < nb && strcmp( baseline[j].name, results[i].name ); j++ )
+			;
+		if( j == nb )
+		{
+			printf( "  %-36s %12s %12.3f\n", results[i].name, "-", results[i].value );
+			continue;
+		}
+
+		double was = baseline[j].value, is = results[i].value;
+		double change = was ? 100 * (is - was) / was : (is ? 100 : 0);
+		bool worse = strstr( results[i].name, "_ms_" ) && change > tolerance &&
+			is - was > 0.001;
+
+		regressions += worse;
+		printf( "  %-36s %12.3f %12.3f %+7.1f%%%s\n", results[i].name, was, is, change,
+			worse ? "  << slower" : "" );
+	}
+	printf( "%d regression%s over %.1f%%\n", regressions, regressions == 1 ? "" : "s", tolerance );
+	return regressions ? 1 : 0;
+}
+
+int main( int argc, char **argv )
+{
+	const char *baselinePath = 0;
+	double tolerance = BENCH_TOLERANCE;
+	int c;
+
+	while( (c = getopt( argc, argv, "s:w:k:l:o:c:t:" )) != -1 )
+	{
+		switch( c )
+		{
+		case 's': bench.seconds = atof( optarg ); break;
+		case 'w': bench.warmup = atof( optarg ); break;
+		case 'k': bench.cyclesPerInstruction = atof( optarg ); break;
+		case 'l': bench.cpuLoops = atoi( optarg ); break;
+		case 'o': bench.output = optarg; break;
+		case 'c': baselinePath = optarg; break;
+		case 't': tolerance = atof( optarg ); break;
+		default:
+			fprintf( stderr, "usage: %s [-s seconds] [-w warmup] [-k cycles] [-l loops] [-o results.json]\n"
+				"       %s -c baseline.json results.json [-t percent]\n", argv[0], argv[0] );
+			return 2;
+		}
+	}
+	if( baselinePath )
+	{
+		if( optind >= argc )
+		{
+			fprintf( stderr, "%s: no results to compare\n", argv[0] );
+			return 2;
+		}
+		return compare( baselinePath, argv[optind], tolerance );
+	}
+
+	hal_serial_console( false );
+	bench.begin();
+	hal_limit( bench.seconds + bench.warmup );
+	return aq_main();
+}
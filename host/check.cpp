@@ -0,0 +1,299 @@
+/*
+ * check.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <WProgram.h>
+#include <Wire.h>
+#include <avr/eeprom.h>
+#include "hal.h"
+#include "hal_board.h"
+#include "Logger.h"
+#include "History.h"
+
+/**
+ * Checks of the host build against the board devices, run by "make
+ * check".  Each case prints one line and the run exits 1 if any failed.
+ * The spin case ends the run, from the HAL, so it goes last.
+ */
+#define CHECK_LOG_RECORDS		160			// three blocks and a flushed one
+#define CHECK_LOG_NACK_EVERY	2
+#define CHECK_LOG_POLLS			5			// 1ms apart, per record
+#define CHECK_EEPROM_BYTES		24			// a settings record
+#define CHECK_EEPROM_BYTE_US	3300
+#define CHECK_HISTORY_START		364730400UL	// an hour boundary
+#define CHECK_HISTORY_HOURS		300			// the 8 bit sequence wraps
+#define CHECK_HISTORY_RAW		150			// s the raw ring must cover
+#define CHECK_SPIN_SECONDS		0.05		// virtual
+#define CHECK_SPIN_CPU			10			// s of cpu time before it counts as hung
+
+static int failures;
+
+static void result( const char *name, bool passed, const char *detail )
+{
+	printf( "%-10s %s  %s\n", name, passed ? "ok" : "FAILED", detail );
+	if( !passed )
+	{
+		failures++;
+	}
+}
+
+/**
+ * Log EEPROM block writes that are NACKed, with clock reads on the same
+ * bus between the logger's polls as in the main loop.  Every record must
+ * still be read back, the failed blocks counted as errors, and a restart
+ * must carry on after the last one.
+ */
+static int16_t checkLogPh( uint16_t i )
+{
+	return 810 + (i * 5) % 9 - 4;
+}
+
+static void checkLogNack()
+{
+	LogRecord record;
+	char detail[160];
+	uint16_t missing = 0;
+	uint32_t found;
+	boolean flushed;
+
+	hal_24lc256.nackEvery = CHECK_LOG_NACK_EVERY;
+	LOGGER.initialize();
+
+	for( uint16_t i = 0; i < CHECK_LOG_RECORDS; i++ )
+	{
+		LOGGER.add( i, 7850 + i / 20, checkLogPh( i ), 0 );
+		for( uint8_t j = 0; j < CHECK_LOG_POLLS; j++ )
+		{
+			// a clock read, which leaves its own result on the bus
+			Wire.beginTransmission( HAL_DS1307_ADDRESS );
+			Wire.send( 0 );
+			Wire.endTransmission();
+			LOGGER.poll();
+			delay( 1 );
+		}
+	}
+	flushed = LOGGER.flush();
+	hal_24lc256.nackEvery = 0;
+
+	// from RAM and from the EEPROM, then from the EEPROM after a restart
+	for( uint8_t pass = 0; pass < 2; pass++ )
+	{
+		if( pass )
+		{
+			LOGGER.initialize();
+		}
+		for( uint16_t i = 0; i < CHECK_LOG_RECORDS; i++ )
+		{
+			if( !LOGGER.read( i, &record ) || record.sequence != i || record.epoch != i ||
+				record.temp != 7850 + i / 20 || record.ph != checkLogPh( i ) )
+			{
+				missing++;
+			}
+		}
+	}
+	found = LOGGER.find( CHECK_LOG_RECORDS / 2 );
+
+	snprintf( detail, sizeof(detail), "%u of %u records missing, %u blocks written, "
+		"%u NACKed, %u write errors, %lu busy NACKs, next %lu",
+		missing, 2 * CHECK_LOG_RECORDS, (unsigned)hal_24lc256.pageWrites,
+		(unsigned)hal_24lc256.pagesNacked, LOGGER.getErrors(),
+		(unsigned long)hal_24lc256.busyNacks, (unsigned long)LOGGER.getSequence() );
+	result( "log_nack", flushed && missing == 0 && hal_24lc256.pagesNacked > 0 &&
+		LOGGER.getErrors() == hal_24lc256.pagesNacked && hal_24lc256.busyNacks > 0 &&
+		LOGGER.getSequence() == CHECK_LOG_RECORDS && found == CHECK_LOG_RECORDS / 2, detail );
+}
+
+/**
+ * On-chip EEPROM writes take the chip's programming time, updates only
+ * for the bytes that change
+ */
+static void checkEepromTime()
+{
+	uint8_t data[CHECK_EEPROM_BYTES];
+	char detail[128];
+	unsigned long start, written, updated;
+
+	for( uint8_t i = 0; i < sizeof(data); i++ )
+	{
+		data[i] = i;
+	}
+	start = micros();
+	eeprom_write_block( data, (void *)0, sizeof(data) );
+	written = micros() - start;
+	data[0] ^= 0xff;
+	start = micros();
+	eeprom_update_block( data, (void *)0, sizeof(data) );
+	updated = micros() - start;
+
+	snprintf( detail, sizeof(detail), "%u bytes written in %lu us, updated in %lu us",
+		(unsigned)sizeof(data), written, updated );
+	result( "eeprom", written >= sizeof(data) * CHECK_EEPROM_BYTE_US &&
+		written < sizeof(data) * CHECK_EEPROM_BYTE_US * 11 / 10 &&
+		updated >= CHECK_EEPROM_BYTE_US && updated < 2 * CHECK_EEPROM_BYTE_US, detail );
+}
+
+/**
+ * The pH moves on most readings, as it does on the stamp, and the
+ * temperature now and then
+ */
+static int16_t checkTemp( unsigned long epoch )
+{
+	return 7846 + (epoch % 13 == 0);
+}
+
+static int16_t checkPh( unsigned long epoch )
+{
+	return 720 + (int16_t)((epoch * 2654435761UL) >> 29) - 3;
+}
+
+static uint16_t checkVisited;
+static uint16_t checkWrong;
+static unsigned long checkNext;
+
+static void checkRaw( uint8_t resolution, const HistoryRecord *record )
+{
+	if( checkVisited++ == 0 )
+	{
+		checkNext = record->start;
+	}
+	if( record->start != checkNext++ || record->count != 1 ||
+			record->tempMean != checkTemp( record->start ) || record->phMean != checkPh( record->start ) )
+	{
+		checkWrong++;
+	}
+}
+
+static void checkHour( uint8_t resolution, const HistoryRecord *record )
+{
+	if( checkVisited++ == 0 )
+	{
+		checkNext = record->start;
+	}
+	if( record->start != checkNext || record->count != 3600 )
+	{
+		checkWrong++;
+	}
+	checkNext += 3600;
+}
+
+/**
+ * A day and more of readings, once a second.  The raw ring must hold
+ * every reading of its last CHECK_HISTORY_RAW seconds or more, the
+ * EEPROM at least a day of hours, and a restart must find the newest.
+ */
+static void checkHistory()
+{
+	static History restarted;
+	unsigned long end = CHECK_HISTORY_START + CHECK_HISTORY_HOURS * 3600UL;
+	unsigned long rawFirst;
+	uint16_t raw, hours, rawWrong, hourWrong;
+	char detail[128];
+
+	HISTORY.initialize();
+	for( unsigned long t = CHECK_HISTORY_START; t <= end; t++ )
+	{
+		HISTORY.add( t, checkTemp( t ), checkPh( t ) );
+	}
+
+	checkVisited = checkWrong = 0;
+	HISTORY.query( HISTORY_RAW, 0, 0xFFFFFFFF, checkRaw );
+	raw = checkVisited;
+	rawWrong = checkWrong + (checkNext != end + 1);
+	rawFirst = checkNext - raw;
+
+	checkVisited = checkWrong = 0;
+	restarted.initialize();
+	restarted.query( HISTORY_HOUR, 0, 0xFFFFFFFF, checkHour );
+	hours = checkVisited;
+	hourWrong = checkWrong + (checkNext != end);
+
+	snprintf( detail, sizeof(detail), "raw %u readings (%lu s), %u wrong; %u of %u hours, %u wrong",
+		raw, end + 1 - rawFirst, rawWrong, hours, (unsigned)HISTORY_HOURS, hourWrong );
+	result( "history", end + 1 - rawFirst >= CHECK_HISTORY_RAW && rawWrong == 0 &&
+		hours == HISTORY_HOURS && hours >= 24 && hourWrong == 0, detail );
+}
+
+/**
+ * Ends the spin case: the HAL calls finish() when the clock reaches the
+ * limit, which it only does if the spin was skipped
+ */
+class CheckSpin : public HalDevice
+{
+public:
+	CheckSpin() : spinning( false ) {}
+
+	void finish()
+	{
+		if( spinning )
+		{
+			result( "spin", true, "clock reached the limit" );
+			fflush( stdout );
+			_exit( failures ? 1 : 0 );
+		}
+	}
+
+	bool spinning;
+};
+
+static CheckSpin checkSpinDevice;
+
+static void spinHung( int sig )
+{
+	static const char message[] = "spin       FAILED  clock stuck polling a register\n";
+
+	if( write( 1, message, sizeof(message) - 1 ) ) {}
+	_exit( 1 );
+}
+
+/**
+ * A wait on a register nothing will ever set, which reads but never
+ * stores, must still run out the poll budget and move the clock on.  A
+ * run that hangs is cut off by its cpu time limit.
+ */
+static void checkSpin()
+{
+	struct rlimit cpu;
+	struct rusage used;
+
+	getrusage( RUSAGE_SELF, &used );
+	cpu.rlim_cur = used.ru_utime.tv_sec + used.ru_stime.tv_sec + CHECK_SPIN_CPU;
+	cpu.rlim_max = cpu.rlim_cur + 1;
+	signal( SIGXCPU, spinHung );
+	setrlimit( RLIMIT_CPU, &cpu );
+
+	fflush( stdout );
+	checkSpinDevice.spinning = true;
+	hal_limit( hal_seconds() + CHECK_SPIN_SECONDS );
+	sei();
+	while( !GPIOR0 )
+	{
+	}
+}
+
+int main()
+{
+	hal_serial_console( false );
+	init();
+	Wire.begin();
+
+	checkLogNack();
+	checkEepromTime();
+	checkHistory();
+	checkSpin();
+
+	hal_finish( failures ? 1 : 0 );
+	return 0;
+}
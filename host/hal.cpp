@@ -0,0 +1,973 @@
+/*
+ * hal.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include "hal.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "the host HAL steps register accesses with the x86-64 trap flag"
+#endif
+
+#define HAL_EFLAGS_TF	0x100
+#define HAL_PF_WRITE	0x2				// page fault error code: a write
+#define HAL_STRING2(x)	#x
+#define HAL_STRING(x)	HAL_STRING2(x)
+
+extern "C" {
+volatile uint8_t hal_sfr[HAL_PAGE_SIZE] __attribute__((aligned(HAL_PAGE_SIZE)));
+uint8_t hal_eeprom[E2END + 1];
+}
+
+// The vector table: whatever the program defines, the rest stay null
+#define HAL_WEAK_VECTOR(n) extern "C" void __vector_##n(void) __attribute__((weak));
+HAL_WEAK_VECTOR(1)  HAL_WEAK_VECTOR(2)  HAL_WEAK_VECTOR(3)  HAL_WEAK_VECTOR(4)
+HAL_WEAK_VECTOR(5)  HAL_WEAK_VECTOR(6)  HAL_WEAK_VECTOR(7)  HAL_WEAK_VECTOR(8)
+HAL_WEAK_VECTOR(9)  HAL_WEAK_VECTOR(10) HAL_WEAK_VECTOR(11) HAL_WEAK_VECTOR(12)
+HAL_WEAK_VECTOR(13) HAL_WEAK_VECTOR(14) HAL_WEAK_VECTOR(15) HAL_WEAK_VECTOR(16)
+HAL_WEAK_VECTOR(17) HAL_WEAK_VECTOR(18) HAL_WEAK_VECTOR(19) HAL_WEAK_VECTOR(20)
+HAL_WEAK_VECTOR(21) HAL_WEAK_VECTOR(22) HAL_WEAK_VECTOR(23) HAL_WEAK_VECTOR(24)
+HAL_WEAK_VECTOR(25)
+
+typedef void (*HalHandler)(void);
+
+static HalHandler const handlers[HAL_VECTORS] = {
+	0, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5,
+	__vector_6, __vector_7, __vector_8, __vector_9, __vector_10,
+	__vector_11, __vector_12, __vector_13, __vector_14, __vector_15,
+	__vector_16, __vector_17, __vector_18, __vector_19, __vector_20,
+	__vector_21, __vector_22, __vector_23, __vector_24, __vector_25
+};
+
+/**
+ * Where each vector's flag and enable bit live.  clear is set for the
+ * flags the chip clears when it takes the interrupt; the others are
+ * levels the handler has to remove itself.
+ */
+struct HalVector
+{
+	uint8_t flag;
+	uint8_t flagBit;
+	uint8_t enable;
+	uint8_t enableBit;
+	uint8_t clear;
+};
+
+#define HAL_REG(sfr) _SFR_MEM_ADDR(sfr)
+
+static const HalVector vectors[HAL_VECTORS] = {
+	{ 0, 0, 0, 0, 0 },										// reset
+	{ HAL_REG(EIFR), INTF0, HAL_REG(EIMSK), INT0, 1 },
+	{ HAL_REG(EIFR), INTF1, HAL_REG(EIMSK), INT1, 1 },
+	{ HAL_REG(PCIFR), PCIF0, HAL_REG(PCICR), PCIE0, 1 },
+	{ HAL_REG(PCIFR), PCIF1, HAL_REG(PCICR), PCIE1, 1 },
+	{ HAL_REG(PCIFR), PCIF2, HAL_REG(PCICR), PCIE2, 1 },
+	{ 0, 0, 0, 0, 0 },										// watchdog
+	{ HAL_REG(TIFR2), OCF2A, HAL_REG(TIMSK2), OCIE2A, 1 },
+	{ HAL_REG(TIFR2), OCF2B, HAL_REG(TIMSK2), OCIE2B, 1 },
+	{ HAL_REG(TIFR2), TOV2, HAL_REG(TIMSK2), TOIE2, 1 },
+	{ HAL_REG(TIFR1), ICF1, HAL_REG(TIMSK1), ICIE1, 1 },
+	{ HAL_REG(TIFR1), OCF1A, HAL_REG(TIMSK1), OCIE1A, 1 },
+	{ HAL_REG(TIFR1), OCF1B, HAL_REG(TIMSK1), OCIE1B, 1 },
+	{ HAL_REG(TIFR1), TOV1, HAL_REG(TIMSK1), TOIE1, 1 },
+	{ HAL_REG(TIFR0), OCF0A, HAL_REG(TIMSK0), OCIE0A, 1 },
+	{ HAL_REG(TIFR0), OCF0B, HAL_REG(TIMSK0), OCIE0B, 1 },
+	{ HAL_REG(TIFR0), TOV0, HAL_REG(TIMSK0), TOIE0, 1 },
+	{ HAL_REG(SPSR), SPIF, HAL_REG(SPCR), SPIE, 1 },
+	{ HAL_REG(UCSR0A), RXC0, HAL_REG(UCSR0B), RXCIE0, 0 },
+	{ HAL_REG(UCSR0A), UDRE0, HAL_REG(UCSR0B), UDRIE0, 0 },
+	{ HAL_REG(UCSR0A), TXC0, HAL_REG(UCSR0B), TXCIE0, 1 },
+	{ HAL_REG(ADCSRA), ADIF, HAL_REG(ADCSRA), ADIE, 1 },
+	{ 0, 0, 0, 0, 0 },										// EEPROM ready
+	{ 0, 0, 0, 0, 0 },										// comparator
+	{ HAL_REG(TWCR), TWINT, HAL_REG(TWCR), TWIE, 0 },
+	{ 0, 0, 0, 0, 0 }										// SPM ready
+};
+
+#define HAL_SREG HAL_REG(SREG)
+
+static uint64_t now;
+static uint64_t limit = HAL_NEVER;
+static uint64_t halted;
+static HalStats stats;
+
+static HalDevice *devices;
+static HalDevice **devicesEnd = &devices;
+static HalDevice *unreset;
+static HalTwiDevice *twiDevices;
+
+static volatile uint8_t pageOpen;			// register page accessible
+static volatile uint8_t busy;			// HAL code running
+static volatile uint32_t activity;		// every access, for the hung check
+static uint32_t activitySeen;
+static uint16_t polls;				// reads since the last store or delay
+static uint8_t sregRun;
+static greg_t sregStores[2];			// where the last two SREG stores came from
+static volatile sig_atomic_t stopSignal;
+static volatile uint8_t counting;		// program code runs with the trap flag set
+static volatile uint64_t instructions;
+static uint64_t waitStart;			// the count where a wait may have begun
+
+/**
+ * The access being stepped, then the work it leaves for hal_drain()
+ */
+static struct
+{
+	volatile uint8_t stepping;
+	uint8_t write;
+	uint8_t addr;
+	uint8_t old[2];
+	greg_t pc;
+} trap;
+
+#define HAL_DRAIN_STORE		1
+#define HAL_DRAIN_SPIN		2
+
+static struct
+{
+	uint8_t kind;
+	uint8_t addr;
+	uint8_t old[2];
+	greg_t pc;
+} queued;
+
+extern "C" {
+volatile greg_t hal_resume;				// where the trampoline goes back to
+volatile uint64_t hal_trace_flags;		// or-ed into the flags it goes back with
+void hal_trampoline(void);
+void hal_drain(void);
+}
+
+static struct timespec started;
+static const char *eepromFile;
+static bool printStats;
+
+/**
+ * Register page protection
+ */
+static void halOpen()
+{
+	if( !pageOpen )
+	{
+		mprotect( (void *)hal_sfr, HAL_PAGE_SIZE, PROT_READ | PROT_WRITE );
+		pageOpen = 1;
+	}
+}
+
+static void halClose()
+{
+	if( pageOpen )
+	{
+		mprotect( (void *)hal_sfr, HAL_PAGE_SIZE, PROT_NONE );
+		pageOpen = 0;
+	}
+}
+
+/**
+ * Messages from the signal handlers, which cannot use stdio
+ */
+static void halSignalText( const char *text )
+{
+	if( write( 2, text, strlen( text ) ) ) {}
+}
+
+static void halSignalHex( uintptr_t value )
+{
+	char buf[2 + 2 * sizeof(value)];
+	char *p = buf + sizeof(buf);
+
+	do
+	{
+		*--p = "0123456789abcdef"[value & 0xf];
+		value >>= 4;
+	} while( value );
+	*--p = 'x';
+	*--p = '0';
+	if( write( 2, p, buf + sizeof(buf) - p ) ) {}
+}
+
+/**
+ * Sets or clears the trap flag for the code that follows.  The red zone
+ * is stepped over, since the compiler may be keeping values in it.
+ */
+static inline void halTrace( bool on )
+{
+	if( on )
+	{
+		asm volatile( "leaq -128(%%rsp), %%rsp; pushfq; orq $0x100, (%%rsp); popfq; leaq 128(%%rsp), %%rsp"
+			::: "memory" );
+	}
+	else
+	{
+		asm volatile( "leaq -128(%%rsp), %%rsp; pushfq; andq $-0x101, (%%rsp); popfq; leaq 128(%%rsp), %%rsp"
+			::: "memory" );
+	}
+}
+
+/**
+ * Resets devices constructed since the last call.
+ */
+static void halResetDevices()
+{
+	while( unreset )
+	{
+		HalDevice *d = unreset;
+		unreset = d->nextDevice;
+		d->reset();
+	}
+
+} // end halResetDevices
+
+/**
+ * Earliest device event.
+ */
+static uint64_t halNext( HalDevice **which )
+{
+	uint64_t t = HAL_NEVER;
+
+	*which = 0;
+	for( HalDevice *d = devices; d; d = d->nextDevice )
+	{
+		uint64_t n = d->next();
+		if( n < t )
+		{
+			t = n;
+			*which = d;
+		}
+	}
+	return t;
+}
+
+static void halSync()
+{
+	for( HalDevice *d = devices; d; d = d->nextDevice )
+	{
+		d->sync( now );
+	}
+}
+
+/**
+ * Takes every pending interrupt the I bit allows, highest priority (lowest
+ * vector) first.  The page is open on entry and on return; handlers run
+ * with it closed like the rest of the program.
+ */
+static void halInterrupts()
+{
+	while( hal_sfr[HAL_SREG] & _BV(SREG_I) )
+	{
+		uint8_t v;
+
+		for( v = 1; v < HAL_VECTORS; v++ )
+		{
+			const HalVector *p = &vectors[v];
+			if( p->flag && (hal_sfr[p->flag] & _BV(p->flagBit)) &&
+				(hal_sfr[p->enable] & _BV(p->enableBit)) )
+			{
+				break;
+			}
+		}
+		if( v == HAL_VECTORS )
+		{
+			return;
+		}
+
+		if( handlers[v] == 0 )
+		{
+			// the chip would jump to __bad_interrupt and restart
+			fprintf( stderr, "hal: no handler for vector %u at %.6fs\n", v, hal_seconds() );
+			hal_finish( 3 );
+		}
+
+		if( vectors[v].clear )
+		{
+			hal_sfr[vectors[v].flag] &= ~_BV(vectors[v].flagBit);
+		}
+		hal_sfr[HAL_SREG] &= ~_BV(SREG_I);
+		stats.interrupts[v]++;
+
+		uint8_t wasBusy = busy;
+		halClose();
+		busy = 0;
+		if( counting )
+		{
+			halTrace( true );
+			handlers[v]();
+			halTrace( false );
+		}
+		else
+		{
+			handlers[v]();
+		}
+		busy = wasBusy;
+		halOpen();
+
+		// reti
+		hal_sfr[HAL_SREG] |= _BV(SREG_I);
+		for( HalDevice *d = devices; d; d = d->nextDevice )
+		{
+			d->serviced( v );
+		}
+	}
+
+} // end halInterrupts
+
+/**
+ * Moves the clock to until, running the events that come due on the way
+ * and taking interrupts after each.  Handlers may re-enter through their
+ * own stores and delays; the clock only ever moves forward.
+ */
+static void halRun( uint64_t until )
+{
+	halResetDevices();
+
+	for( ;; )
+	{
+		HalDevice *d;
+		uint64_t t = halNext( &d );
+
+		if( t > until || d == 0 )
+		{
+			break;
+		}
+		if( t > now )
+		{
+			now = t;
+		}
+		halSync();
+		d->event( now );
+		stats.events++;
+		halSync();
+		halInterrupts();
+	}
+	if( until > now )
+	{
+		now = until;
+	}
+	halSync();
+	halInterrupts();
+
+	if( now >= limit )
+	{
+		hal_finish( 0 );
+	}
+	if( stopSignal )
+	{
+		hal_finish( 128 + stopSignal );
+	}
+
+} // end halRun
+
+/**
+ * Tells the devices about a store to addr.
+ */
+static void halStore( uint8_t addr, uint8_t old )
+{
+	for( HalDevice *d = devices; d; d = d->nextDevice )
+	{
+		d->store( addr, old );
+	}
+}
+
+/**
+ * An access to the register page, which is closed to reads and writes
+ * alike: open it and step the one instruction.  Anything else is a real
+ * fault; put the default action back and let the instruction fault again.
+ */
+static void halFault( int sig, siginfo_t *info, void *context )
+{
+	ucontext_t *uc = (ucontext_t *)context;
+	uintptr_t addr = (uintptr_t)info->si_addr - (uintptr_t)hal_sfr;
+
+	if( addr >= HAL_REGISTERS || trap.stepping || pageOpen )
+	{
+		halSignalText( "hal: fault at " );
+		halSignalHex( (uintptr_t)info->si_addr );
+		halSignalText( ", pc " );
+		halSignalHex( uc->uc_mcontext.gregs[REG_RIP] );
+		halSignalText( ", cycle " );
+		halSignalHex( now );
+		halSignalText( "\n" );
+		signal( SIGSEGV, SIG_DFL );
+		return;
+	}
+
+	trap.stepping = 1;
+	trap.write = (uc->uc_mcontext.gregs[REG_ERR] & HAL_PF_WRITE) != 0;
+	trap.addr = addr;
+	trap.pc = uc->uc_mcontext.gregs[REG_RIP];
+	halOpen();
+	trap.old[0] = hal_sfr[addr];
+	trap.old[1] = addr + 1 < HAL_REGISTERS ? hal_sfr[addr + 1] : 0;
+	uc->uc_mcontext.gregs[REG_EFL] |= HAL_EFLAGS_TF;
+	activity++;
+
+} // end halFault
+
+/**
+ * The stepped access is done.  Close the page again and count a read as a
+ * poll; a store, or a read that runs out the poll budget, is queued and the
+ * code sent through hal_trampoline() to hal_drain(), so the models run once
+ * the handler has returned rather than inside it.
+ */
+static void halStep( int sig, siginfo_t *info, void *context )
+{
+	ucontext_t *uc = (ucontext_t *)context;
+	greg_t *sp;
+
+	if( !trap.stepping )
+	{
+		if( counting )
+		{
+			instructions++;
+			return;
+		}
+		signal( SIGTRAP, SIG_DFL );
+		raise( SIGTRAP );
+		return;
+	}
+	if( counting )
+	{
+		instructions++;
+	}
+	else
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~HAL_EFLAGS_TF;
+	}
+	trap.stepping = 0;
+	halClose();
+
+	if( trap.write )
+	{
+		queued.kind = HAL_DRAIN_STORE;
+		queued.addr = trap.addr;
+		queued.old[0] = trap.old[0];
+		queued.old[1] = trap.old[1];
+		queued.pc = trap.pc;
+	}
+	else
+	{
+		stats.polls++;
+		if( ++polls < HAL_SPIN_POLLS )
+		{
+			return;
+		}
+		queued.kind = HAL_DRAIN_SPIN;
+	}
+	polls = 0;
+
+	// the trampoline takes hal_resume before anything can trap again, and
+	// runs untraced
+	sp = &uc->uc_mcontext.gregs[REG_RIP];
+	hal_resume = *sp;
+	*sp = (greg_t)hal_trampoline;
+	uc->uc_mcontext.gregs[REG_EFL] &= ~HAL_EFLAGS_TF;
+
+} // end halStep
+
+/**
+ * Entered in place of the instruction after a queued access.  Steps over
+ * the red zone, pushes the address to go back to and saves everything
+ * hal_drain() may change, flags and x87/SSE state included.  The trap
+ * flag goes back on at the end when instructions are being counted.
+ */
+asm(
+	".text\n"
+	".globl hal_trampoline\n"
+	".type hal_trampoline, @function\n"
+	"hal_trampoline:\n"
+	"	leaq -128(%rsp), %rsp\n"
+	"	pushq hal_resume(%rip)\n"
+	"	pushfq\n"
+	"	pushq %rax\n"
+	"	pushq %rcx\n"
+	"	pushq %rdx\n"
+	"	pushq %rsi\n"
+	"	pushq %rdi\n"
+	"	pushq %r8\n"
+	"	pushq %r9\n"
+	"	pushq %r10\n"
+	"	pushq %r11\n"
+	"	pushq %rbx\n"
+	"	movq %rsp, %rbx\n"
+	"	andq $-64, %rsp\n"
+	"	subq $512, %rsp\n"
+	"	fxsave64 (%rsp)\n"
+	"	cld\n"
+	"	call hal_drain\n"
+	"	fxrstor64 (%rsp)\n"
+	"	movq %rbx, %rsp\n"
+	"	movq hal_trace_flags(%rip), %rax\n"
+	"	orq %rax, 80(%rsp)\n"
+	"	popq %rbx\n"
+	"	popq %r11\n"
+	"	popq %r10\n"
+	"	popq %r9\n"
+	"	popq %r8\n"
+	"	popq %rdi\n"
+	"	popq %rsi\n"
+	"	popq %rdx\n"
+	"	popq %rcx\n"
+	"	popq %rax\n"
+	"	popfq\n"
+	"	ret $128\n"
+	".size hal_trampoline, .-hal_trampoline\n"
+);
+
+/**
+ * Skips the clock over a spin: to the next event, or a quantum on if
+ * nothing is due.  Nothing but an interrupt can end a spin with them off.
+ */
+static void halSpin()
+{
+	HalDevice *d;
+	uint64_t t;
+
+	stats.spins++;
+
+	// the chip would spend the skipped time in the loop; it is waiting, not
+	// computing, so what the loop has counted so far goes too
+	instructions = waitStart;
+
+	t = halNext( &d );
+	if( t == HAL_NEVER || t > now + HAL_SPIN_QUANTUM )
+	{
+		t = now + HAL_SPIN_QUANTUM;
+	}
+
+	if( !(hal_sfr[HAL_SREG] & _BV(SREG_I)) && now - halted > HAL_HALT_CYCLES )
+	{
+		fprintf( stderr, "hal: halted with interrupts off at %.6fs\n", hal_seconds() );
+		hal_finish( 2 );
+	}
+
+	halRun( t );
+	waitStart = instructions;
+
+} // end halSpin
+
+/**
+ * Runs what the trap handler queued, in ordinary context.  Handlers taken
+ * here trap and drain in turn, so the record is copied out first.
+ */
+extern "C" void hal_drain()
+{
+	uint8_t kind = queued.kind;
+	uint8_t addr = queued.addr;
+	uint8_t old[2] = { queued.old[0], queued.old[1] };
+	greg_t pc = queued.pc;
+
+	busy = 1;
+	halOpen();
+
+	if( kind == HAL_DRAIN_SPIN )
+	{
+		halSpin();
+		halClose();
+		busy = 0;
+		return;
+	}
+
+	stats.stores++;
+	halResetDevices();
+
+	// a 16 bit store lands in two registers
+	halStore( addr, old[0] );
+	if( addr + 1 < HAL_REGISTERS && hal_sfr[addr + 1] != old[1] )
+	{
+		halStore( addr + 1, old[1] );
+	}
+
+	now += HAL_STORE_CYCLES;
+	halted = now;
+
+	// the same one or two SREG stores over and over and nothing else: a
+	// wait loop around millis() or micros()
+	if( addr != HAL_SREG )
+	{
+		sregRun = 0;
+		sregStores[0] = sregStores[1] = 0;
+	}
+	else
+	{
+		sregRun = (pc == sregStores[0] || pc == sregStores[1]) ? sregRun + 1 : 0;
+		sregStores[1] = sregStores[0];
+		sregStores[0] = pc;
+	}
+	if( sregRun == 0 )
+	{
+		waitStart = instructions;
+	}
+	if( sregRun >= HAL_SPIN_STORES )
+	{
+		HalDevice *d;
+		uint64_t t = halNext( &d );
+
+		sregRun = 0;
+		if( t != HAL_NEVER && t > now )
+		{
+			stats.skips++;
+			instructions = waitStart;
+			now = t;
+		}
+	}
+
+	halRun( now );
+	halClose();
+	busy = 0;
+
+} // end hal_drain
+
+/**
+ * A poll of a variable the HAL watches in RAM (see hal_twi.h), counted
+ * against the same budget as a register read
+ */
+extern "C" void hal_poll()
+{
+	if( busy )
+	{
+		return;
+	}
+	stats.polls++;
+	activity++;
+	if( ++polls >= HAL_SPIN_POLLS )
+	{
+		if( counting )
+		{
+			halTrace( false );
+		}
+		polls = 0;
+		busy = 1;
+		halOpen();
+		halSpin();
+		halClose();
+		busy = 0;
+		if( counting )
+		{
+			halTrace( true );
+		}
+	}
+}
+
+extern "C" void hal_delay_cycles( uint32_t cycles )
+{
+	uint8_t wasBusy = busy;
+	uint8_t wasOpen = pageOpen;
+
+	if( counting && !wasBusy )
+	{
+		halTrace( false );
+	}
+	busy = 1;
+	stats.delays++;
+	sregRun = 0;
+	polls = 0;
+	activity++;
+
+	halOpen();
+	halRun( now + cycles );
+	halted = now;
+	waitStart = instructions;
+	if( !wasOpen )
+	{
+		halClose();
+	}
+	busy = wasBusy;
+	if( counting && !wasBusy )
+	{
+		halTrace( true );
+	}
+}
+
+/**
+ * Devices
+ */
+// kept in construction order, which is the order they are reset and
+// called in
+HalDevice::HalDevice() : nextDevice( 0 )
+{
+	*devicesEnd = this;
+	devicesEnd = &nextDevice;
+	if( !unreset )
+	{
+		unreset = this;
+	}
+}
+
+HalTwiDevice::HalTwiDevice( uint8_t address ) : twiAddress( address ), nextTwi( twiDevices )
+{
+	twiDevices = this;
+}
+
+HalAccess::HalAccess() : wasOpen( pageOpen ), wasBusy( busy )
+{
+	if( counting && !wasBusy )
+	{
+		halTrace( false );
+	}
+	busy = 1;
+	halOpen();
+}
+
+HalAccess::~HalAccess()
+{
+	if( !wasOpen )
+	{
+		halClose();
+	}
+	activity++;
+	busy = wasBusy;
+	if( counting && !wasBusy )
+	{
+		halTrace( true );
+	}
+}
+
+HalDevice *hal_devices()
+{
+	return devices;
+}
+
+HalTwiDevice *hal_twi_devices()
+{
+	return twiDevices;
+}
+
+/**
+ * Clock
+ */
+uint64_t hal_now()
+{
+	return now;
+}
+
+double hal_seconds()
+{
+	return (double)now / F_CPU;
+}
+
+void hal_limit( double seconds )
+{
+	limit = seconds > 0 ? (uint64_t)(seconds * F_CPU) : HAL_NEVER;
+}
+
+HalStats *hal_stats()
+{
+	return &stats;
+}
+
+/**
+ * Instruction counting, for the benchmark's cpu time model: every
+ * instruction of the program, interrupt handlers included, single steps
+ * and counts one.  The HAL's own code is not counted, nor a wait loop the
+ * clock skips, from the last store or delay before it.
+ */
+void hal_count_instructions( bool on )
+{
+	// the flag goes on after counting does, and off before it stops, so
+	// every trap is counted
+	if( !on && !busy )
+	{
+		halTrace( false );
+	}
+	counting = on;
+	hal_trace_flags = on ? HAL_EFLAGS_TF : 0;
+	if( on && !busy )
+	{
+		halTrace( true );
+	}
+}
+
+uint64_t hal_instructions()
+{
+	return instructions;
+}
+
+static const char * const vectorNames[HAL_VECTORS] = {
+	"reset", "INT0", "INT1", "PCINT0", "PCINT1", "PCINT2", "WDT",
+	"TIMER2_COMPA", "TIMER2_COMPB", "TIMER2_OVF", "TIMER1_CAPT",
+	"TIMER1_COMPA", "TIMER1_COMPB", "TIMER1_OVF", "TIMER0_COMPA",
+	"TIMER0_COMPB", "TIMER0_OVF", "SPI_STC", "USART_RX", "USART_UDRE",
+	"USART_TX", "ADC", "EE_READY", "ANALOG_COMP", "TWI", "SPM_READY"
+};
+
+static void halPrintStats()
+{
+	struct timespec t;
+	double real;
+
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	real = (t.tv_sec - started.tv_sec) + (t.tv_nsec - started.tv_nsec) / 1e9;
+
+	fprintf( stderr, "hal: %.6fs virtual in %.3fs real (%.2fx)\n",
+		hal_seconds(), real, real > 0 ? hal_seconds() / real : 0 );
+	fprintf( stderr, "hal: %llu stores, %llu polls, %llu delays, %llu events, %llu spins, %llu skips\n",
+		(unsigned long long)stats.stores, (unsigned long long)stats.polls, (unsigned long long)stats.delays,
+		(unsigned long long)stats.events, (unsigned long long)stats.spins,
+		(unsigned long long)stats.skips );
+	fprintf( stderr, "hal: serial %llu out %llu in %llu overruns, twi %llu bytes %llu nacks, "
+		"spi %llu bytes, adc %llu\n",
+		(unsigned long long)stats.serialTx, (unsigned long long)stats.serialRx,
+		(unsigned long long)stats.serialOverruns, (unsigned long long)stats.twiBytes,
+		(unsigned long long)stats.twiNacks, (unsigned long long)stats.spiBytes,
+		(unsigned long long)stats.adcConversions );
+	for( int v = 1; v < HAL_VECTORS; v++ )
+	{
+		if( stats.interrupts[v] )
+		{
+			fprintf( stderr, "hal: %-12s %llu\n", vectorNames[v],
+				(unsigned long long)stats.interrupts[v] );
+		}
+	}
+}
+
+/**
+ * Ends the run from wherever the program is, handlers included.
+ */
+void hal_finish( int status )
+{
+	static uint8_t finishing;
+	struct itimerval off;
+
+	if( finishing++ )
+	{
+		_exit( status );
+	}
+
+	memset( &off, 0, sizeof(off) );
+	setitimer( ITIMER_PROF, &off, 0 );
+	halOpen();
+
+	for( HalDevice *d = devices; d; d = d->nextDevice )
+	{
+		d->finish();
+	}
+
+	if( eepromFile )
+	{
+		FILE *f = fopen( eepromFile, "wb" );
+		if( f )
+		{
+			fwrite( hal_eeprom, 1, sizeof(hal_eeprom), f );
+			fclose( f );
+		}
+	}
+
+	if( printStats )
+	{
+		halPrintStats();
+	}
+	fflush( stdout );
+	fflush( stderr );
+	_exit( status );
+
+} // end hal_finish
+
+/**
+ * Ctrl-C and kill end the run at the next store, delay or spin, outside
+ * the handler; a second one ends it at once.
+ */
+static void halInterrupted( int sig )
+{
+	if( stopSignal )
+	{
+		_exit( 128 + sig );
+	}
+	stopSignal = sig;
+}
+
+/**
+ * Cpu time failsafe: code that has touched no register, watched variable
+ * or delay since the last tick is stuck where nothing can move the clock.
+ */
+static void halHung( int sig )
+{
+	if( activity != activitySeen )
+	{
+		activitySeen = activity;
+		return;
+	}
+	halSignalText( "hal: hung, no register access in " HAL_STRING(HAL_HUNG_SECONDS) "s of cpu time\n" );
+	_exit( 2 );
+}
+
+/**
+ * Power on, ahead of every static constructor in the program.
+ */
+__attribute__((constructor(101))) static void halStart()
+{
+	struct sigaction sa;
+	struct itimerval hung;
+	const char *s;
+
+	clock_gettime( CLOCK_MONOTONIC, &started );
+
+	memset( hal_eeprom, 0xff, sizeof(hal_eeprom) );
+	if( (s = getenv( "HAL_EEPROM" )) != 0 && *s )
+	{
+		FILE *f = fopen( s, "rb" );
+		if( f )
+		{
+			if( fread( hal_eeprom, 1, sizeof(hal_eeprom), f ) == 0 )
+			{
+				memset( hal_eeprom, 0xff, sizeof(hal_eeprom) );
+			}
+			fclose( f );
+		}
+		eepromFile = s;
+	}
+	if( (s = getenv( "HAL_SECONDS" )) != 0 )
+	{
+		hal_limit( atof( s ) );
+	}
+	printStats = (s = getenv( "HAL_STATS" )) != 0 && *s && *s != '0';
+
+	// reset values that are not zero
+	hal_sfr[HAL_REG(SPL)] = RAMEND & 0xff;
+	hal_sfr[HAL_REG(SPH)] = RAMEND >> 8;
+	hal_sfr[HAL_REG(UCSR0A)] = _BV(UDRE0);
+	hal_sfr[HAL_REG(UCSR0C)] = 0x06;
+	hal_sfr[HAL_REG(TWSR)] = 0xf8;
+	hal_sfr[HAL_REG(TWDR)] = 0xff;
+
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigemptyset( &sa.sa_mask );
+	sa.sa_sigaction = halFault;
+	sigaction( SIGSEGV, &sa, 0 );
+	sa.sa_sigaction = halStep;
+	sigaction( SIGTRAP, &sa, 0 );
+
+	sa.sa_flags = SA_RESTART;
+	sa.sa_handler = halInterrupted;
+	sigaction( SIGINT, &sa, 0 );
+	sigaction( SIGTERM, &sa, 0 );
+	sa.sa_handler = halHung;
+	sigaction( SIGPROF, &sa, 0 );
+	signal( SIGPIPE, SIG_IGN );
+
+	pageOpen = 1;
+	halClose();
+
+	memset( &hung, 0, sizeof(hung) );
+	hung.it_interval.tv_sec = HAL_HUNG_SECONDS;
+	hung.it_value.tv_sec = HAL_HUNG_SECONDS;
+	setitimer( ITIMER_PROF, &hung, 0 );
+
+} // end halStart
@@ -0,0 +1,248 @@
+/*
+ * hal.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/io.h>
+
+/**
+ * Host hardware layer.  Runs avrlib, the libraries and the app, compiled
+ * for Linux, against models of the ATmega328P peripherals.  The sources
+ * build as they are except wiring_memory.c, which measures the AVR heap
+ * and stack; hal_memory.cpp stands in for it.
+ *
+ * The registers are the cells of hal_sfr[], kept on a page the program
+ * cannot touch.  Any access faults and is single stepped with the page
+ * open.  The trap handler only queues a store; the code is sent through
+ * a trampoline that runs the models in ordinary context, straight after
+ * the store lands and before the next instruction.  Time is a virtual
+ * cycle clock that moves only when the code does something the board
+ * would spend time on:
+ *
+ * - every register store costs HAL_STORE_CYCLES;
+ * - _delay_loop_1/2, delayMicroseconds() and SoftwareSerial's tuned delay
+ *   cost exactly the cycles they would on the chip;
+ * - each on-chip EEPROM byte written costs its 3.3ms programming time
+ *   (include/avr/eeprom.h);
+ * - HAL_SPIN_POLLS register reads with no store or delay between them
+ *   are a wait on a flag, and the clock skips to the next event.  twi.c
+ *   waits on twi_state in RAM rather than a register, so the host build
+ *   wraps that variable (hal_twi.h) and counts its reads the same way.
+ *   The same SREG stores over and over (millis() and micros() in a wait
+ *   loop) skip too.
+ *
+ * Straight line computation is free, so the clock measures i/o and waits,
+ * not instruction counts.  Interrupts are taken in vector order between
+ * stores, after events and inside delays, whenever SREG's I bit is set.
+ *
+ * hal_count_instructions() counts the program's instructions apart from
+ * the clock, for the benchmark's cpu time model.  The program then runs
+ * with the trap flag set and every instruction traps, so it is for short
+ * stretches; the HAL clears the flag while its own code runs.
+ *
+ * Limits:
+ *
+ * - spin detection counts accesses, not time, so runs repeat exactly on
+ *   any host.  A loop that touches neither a register nor twi_state and
+ *   never delays cannot move the clock at all; the ITIMER_PROF failsafe
+ *   ends the run if there has been no access in HAL_HUNG_SECONDS of cpu
+ *   time.
+ * - every register read or store costs a fault, a trap and two mprotect
+ *   calls, and a store a trip through the trampoline as well; the
+ *   monitor app runs at about 0.4x real time.
+ * - the trampoline saves the general registers, the flags and the x87
+ *   and SSE state; AVX state is not saved, so the program must not be
+ *   built to keep values in the upper halves of the ymm registers.
+ * - x86-64 Linux only: the access is stepped with the trap flag, the
+ *   handlers read the page fault error code and set RIP and EFLAGS in the
+ *   signal context, and the trampoline is x86-64 assembly.
+ *
+ * Register proxies (C++ objects for PORTB and the rest whose assignment
+ * calls the models) would avoid the faults but not run the code as it
+ * is: avrlib and twi.c are C, pins_arduino.c and the cached port
+ * pointers take the registers' addresses, and the sources reach them
+ * through _SFR_BYTE() and _SFR_MEM8() as volatile lvalues in bit and
+ * compound operations.  Each of those would have to change for the host,
+ * and the host build exists to test the sources the board runs.
+ *
+ * Environment:
+ *   HAL_SECONDS=n    stop after n seconds of virtual time
+ *   HAL_EEPROM=file  load the EEPROM from file and save it on exit
+ *   HAL_CONSOLE=0    do not connect the serial port to stdin/stdout
+ *   HAL_STATS=1      print clock, interrupt and bus counts on exit
+ */
+#define HAL_REGISTERS		0x100
+#define HAL_PAGE_SIZE		4096
+#define HAL_STORE_CYCLES	2
+#define HAL_SPIN_STORES		4
+#define HAL_SPIN_POLLS		16				// reads in a row taken for a wait
+#define HAL_HUNG_SECONDS	2				// cpu time with no access at all
+#define HAL_SPIN_QUANTUM	(F_CPU / 1000)	// cycles skipped with nothing due
+#define HAL_HALT_CYCLES		F_CPU			// spinning with interrupts off
+#define HAL_NEVER			(~(uint64_t)0)
+
+#define HAL_VECTORS			_VECTORS_SIZE
+
+#define HAL_PORT_B			0
+#define HAL_PORT_C			1
+#define HAL_PORT_D			2
+#define HAL_PORTS			3
+
+#define HAL_ADC_CHANNELS	16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint8_t hal_sfr[];
+extern uint8_t hal_eeprom[E2END + 1];
+
+void hal_delay_cycles(uint32_t cycles);
+void hal_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * Bus and clock counters.
+ */
+struct HalStats
+{
+	uint64_t stores;
+	uint64_t polls;				// register and twi_state reads
+	uint64_t delays;
+	uint64_t events;
+	uint64_t spins;				// poll budgets run out
+	uint64_t skips;				// SREG store runs skipped over
+	uint64_t interrupts[HAL_VECTORS];
+	uint64_t serialTx;
+	uint64_t serialRx;
+	uint64_t serialOverruns;
+	uint64_t twiBytes;
+	uint64_t twiNacks;
+	uint64_t spiBytes;
+	uint64_t adcConversions;
+};
+
+/**
+ * Anything on the simulated board, on the chip or off it.  Devices are
+ * registered by construction; a static instance is enough.  All calls come
+ * from inside the HAL with the register page writable, so a device may
+ * change any cell of hal_sfr[].
+ */
+class HalDevice
+{
+public:
+	HalDevice();
+	virtual ~HalDevice() {}
+
+	/** Power on; registers already hold their reset values */
+	virtual void reset() {}
+
+	/** The code stored to register addr, which held old before */
+	virtual void store( uint8_t addr, uint8_t old ) {}
+
+	/** Cycle of the next event(), or HAL_NEVER */
+	virtual uint64_t next() { return HAL_NEVER; }
+
+	/** Called once next() has come due */
+	virtual void event( uint64_t now ) {}
+
+	/** Refresh registers that follow the clock, before the code resumes */
+	virtual void sync( uint64_t now ) {}
+
+	/** The handler for vector has just returned */
+	virtual void serviced( uint8_t vector ) {}
+
+	/** Levels on port changed; PINx holds the new ones */
+	virtual void pins( uint8_t port, uint8_t changed ) {}
+
+	/** A byte left the hardware serial port */
+	virtual void serialOut( uint8_t c ) {}
+
+	/** A conversion on channel is finishing; may replace the value */
+	virtual void analog( uint8_t channel, uint16_t *value ) {}
+
+	/** The run is over */
+	virtual void finish() {}
+
+	HalDevice *nextDevice;
+};
+
+/**
+ * A slave on the TWI bus.  The master's bus cycles come in as calls;
+ * returning false from twiStart() or twiWrite() is a NACK.
+ */
+class HalTwiDevice : public HalDevice
+{
+public:
+	HalTwiDevice( uint8_t address );
+
+	virtual bool twiStart( bool read ) = 0;
+	virtual bool twiWrite( uint8_t data ) = 0;
+	virtual uint8_t twiRead( bool ack ) = 0;
+	virtual void twiStop() {}
+
+	uint8_t twiAddress;
+	HalTwiDevice *nextTwi;
+};
+
+/**
+ * Makes the register page writable for the life of the object, for HAL
+ * functions that may be called from outside the HAL.
+ */
+class HalAccess
+{
+public:
+	HalAccess();
+	~HalAccess();
+
+private:
+	uint8_t wasOpen;
+	uint8_t wasBusy;
+};
+
+// clock
+uint64_t hal_now();
+double hal_seconds();
+void hal_limit( double seconds );
+void hal_finish( int status );
+HalStats *hal_stats();
+void hal_count_instructions( bool on );
+uint64_t hal_instructions();
+
+// devices
+HalDevice *hal_devices();
+HalTwiDevice *hal_twi_devices();
+
+// pins, by Arduino pin number
+uint8_t hal_pin_port( uint8_t pin );
+uint8_t hal_pin_mask( uint8_t pin );
+uint8_t hal_pin_read( uint8_t pin );
+void hal_pin_drive( uint8_t pin, uint8_t level );
+void hal_pin_release( uint8_t pin );
+
+// hardware serial port
+void hal_serial_input( const uint8_t *data, size_t length );
+void hal_serial_console( bool enable );
+uint32_t hal_serial_char_cycles();
+
+// analog inputs, 0..1023
+void hal_analog_set( uint8_t channel, uint16_t value );
+
+#endif /* HAL_H_ */
@@ -0,0 +1,756 @@
+/*
+ * hal_board.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal_board.h"
+
+HalPhStamp hal_ph_stamp;
+HalSerialLcd hal_lcd;
+HalDs1307 hal_ds1307;
+Hal24lc256 hal_24lc256;
+HalLm34 hal_lm34;
+
+static double envDouble( const char *name, double def )
+{
+	const char *s = getenv( name );
+
+	return s && *s ? atof( s ) : def;
+}
+
+/**
+ * Soft serial line
+ */
+HalSoftSerial::HalSoftSerial( int8_t listenPin, int8_t drivePin, uint32_t baud ) :
+	listenPin( listenPin ), drivePin( drivePin ), baud( baud )
+{
+}
+
+void HalSoftSerial::reset()
+{
+	rxBit = -1;
+	txBit = -1;
+	txHead = txTail = 0;
+	txAt = 0;
+	bytesIn = bytesOut = framingErrors = 0;
+
+	// the line idles high
+	if( drivePin >= 0 )
+	{
+		hal_pin_drive( drivePin, 1 );
+	}
+}
+
+/**
+ * Cycle at a number of half bits after start
+ */
+uint64_t HalSoftSerial::bitEdge( uint64_t start, uint8_t halfBits )
+{
+	return start + (uint64_t)halfBits * F_CPU / (2 * baud);
+}
+
+void HalSoftSerial::pins( uint8_t port, uint8_t changed )
+{
+	if( listenPin < 0 || port != hal_pin_port( listenPin ) ||
+		!(changed & hal_pin_mask( listenPin )) )
+	{
+		return;
+	}
+
+	// a falling edge on an idle line is a start bit
+	if( rxBit < 0 && !hal_pin_read( listenPin ) )
+	{
+		rxStart = hal_now();
+		rxByte = 0;
+		rxBit = 0;
+	}
+}
+
+uint64_t HalSoftSerial::next()
+{
+	uint64_t t = HAL_NEVER;
+
+	if( rxBit >= 0 )
+	{
+		t = bitEdge( rxStart, 2 * rxBit + 1 );
+	}
+	if( txBit >= 0 )
+	{
+		uint64_t end = bitEdge( txStart, 2 * (txBit + 1) );
+
+		t = end < t ? end : t;
+	}
+	else if( txHead != txTail && txAt < t )
+	{
+		t = txAt;
+	}
+	return t;
+}
+
+void HalSoftSerial::event( uint64_t now )
+{
+	// sample in the middle of each bit
+	while( rxBit >= 0 && bitEdge( rxStart, 2 * rxBit + 1 ) <= now )
+	{
+		uint8_t level = hal_pin_read( listenPin );
+
+		if( rxBit == 0 )
+		{
+			rxBit = level ? -1 : 1;		// a glitch if the start bit is gone
+		}
+		else if( rxBit <= 8 )
+		{
+			rxByte |= level << (rxBit - 1);
+			rxBit++;
+		}
+		else
+		{
+			rxBit = -1;
+			if( !level )
+			{
+				framingErrors++;
+				continue;
+			}
+			bytesIn++;
+			received( rxByte );
+		}
+	}
+
+	if( txBit >= 0 && bitEdge( txStart, 2 * (txBit + 1) ) <= now )
+	{
+		if( ++txBit == 10 )
+		{
+			txBit = -1;
+		}
+		else
+		{
+			// data bits LSB first, then the stop bit
+			hal_pin_drive( drivePin, txBit == 9 ? 1 : (txQueue[txTail] >> (txBit - 1)) & 1 );
+			if( txBit == 9 )
+			{
+				txTail = (txTail + 1) % HAL_SOFT_QUEUE;
+			}
+		}
+	}
+	if( txBit < 0 && txHead != txTail && txAt <= now )
+	{
+		txStart = now;
+		txBit = 0;
+		bytesOut++;
+		hal_pin_drive( drivePin, 0 );
+	}
+}
+
+void HalSoftSerial::send( const uint8_t *data, uint8_t length, uint64_t at )
+{
+	if( drivePin < 0 )
+	{
+		return;
+	}
+	if( txHead == txTail )
+	{
+		txAt = at;
+	}
+	while( length-- && (txHead + 1) % HAL_SOFT_QUEUE != txTail )
+	{
+		txQueue[txHead] = *data++;
+		txHead = (txHead + 1) % HAL_SOFT_QUEUE;
+	}
+}
+
+/**
+ * pH stamp
+ */
+HalPhStamp::HalPhStamp() : HalSoftSerial( HAL_PH_TX_PIN, HAL_PH_RX_PIN, HAL_PH_BAUD )
+{
+	ph = envDouble( "HAL_PH", 7.20 );
+	noise = envDouble( "HAL_PH_NOISE", 0.02 );
+	latency = envDouble( "HAL_PH_LATENCY", -1 );
+	seed = (uint32_t)envDouble( "HAL_SEED", 1 );
+}
+
+void HalPhStamp::reset()
+{
+	HalSoftSerial::reset();
+	lineLength = 0;
+	led = true;
+	continuous = false;
+	replyAt = HAL_NEVER;
+	temperature = 25.0;
+	commands = readings = unknown = 0;
+}
+
+void HalPhStamp::received( uint8_t c )
+{
+	if( c == '\r' )
+	{
+		line[lineLength] = 0;
+		if( lineLength )
+		{
+			command();
+		}
+		lineLength = 0;
+	}
+	else if( lineLength < HAL_PH_LINE - 1 )
+	{
+		line[lineLength++] = c;
+	}
+}
+
+void HalPhStamp::command()
+{
+	char *end;
+	double value = strtod( line, &end );
+
+	commands++;
+	if( !strcmp( line, "r" ) || !strcmp( line, "c" ) )
+	{
+		continuous = line[0] == 'c';
+		if( replyAt == HAL_NEVER )
+		{
+			replyAt = hal_now() + replyCycles();
+		}
+	}
+	else if( !strcmp( line, "e" ) )
+	{
+		continuous = false;
+		replyAt = HAL_NEVER;
+	}
+	else if( !strcmp( line, "l0" ) || !strcmp( line, "l1" ) )
+	{
+		led = line[1] == '1';
+	}
+	else if( end != line && !*end )
+	{
+		temperature = value;
+	}
+	else
+	{
+		unknown++;
+	}
+}
+
+uint64_t HalPhStamp::next()
+{
+	uint64_t t = HalSoftSerial::next();
+
+	return replyAt < t ? replyAt : t;
+}
+
+void HalPhStamp::event( uint64_t now )
+{
+	HalSoftSerial::event( now );
+	if( replyAt > now )
+	{
+		return;
+	}
+
+	double v = ph + noise * gaussian();
+	char reply[HAL_PH_LINE];
+
+	v = v < 0 ? 0 : v > 14 ? 14 : v;
+	snprintf( reply, sizeof(reply), "%.2f\r", v );
+	send( (const uint8_t *)reply, strlen( reply ), now );
+	readings++;
+
+	replyAt = continuous ? now + replyCycles() : HAL_NEVER;
+}
+
+uint64_t HalPhStamp::replyCycles()
+{
+	double ms = latency >= 0 ? latency : led ? 410 : 110;
+
+	return (uint64_t)(ms * (F_CPU / 1000));
+}
+
+/**
+ * Box-Muller, from a generator of our own so runs repeat
+ */
+double HalPhStamp::gaussian()
+{
+	double u = (rand_r( &seed ) + 1.0) / (RAND_MAX + 2.0);
+	double v = (rand_r( &seed ) + 1.0) / (RAND_MAX + 2.0);
+
+	return sqrt( -2 * log( u ) ) * cos( 2 * M_PI * v );
+}
+
+/**
+ * Serial LCD
+ */
+HalSerialLcd::HalSerialLcd() : HalSoftSerial( HAL_LCD_RX_PIN, -1, HAL_LCD_BAUD )
+{
+	const char *s = getenv( "HAL_LCD" );
+
+	draws = s && *s == '1';
+}
+
+void HalSerialLcd::reset()
+{
+	HalSoftSerial::reset();
+	for( uint8_t r = 0; r < HAL_LCD_LINES; r++ )
+	{
+		memset( screen[r], ' ', HAL_LCD_COLUMNS );
+		screen[r][HAL_LCD_COLUMNS] = 0;
+	}
+	cursor = 0;
+	displayOn = true;
+	contrast = 40;
+	brightness = 8;
+	pendingLength = 0;
+	characters = commands = clears = 0;
+}
+
+void HalSerialLcd::finish()
+{
+	if( draws )
+	{
+		draw( stderr );
+	}
+}
+
+void HalSerialLcd::draw( FILE *out )
+{
+	fprintf( out, "+--------------------+\n" );
+	for( uint8_t r = 0; r < HAL_LCD_LINES; r++ )
+	{
+		fprintf( out, "|%s|\n", displayOn ? screen[r] : "                    " );
+	}
+	fprintf( out, "+--------------------+\n" );
+}
+
+void HalSerialLcd::received( uint8_t c )
+{
+	// arguments each command takes, from 0x41
+	static const uint8_t argCounts[0x32] = {
+		0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,		// 0x41
+		0, 1, 1, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,		// 0x51
+		1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,		// 0x61
+		0, 0												// 0x71
+	};
+
+	if( pendingLength )
+	{
+		pending[pendingLength++] = c;
+		if( pendingLength == 2 )
+		{
+			pendingWanted = 2 + ((c >= 0x41 && c < 0x41 + sizeof(argCounts)) ?
+				argCounts[c - 0x41] : 0);
+		}
+		if( pendingLength == pendingWanted )
+		{
+			command( pending[1], pending + 2 );
+			pendingLength = 0;
+		}
+		return;
+	}
+	if( c == 0xfe )
+	{
+		pending[0] = c;
+		pendingLength = 1;
+		return;
+	}
+
+	char *p = cell( cursor );
+
+	if( p )
+	{
+		*p = c;
+	}
+	characters++;
+	advance();
+}
+
+void HalSerialLcd::command( uint8_t c, const uint8_t *args )
+{
+	commands++;
+	switch( c )
+	{
+	case 0x41: displayOn = true; break;
+	case 0x42: displayOn = false; break;
+	case 0x45: cursor = args[0]; break;
+	case 0x46: cursor = 0; break;
+	case 0x49: retreat(); break;
+	case 0x4a: advance(); break;
+	case 0x4e:
+		retreat();
+		if( cell( cursor ) )
+		{
+			*cell( cursor ) = ' ';
+		}
+		break;
+	case 0x51:
+		for( uint8_t r = 0; r < HAL_LCD_LINES; r++ )
+		{
+			memset( screen[r], ' ', HAL_LCD_COLUMNS );
+		}
+		cursor = 0;
+		clears++;
+		break;
+	case 0x52: contrast = args[0]; break;
+	case 0x53: brightness = args[0]; break;
+	}
+}
+
+/**
+ * Screen cell for a display RAM address: 0x00 and 0x40 start rows 1 and 2,
+ * 0x14 and 0x54 rows 3 and 4.
+ */
+char *HalSerialLcd::cell( uint8_t address )
+{
+	uint8_t half = address >= 0x40 ? 1 : 0;
+	uint8_t offset = address - 0x40 * half;
+
+	if( offset >= 2 * HAL_LCD_COLUMNS )
+	{
+		return 0;
+	}
+	return &screen[half + 2 * (offset / HAL_LCD_COLUMNS)][offset % HAL_LCD_COLUMNS];
+}
+
+void HalSerialLcd::advance()
+{
+	cursor++;
+	if( cursor == 2 * HAL_LCD_COLUMNS )
+	{
+		cursor = 0x40;
+	}
+	else if( cursor == 0x40 + 2 * HAL_LCD_COLUMNS )
+	{
+		cursor = 0;
+	}
+}
+
+void HalSerialLcd::retreat()
+{
+	if( cursor == 0 )
+	{
+		cursor = 0x40 + 2 * HAL_LCD_COLUMNS - 1;
+	}
+	else if( cursor == 0x40 )
+	{
+		cursor = 2 * HAL_LCD_COLUMNS - 1;
+	}
+	else
+	{
+		cursor--;
+	}
+}
+
+/**
+ * DS1307
+ */
+static uint8_t bcd( uint8_t v )
+{
+	return ((v / 10) << 4) | (v % 10);
+}
+
+static uint8_t bin( uint8_t v )
+{
+	return (v >> 4) * 10 + (v & 0x0f);
+}
+
+static uint8_t monthDays( uint8_t month, uint16_t year )
+{
+	static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	if( month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0) )
+	{
+		return 29;
+	}
+	return days[(month - 1) % 12];
+}
+
+HalDs1307::HalDs1307() : HalTwiDevice( HAL_DS1307_ADDRESS )
+{
+}
+
+void HalDs1307::reset()
+{
+	unsigned year = 2011, month = 7, date = 23, hour = 10, minute = 0, second = 0;
+	const char *s = getenv( "HAL_RTC" );
+
+	if( s )
+	{
+		sscanf( s, "%u-%u-%u %u:%u:%u", &year, &month, &date, &hour, &minute, &second );
+	}
+	memset( ram, 0, sizeof(ram) );
+	setTime( year, month, date, hour, minute, second );
+	pointer = 0;
+	pointerSet = false;
+	bytesIn = bytesOut = 0;
+}
+
+void HalDs1307::setTime( uint16_t year, uint8_t month, uint8_t date,
+	uint8_t hour, uint8_t minute, uint8_t second )
+{
+	// day of the week, 1 for Sunday
+	static const uint8_t offsets[12] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+	uint16_t y = month < 3 ? year - 1 : year;
+
+	ram[0] = bcd( second % 60 );
+	ram[1] = bcd( minute % 60 );
+	ram[2] = bcd( hour % 24 );
+	ram[3] = (y + y / 4 - y / 100 + y / 400 + offsets[(month - 1) % 12] + date) % 7 + 1;
+	ram[4] = bcd( date );
+	ram[5] = bcd( month );
+	ram[6] = bcd( year % 100 );
+	secondAt = hal_now() + F_CPU;
+}
+
+uint64_t HalDs1307::next()
+{
+	return (ram[0] & 0x80) ? HAL_NEVER : secondAt;
+}
+
+void HalDs1307::event( uint64_t now )
+{
+	while( !(ram[0] & 0x80) && secondAt <= now )
+	{
+		tick();
+		secondAt += F_CPU;
+	}
+}
+
+bool HalDs1307::twiStart( bool read )
+{
+	pointerSet = false;
+	return true;
+}
+
+bool HalDs1307::twiWrite( uint8_t data )
+{
+	bytesIn++;
+	if( !pointerSet )
+	{
+		pointer = data & (HAL_DS1307_SIZE - 1);
+		pointerSet = true;
+		return true;
+	}
+
+	ram[pointer] = data;
+	if( pointer == 0 )
+	{
+		secondAt = hal_now() + F_CPU;
+	}
+	pointer = (pointer + 1) & (HAL_DS1307_SIZE - 1);
+	return true;
+}
+
+uint8_t HalDs1307::twiRead( bool ack )
+{
+	uint8_t v = ram[pointer];
+
+	bytesOut++;
+	pointer = (pointer + 1) & (HAL_DS1307_SIZE - 1);
+	return v;
+}
+
+/**
+ * One second on, in BCD, through the 12 or 24 hour mode the hours
+ * register is in
+ */
+void HalDs1307::tick()
+{
+	uint8_t v = bin( ram[0] & 0x7f ) + 1;
+
+	if( v < 60 )
+	{
+		ram[0] = bcd( v );
+		return;
+	}
+	ram[0] = 0;
+
+	v = bin( ram[1] & 0x7f ) + 1;
+	if( v < 60 )
+	{
+		ram[1] = bcd( v );
+		return;
+	}
+	ram[1] = 0;
+
+	if( ram[2] & 0x40 )
+	{
+		uint8_t pm = ram[2] & 0x20;
+
+		v = bin( ram[2] & 0x1f );
+		if( v == 11 )
+		{
+			ram[2] = 0x40 | (pm ^ 0x20) | bcd( 12 );
+			if( !pm )
+			{
+				return;
+			}
+		}
+		else
+		{
+			ram[2] = 0x40 | pm | bcd( v == 12 ? 1 : v + 1 );
+			return;
+		}
+	}
+	else
+	{
+		v = bin( ram[2] & 0x3f ) + 1;
+		if( v < 24 )
+		{
+			ram[2] = bcd( v );
+			return;
+		}
+		ram[2] = 0;
+	}
+
+	ram[3] = ram[3] % 7 + 1;
+
+	uint8_t month = bin( ram[5] & 0x1f );
+	uint16_t year = 2000 + bin( ram[6] );
+
+	v = bin( ram[4] & 0x3f ) + 1;
+	if( v <= monthDays( month, year ) )
+	{
+		ram[4] = bcd( v );
+		return;
+	}
+	ram[4] = 1;
+	if( month < 12 )
+	{
+		ram[5] = bcd( month + 1 );
+		return;
+	}
+	ram[5] = 1;
+	ram[6] = bcd( (year + 1) % 100 );
+}
+
+/**
+ * 24LC256
+ */
+Hal24lc256::Hal24lc256() : HalTwiDevice( HAL_24LC_ADDRESS )
+{
+	file = getenv( "HAL_LOG_EEPROM" );
+	nackEvery = (uint32_t)envDouble( "HAL_LOG_NACK", 0 );
+}
+
+void Hal24lc256::reset()
+{
+	memset( memory, 0xff, sizeof(memory) );
+	if( file )
+	{
+		FILE *f = fopen( file, "rb" );
+
+		if( f )
+		{
+			if( fread( memory, 1, sizeof(memory), f ) ) {}
+			fclose( f );
+		}
+	}
+	address = 0;
+	addressBytes = 0;
+	pageLength = 0;
+	busyUntil = 0;
+	bytesIn = bytesOut = pageWrites = busyNacks = pagesNacked = 0;
+	pageStarts = 0;
+}
+
+void Hal24lc256::finish()
+{
+	FILE *f = file ? fopen( file, "wb" ) : 0;
+
+	if( f )
+	{
+		fwrite( memory, 1, sizeof(memory), f );
+		fclose( f );
+	}
+}
+
+bool Hal24lc256::twiStart( bool read )
+{
+	// deaf during the write cycle
+	if( hal_now() < busyUntil )
+	{
+		busyNacks++;
+		return false;
+	}
+	if( !read )
+	{
+		addressBytes = 0;
+		pageLength = 0;
+	}
+	return true;
+}
+
+bool Hal24lc256::twiWrite( uint8_t data )
+{
+	bytesIn++;
+	if( addressBytes < 2 )
+	{
+		address = (addressBytes++ ? address | data : data << 8) & (HAL_24LC_SIZE - 1);
+		return true;
+	}
+
+	if( pageLength == 0 && nackEvery && ++pageStarts % nackEvery == 0 )
+	{
+		pagesNacked++;
+		return false;
+	}
+
+	// past the end of the page the buffer wraps round
+	page[pageLength++ % HAL_24LC_PAGE] = data;
+	return true;
+}
+
+uint8_t Hal24lc256::twiRead( bool ack )
+{
+	uint8_t v = memory[address];
+
+	bytesOut++;
+	address = (address + 1) & (HAL_24LC_SIZE - 1);
+	return v;
+}
+
+void Hal24lc256::twiStop()
+{
+	if( addressBytes == 2 && pageLength )
+	{
+		uint16_t base = address & ~(HAL_24LC_PAGE - 1);
+		uint16_t first = pageLength > HAL_24LC_PAGE ? pageLength - HAL_24LC_PAGE : 0;
+
+		for( uint16_t i = first; i < pageLength; i++ )
+		{
+			memory[base + (address + i) % HAL_24LC_PAGE] = page[i % HAL_24LC_PAGE];
+		}
+		address = base + (address + pageLength) % HAL_24LC_PAGE;
+		pageWrites++;
+		busyUntil = hal_now() + HAL_24LC_WRITE_CYCLES;
+	}
+	addressBytes = 0;
+	pageLength = 0;
+}
+
+/**
+ * LM34
+ */
+HalLm34::HalLm34()
+{
+	fahrenheit = envDouble( "HAL_TEMP", 78.5 );
+}
+
+void HalLm34::analog( uint8_t channel, uint16_t *value )
+{
+	if( channel == 0 )
+	{
+		*value = (uint16_t)(fahrenheit * 10 * 1024 / 3320 + 0.5);
+	}
+	else if( channel == 1 )
+	{
+		*value = 1023;
+	}
+}
@@ -0,0 +1,283 @@
+/*
+ * hal_board.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef HAL_BOARD_H_
+#define HAL_BOARD_H_
+
+#include <stdio.h>
+#include "hal.h"
+
+/**
+ * The devices around the chip on the monitor board: the pH stamp, the
+ * DS1307 clock, the serial LCD, the 24LC256 log EEPROM and the LM34
+ * temperature sensor.  They sit on the pins and addresses the app uses and
+ * behave as seen from the code; the soft serial devices decode and drive
+ * the pin levels bit by bit.
+ *
+ * Environment:
+ *   HAL_PH=7.20              pH the stamp reads
+ *   HAL_PH_NOISE=0.02        standard deviation of the reading
+ *   HAL_PH_LATENCY=ms        reply time, else 410ms with the LED on, 110 off
+ *   HAL_SEED=n               noise seed
+ *   HAL_RTC=YYYY-MM-DD HH:MM:SS  time the clock starts at
+ *   HAL_LOG_EEPROM=file      load the 24LC256 from file and save it on exit
+ *   HAL_LOG_NACK=n           NACK the data of every nth page write to it
+ *   HAL_TEMP=78.5            degrees F at the LM34
+ *   HAL_LCD=1                draw the screen on exit
+ */
+#define HAL_PH_RX_PIN			6			// the app's RX, the stamp's TX
+#define HAL_PH_TX_PIN			7
+#define HAL_PH_BAUD				38400
+#define HAL_PH_LINE				16
+
+#define HAL_LCD_RX_PIN			4			// the app's TX
+#define HAL_LCD_BAUD			9600
+#define HAL_LCD_LINES			4
+#define HAL_LCD_COLUMNS			20
+
+#define HAL_DS1307_ADDRESS		0x68
+#define HAL_DS1307_SIZE			64
+
+#define HAL_24LC_ADDRESS		0x50
+#define HAL_24LC_SIZE			32768U
+#define HAL_24LC_PAGE			64
+#define HAL_24LC_WRITE_CYCLES	(F_CPU / 200)	// 5ms write cycle
+
+#define HAL_SOFT_QUEUE			64
+
+/**
+ * One end of a soft serial line, 8N1.  Listens on the pin the chip
+ * transmits on and drives the pin the chip receives on; either may be
+ * absent.
+ */
+class HalSoftSerial : public HalDevice
+{
+public:
+	HalSoftSerial( int8_t listenPin, int8_t drivePin, uint32_t baud );
+
+	void reset();
+	uint64_t next();
+	void event( uint64_t now );
+	void pins( uint8_t port, uint8_t changed );
+
+	/** Queues bytes to go out no sooner than cycle at */
+	void send( const uint8_t *data, uint8_t length, uint64_t at );
+
+	uint32_t bytesIn;
+	uint32_t bytesOut;
+	uint32_t framingErrors;
+
+protected:
+	/** A byte came in from the chip */
+	virtual void received( uint8_t c ) = 0;
+
+private:
+	uint64_t bitEdge( uint64_t start, uint8_t halfBits );
+
+	int8_t listenPin;
+	int8_t drivePin;
+	uint32_t baud;
+
+	int8_t rxBit;				// bit being sampled, -1 when idle
+	uint8_t rxByte;
+	uint64_t rxStart;
+
+	uint8_t txQueue[HAL_SOFT_QUEUE];
+	uint8_t txHead;
+	uint8_t txTail;
+	int8_t txBit;				// bit on the line, -1 when idle
+	uint64_t txStart;
+	uint64_t txAt;
+};
+
+/**
+ * Atlas Scientific pH stamp.  Lines end in CR.  "r" asks for one reading
+ * and "c" for one every reply time until "e"; "l0" and "l1" switch the LED,
+ * which slows the reply, and a bare number sets the compensation
+ * temperature.  A reading is the pH plus gaussian noise as "7.23\r".
+ */
+class HalPhStamp : public HalSoftSerial
+{
+public:
+	HalPhStamp();
+
+	void reset();
+	uint64_t next();
+	void event( uint64_t now );
+
+	void setPh( double ph ) { this->ph = ph; }
+	void setNoise( double noise ) { this->noise = noise; }
+	void setLatency( double ms ) { latency = ms; }
+	double getTemperature() { return temperature; }
+
+	uint32_t commands;
+	uint32_t readings;
+	uint32_t unknown;
+
+protected:
+	void received( uint8_t c );
+
+private:
+	void command();
+	uint64_t replyCycles();
+	double gaussian();
+
+	double ph;
+	double noise;
+	double latency;				// ms, or negative to follow the LED
+	double temperature;
+	uint32_t seed;
+
+	char line[HAL_PH_LINE];
+	uint8_t lineLength;
+	bool led;
+	bool continuous;
+	uint64_t replyAt;
+};
+
+/**
+ * Serial LCD, 4x20, on a write-only soft serial line.  0xFE starts a
+ * command, anything else is written at the cursor, which runs through the
+ * display RAM lines 1, 3, 2 and 4 as the controller's does.
+ */
+class HalSerialLcd : public HalSoftSerial
+{
+public:
+	HalSerialLcd();
+
+	void reset();
+	void finish();
+
+	/** Row 0-3 of the screen, HAL_LCD_COLUMNS characters */
+	const char *row( uint8_t n ) { return screen[n]; }
+	void draw( FILE *out );
+
+	bool displayOn;
+	uint8_t cursor;				// display RAM address
+	uint8_t contrast;
+	uint8_t brightness;
+
+	uint32_t characters;
+	uint32_t commands;
+	uint32_t clears;
+
+protected:
+	void received( uint8_t c );
+
+private:
+	void command( uint8_t c, const uint8_t *args );
+	char *cell( uint8_t address );
+	void advance();
+	void retreat();
+
+	char screen[HAL_LCD_LINES][HAL_LCD_COLUMNS + 1];
+	uint8_t pending[10];		// command and its arguments
+	uint8_t pendingLength;
+	uint8_t pendingWanted;
+	bool draws;
+};
+
+/**
+ * DS1307 real time clock: seven BCD time registers, control and 56 bytes
+ * of battery backed RAM behind a register pointer that wraps at 0x3f.  The
+ * clock counts while CH is clear; writing the seconds restarts the second.
+ */
+class HalDs1307 : public HalTwiDevice
+{
+public:
+	HalDs1307();
+
+	void reset();
+	uint64_t next();
+	void event( uint64_t now );
+
+	bool twiStart( bool read );
+	bool twiWrite( uint8_t data );
+	uint8_t twiRead( bool ack );
+
+	/** Sets the time registers, 24 hour mode, clock running */
+	void setTime( uint16_t year, uint8_t month, uint8_t date,
+		uint8_t hour, uint8_t minute, uint8_t second );
+
+	uint8_t ram[HAL_DS1307_SIZE];
+	uint32_t bytesIn;
+	uint32_t bytesOut;
+
+private:
+	void tick();
+
+	uint8_t pointer;
+	bool pointerSet;			// the first byte written sets the pointer
+	uint64_t secondAt;
+};
+
+/**
+ * 24LC256 EEPROM.  Writes fill a 64 byte page buffer that is programmed at
+ * the stop; the chip then ignores its address for the write cycle, which
+ * is what ACK polling waits out.  Reads run on across the whole array.
+ * With nackEvery set, every nth page write has its first data byte NACKed
+ * and is not programmed.
+ */
+class Hal24lc256 : public HalTwiDevice
+{
+public:
+	Hal24lc256();
+
+	void reset();
+	void finish();
+
+	bool twiStart( bool read );
+	bool twiWrite( uint8_t data );
+	uint8_t twiRead( bool ack );
+	void twiStop();
+
+	uint8_t memory[HAL_24LC_SIZE];
+	uint32_t bytesIn;
+	uint32_t bytesOut;
+	uint32_t pageWrites;
+	uint32_t busyNacks;
+	uint32_t nackEvery;
+	uint32_t pagesNacked;
+
+private:
+	uint16_t address;
+	uint8_t addressBytes;
+	uint8_t page[HAL_24LC_PAGE];
+	uint16_t pageLength;
+	uint32_t pageStarts;
+	uint64_t busyUntil;
+	const char *file;
+};
+
+/**
+ * LM34 on analog 0, 10mV per degree F, against the 3.32V reference on
+ * AREF; analog 1 reads the reference back.
+ */
+class HalLm34 : public HalDevice
+{
+public:
+	HalLm34();
+
+	void analog( uint8_t channel, uint16_t *value );
+
+	double fahrenheit;
+};
+
+extern HalPhStamp hal_ph_stamp;
+extern HalSerialLcd hal_lcd;
+extern HalDs1307 hal_ds1307;
+extern Hal24lc256 hal_24lc256;
+extern HalLm34 hal_lm34;
+
+#endif /* HAL_BOARD_H_ */
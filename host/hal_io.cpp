@@ -0,0 +1,1030 @@
+/*
+ * hal_io.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <compat/twi.h>
+#include "hal.h"
+
+/**
+ * ATmega328P peripheral models: i/o ports with pin change and external
+ * interrupts, the three timers, the USART, the ADC, SPI and the TWI
+ * master.  Each is a HalDevice watching its own registers.
+ */
+
+#define HAL_REG(sfr) _SFR_MEM_ADDR(sfr)
+#define REG(addr) hal_sfr[(addr)]
+#define REG16(addr) (hal_sfr[(addr)] | (hal_sfr[(addr) + 1] << 8))
+
+// the read-only and write-one-to-clear bits of a flag register
+static void clearFlags( uint8_t addr, uint8_t old, uint8_t flags )
+{
+	uint8_t written = REG(addr);
+
+	REG(addr) = (old & flags & ~written) | (written & ~flags) ;
+}
+
+/**
+ * I/O ports.  A pin reads what the chip drives when it is an output; as an
+ * input it reads what a device drives, else the pull-up, else low.
+ */
+class HalPorts : public HalDevice
+{
+public:
+	void reset()
+	{
+		for( uint8_t p = 0; p < HAL_PORTS; p++ )
+		{
+			last[p] = compute( p );
+			REG(pinAddr( p )) = last[p];
+		}
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		if( addr >= pinAddr( 0 ) && addr < pinAddr( HAL_PORTS ) )
+		{
+			uint8_t p = (addr - pinAddr( 0 )) / 3;
+
+			// writing a one to PINx toggles PORTx
+			if( addr == pinAddr( p ) )
+			{
+				REG(addr + 2) ^= REG(addr);
+			}
+			update( p );
+		}
+		else if( addr == HAL_REG(PCIFR) || addr == HAL_REG(EIFR) )
+		{
+			clearFlags( addr, old, 0xff );
+		}
+	}
+
+	void drive( uint8_t port, uint8_t mask, uint8_t level )
+	{
+		driven[port] |= mask;
+		levels[port] = level ? levels[port] | mask : levels[port] & ~mask;
+		update( port );
+	}
+
+	void release( uint8_t port, uint8_t mask )
+	{
+		driven[port] &= ~mask;
+		update( port );
+	}
+
+private:
+	static uint8_t pinAddr( uint8_t port )
+	{
+		return HAL_REG(PINB) + 3 * port;
+	}
+
+	uint8_t compute( uint8_t p )
+	{
+		uint8_t a = pinAddr( p );
+		uint8_t ddr = REG(a + 1), port = REG(a + 2);
+
+		return (ddr & port) |
+			(~ddr & ((driven[p] & levels[p]) | (~driven[p] & port)));
+	}
+
+	void update( uint8_t p )
+	{
+		uint8_t v = compute( p );
+		uint8_t changed = v ^ last[p];
+
+		REG(pinAddr( p )) = v;
+		last[p] = v;
+		if( !changed )
+		{
+			return;
+		}
+
+		// pin change interrupts: PCINT0-7 on port B, 8-14 on C, 16-23 on D
+		if( changed & REG(HAL_REG(PCMSK0) + p) )
+		{
+			REG(HAL_REG(PCIFR)) |= _BV(p);
+		}
+
+		// INT0 and INT1 on PD2 and PD3
+		if( p == HAL_PORT_D )
+		{
+			for( uint8_t n = 0; n < 2; n++ )
+			{
+				uint8_t bit = _BV(2 + n);
+				uint8_t sense = (REG(HAL_REG(EICRA)) >> (2 * n)) & 3;
+
+				if( (changed & bit) &&
+					(sense == 1 || (sense == 3) == ((v & bit) != 0)) )
+				{
+					REG(HAL_REG(EIFR)) |= _BV(n);
+				}
+			}
+		}
+
+		for( HalDevice *d = hal_devices(); d; d = d->nextDevice )
+		{
+			d->pins( p, changed );
+		}
+	}
+
+	uint8_t driven[HAL_PORTS];
+	uint8_t levels[HAL_PORTS];
+	uint8_t last[HAL_PORTS];
+};
+
+static HalPorts ports;
+
+/**
+ * Timer/counter.  The count is worked out from the clock when the code
+ * might read it, and an event is due only for a flag that is clear, so a
+ * timer whose flags nobody clears costs nothing.
+ */
+#define HAL_TIMER_FLAGS 3			// TOVn, OCFnA and OCFnB are bits 0-2
+
+static const uint16_t prescale01[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16_t prescale2[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+class HalTimer : public HalDevice
+{
+public:
+	HalTimer( uint8_t tccrA, uint8_t tifr, bool wide, const uint16_t *prescalers ) :
+		tccrA( tccrA ), tifr( tifr ), wide( wide ), prescalers( prescalers )
+	{
+		tcnt = wide ? tccrA + 4 : tccrA + 2;
+		ocrA = wide ? tccrA + 8 : tccrA + 3;
+		ocrB = wide ? tccrA + 10 : tccrA + 4;
+	}
+
+	void reset()
+	{
+		held = 0;
+		configure();
+		rebase( 0 );
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		if( addr == tifr )
+		{
+			clearFlags( addr, old, 0xff );
+			schedule();
+		}
+		else if( addr == tcnt || (wide && addr == tcnt + 1) )
+		{
+			configure();
+			rebase( read16( tcnt ) );
+		}
+		else if( (addr >= tccrA && addr <= tccrA + 1) ||
+			(addr >= ocrA && addr < ocrB + (wide ? 2 : 1)) ||
+			(wide && (addr == tccrA + 6 || addr == tccrA + 7)) )
+		{
+			uint16_t c = count( hal_now() );
+
+			configure();
+			rebase( c );
+		}
+	}
+
+	uint64_t next()
+	{
+		uint64_t t = HAL_NEVER;
+
+		for( uint8_t f = 0; f < HAL_TIMER_FLAGS; f++ )
+		{
+			if( due[f] < t )
+			{
+				t = due[f];
+			}
+		}
+		return t;
+	}
+
+	void event( uint64_t now )
+	{
+		for( uint8_t f = 0; f < HAL_TIMER_FLAGS; f++ )
+		{
+			if( due[f] <= now )
+			{
+				REG(tifr) |= _BV(f);
+			}
+		}
+		schedule();
+	}
+
+	void serviced( uint8_t vector )
+	{
+		// taking the vector may have cleared one of the flags
+		schedule();
+	}
+
+	void sync( uint64_t now )
+	{
+		uint16_t c = count( now );
+
+		REG(tcnt) = c;
+		if( wide )
+		{
+			REG(tcnt + 1) = c >> 8;
+		}
+	}
+
+private:
+	uint16_t read16( uint8_t addr )
+	{
+		return wide ? REG16(addr) : REG(addr);
+	}
+
+	/**
+	 * Top, slope and prescaler from the waveform generation mode and clock
+	 * select bits.
+	 */
+	void configure()
+	{
+		uint8_t a = REG(tccrA), b = REG(tccrA + 1);
+		uint8_t mode;
+
+		prescale = prescalers[b & 7];
+		dual = false;
+		overflows = true;
+		if( wide )
+		{
+			static const uint16_t tops[16] = {
+				0xffff, 0xff, 0x1ff, 0x3ff, 0, 0xff, 0x1ff, 0x3ff,
+				1, 0, 1, 0, 1, 0xffff, 1, 0
+			};
+			mode = (a & 3) | ((b >> 1) & 0x0c);
+			top = tops[mode];
+			if( mode == 4 || mode == 9 || mode == 11 || mode == 15 )
+			{
+				top = REG16(ocrA);
+			}
+			else if( top == 1 )
+			{
+				top = REG16(tccrA + 6);		// ICR1
+			}
+			dual = (mode >= 1 && mode <= 3) || (mode >= 8 && mode <= 11);
+			overflows = mode != 4 && mode != 12;
+		}
+		else
+		{
+			mode = (a & 3) | ((b >> 1) & 0x04);
+			top = (mode == 2 || mode == 5 || mode == 7) ? REG(ocrA) : 0xff;
+			dual = mode == 1 || mode == 5;
+			overflows = mode != 2;
+		}
+		if( dual && top == 0 )
+		{
+			top = 1;
+		}
+	}
+
+	uint32_t period()
+	{
+		return dual ? 2UL * top : top + 1UL;
+	}
+
+	uint16_t count( uint64_t now )
+	{
+		if( !prescale )
+		{
+			return held;
+		}
+
+		uint64_t ticks = (now - base) / prescale;
+		uint32_t phase = ticks % period();
+
+		return (!dual || phase <= top) ? phase : period() - phase;
+	}
+
+	void rebase( uint16_t c )
+	{
+		held = c;
+		base = hal_now() - (uint64_t)c * prescale;
+		schedule();
+	}
+
+	/**
+	 * Next cycle each clear flag gets set: TOV at the wrap (or at BOTTOM
+	 * when dual slope), OCF when the count reaches the compare value.
+	 */
+	void schedule()
+	{
+		uint16_t phases[HAL_TIMER_FLAGS] = { 0, read16( ocrA ), read16( ocrB ) };
+		uint64_t ticks = prescale ? (hal_now() - base) / prescale : 0;
+
+		for( uint8_t f = 0; f < HAL_TIMER_FLAGS; f++ )
+		{
+			due[f] = HAL_NEVER;
+			if( !prescale || (REG(tifr) & _BV(f)) || phases[f] > top ||
+				(f == 0 && !overflows) )
+			{
+				continue;
+			}
+
+			uint64_t n = ticks - ticks % period() + phases[f];
+			if( n <= ticks )
+			{
+				n += period();
+			}
+			due[f] = base + n * prescale;
+		}
+	}
+
+	uint8_t tccrA, tifr, tcnt, ocrA, ocrB;
+	bool wide;
+	const uint16_t *prescalers;
+
+	uint16_t prescale;
+	uint16_t top;
+	bool dual;
+	bool overflows;
+	uint16_t held;
+	uint64_t base;
+	uint64_t due[HAL_TIMER_FLAGS];
+};
+
+static HalTimer timer0( HAL_REG(TCCR0A), HAL_REG(TIFR0), false, prescale01 );
+static HalTimer timer1( HAL_REG(TCCR1A), HAL_REG(TIFR1), true, prescale01 );
+static HalTimer timer2( HAL_REG(TCCR2A), HAL_REG(TIFR2), false, prescale2 );
+
+/**
+ * USART0.  The transmitter is a holding register in front of a shift
+ * register, the receiver a two byte FIFO, both paced at the configured
+ * frame time.  The received byte is taken as read when the RX handler
+ * returns.  Unless the console is turned off, transmitted bytes go to
+ * stdout and stdin is fed to the receiver.
+ */
+#define HAL_SERIAL_QUEUE	1024
+#define HAL_SERIAL_LINE		256
+#define HAL_STDIN_POLL		(F_CPU / 1000)
+
+class HalUsart : public HalDevice
+{
+public:
+	HalUsart()
+	{
+		const char *s = getenv( "HAL_CONSOLE" );
+
+		console = !(s && *s == '0');
+		stdinOpen = console;
+	}
+
+	void reset()
+	{
+		shift = holding = -1;
+		rxCount = 0;
+		rxBusy = false;
+		rxData = 0;
+		pollAt = 0;
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		if( addr == HAL_REG(UDR0) )
+		{
+			uint8_t c = REG(addr);
+
+			// reads of UDR0 come from the receiver
+			REG(addr) = rxData;
+			if( !(REG(HAL_REG(UCSR0B)) & _BV(TXEN0)) )
+			{
+				return;
+			}
+			if( shift < 0 )
+			{
+				shift = c;
+				shiftDone = hal_now() + charCycles();
+				REG(HAL_REG(UCSR0A)) &= ~_BV(TXC0);
+			}
+			else if( REG(HAL_REG(UCSR0A)) & _BV(UDRE0) )
+			{
+				holding = c;
+				REG(HAL_REG(UCSR0A)) &= ~_BV(UDRE0);
+			}
+		}
+		else if( addr == HAL_REG(UCSR0A) )
+		{
+			uint8_t w = REG(addr);
+
+			REG(addr) = (old & (_BV(RXC0) | _BV(UDRE0) | _BV(FE0) | _BV(DOR0) | _BV(UPE0))) |
+				(old & ~w & _BV(TXC0)) | (w & (_BV(U2X0) | _BV(MPCM0)));
+		}
+	}
+
+	uint64_t next()
+	{
+		uint64_t t = HAL_NEVER;
+
+		if( shift >= 0 )
+		{
+			t = shiftDone;
+		}
+		if( rxBusy )
+		{
+			t = rxDone < t ? rxDone : t;
+		}
+		else if( (REG(HAL_REG(UCSR0B)) & _BV(RXEN0)) && queued() )
+		{
+			t = hal_now();
+		}
+		else if( stdinOpen && pollAt < t )
+		{
+			t = pollAt;
+		}
+		return t;
+	}
+
+	void event( uint64_t now )
+	{
+		if( shift >= 0 && shiftDone <= now )
+		{
+			transmitted( shift );
+			if( holding >= 0 )
+			{
+				shift = holding;
+				holding = -1;
+				shiftDone += charCycles();
+				REG(HAL_REG(UCSR0A)) |= _BV(UDRE0);
+			}
+			else
+			{
+				shift = -1;
+				REG(HAL_REG(UCSR0A)) |= _BV(TXC0);
+			}
+		}
+
+		if( rxBusy && rxDone <= now )
+		{
+			rxBusy = false;
+			if( rxCount < 2 )
+			{
+				rxFifo[rxCount++] = rxShift;
+				rxData = rxFifo[0];
+				REG(HAL_REG(UDR0)) = rxData;
+				REG(HAL_REG(UCSR0A)) |= _BV(RXC0);
+				hal_stats()->serialRx++;
+			}
+			else
+			{
+				REG(HAL_REG(UCSR0A)) |= _BV(DOR0);
+				hal_stats()->serialOverruns++;
+			}
+		}
+
+		if( !rxBusy && (REG(HAL_REG(UCSR0B)) & _BV(RXEN0)) && queued() )
+		{
+			rxShift = queue[queueTail];
+			queueTail = (queueTail + 1) % HAL_SERIAL_QUEUE;
+			rxBusy = true;
+			rxDone = now + charCycles();
+		}
+
+		if( stdinOpen && pollAt <= now )
+		{
+			readStdin();
+			pollAt = now + HAL_STDIN_POLL;
+		}
+	}
+
+	void serviced( uint8_t vector )
+	{
+		// the handler read UDR0
+		if( vector == 18 && rxCount )
+		{
+			if( --rxCount )
+			{
+				rxFifo[0] = rxFifo[1];
+				rxData = rxFifo[0];
+				REG(HAL_REG(UDR0)) = rxData;
+			}
+			else
+			{
+				REG(HAL_REG(UCSR0A)) &= ~_BV(RXC0);
+			}
+		}
+	}
+
+	void finish()
+	{
+		flushLine();
+	}
+
+	void input( const uint8_t *data, size_t length )
+	{
+		while( length-- && (queueHead + 1) % HAL_SERIAL_QUEUE != queueTail )
+		{
+			queue[queueHead] = *data++;
+			queueHead = (queueHead + 1) % HAL_SERIAL_QUEUE;
+		}
+	}
+
+	void setConsole( bool enable )
+	{
+		console = enable;
+		stdinOpen = enable;
+	}
+
+	/**
+	 * Frame length in cycles from the baud rate, character size, parity
+	 * and stop bits.
+	 */
+	uint32_t charCycles()
+	{
+		uint16_t ubrr = REG16(HAL_REG(UBRR0L)) & 0x0fff;
+		uint8_t c = REG(HAL_REG(UCSR0C));
+		uint8_t bits = 1 + 5 + ((c >> 1) & 3) + ((c >> 3) & 1) + 1;
+
+		if( REG(HAL_REG(UCSR0B)) & _BV(UCSZ02) )
+		{
+			bits = 1 + 9 + ((c >> 3) & 1) + 1;
+		}
+		if( c & 0x20 )
+		{
+			bits++;
+		}
+		return bits * ((REG(HAL_REG(UCSR0A)) & _BV(U2X0)) ? 8UL : 16UL) * (ubrr + 1);
+	}
+
+private:
+	bool queued()
+	{
+		return queueHead != queueTail;
+	}
+
+	void transmitted( uint8_t c )
+	{
+		hal_stats()->serialTx++;
+		for( HalDevice *d = hal_devices(); d; d = d->nextDevice )
+		{
+			d->serialOut( c );
+		}
+		if( console )
+		{
+			line[lineLength++] = c;
+			if( c == '\n' || lineLength == HAL_SERIAL_LINE )
+			{
+				flushLine();
+			}
+		}
+	}
+
+	void flushLine()
+	{
+		if( lineLength && write( 1, line, lineLength ) < 0 )
+		{
+			console = false;
+		}
+		lineLength = 0;
+	}
+
+	void readStdin()
+	{
+		struct pollfd p = { 0, POLLIN, 0 };
+		uint8_t buffer[64];
+
+		// only take what the queue has room for
+		if( (queueHead + sizeof(buffer) + 1) % HAL_SERIAL_QUEUE == queueTail ||
+			poll( &p, 1, 0 ) <= 0 )
+		{
+			return;
+		}
+
+		ssize_t n = read( 0, buffer, sizeof(buffer) );
+		if( n <= 0 )
+		{
+			stdinOpen = false;
+			return;
+		}
+		input( buffer, n );
+	}
+
+	bool console;
+	bool stdinOpen;
+	int shift;
+	int holding;
+	uint64_t shiftDone;
+
+	uint8_t queue[HAL_SERIAL_QUEUE];
+	uint16_t queueHead;
+	uint16_t queueTail;
+	bool rxBusy;
+	uint8_t rxShift;
+	uint64_t rxDone;
+	uint8_t rxFifo[2];
+	uint8_t rxCount;
+	uint8_t rxData;
+	uint64_t pollAt;
+
+	uint8_t line[HAL_SERIAL_LINE];
+	uint16_t lineLength;
+};
+
+static HalUsart usart;
+
+/**
+ * ADC.  A conversion takes 13 ADC clocks, 25 for the first after the ADC
+ * is enabled; free running mode starts the next straight away.  Inputs
+ * are set with hal_analog_set() and devices may override them.
+ */
+class HalAdc : public HalDevice
+{
+public:
+	HalAdc()
+	{
+		memset( inputs, 0, sizeof(inputs) );
+		inputs[14] = 225;			// 1.1V bandgap against a 5V reference
+	}
+
+	void reset()
+	{
+		busy = false;
+		first = true;
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		if( addr != HAL_REG(ADCSRA) )
+		{
+			return;
+		}
+
+		clearFlags( addr, old, _BV(ADIF) );
+		uint8_t a = REG(addr);
+
+		if( !(a & _BV(ADEN)) )
+		{
+			busy = false;
+			first = true;
+			REG(addr) &= ~_BV(ADSC);
+		}
+		else if( (a & _BV(ADSC)) && !busy )
+		{
+			start( hal_now() );
+		}
+		else if( busy )
+		{
+			// ADSC reads one until the conversion ends
+			REG(addr) |= _BV(ADSC);
+		}
+	}
+
+	uint64_t next()
+	{
+		return busy ? done : HAL_NEVER;
+	}
+
+	void event( uint64_t now )
+	{
+		uint16_t value = inputs[channel];
+
+		for( HalDevice *d = hal_devices(); d; d = d->nextDevice )
+		{
+			d->analog( channel, &value );
+		}
+		if( value > 1023 )
+		{
+			value = 1023;
+		}
+		if( REG(HAL_REG(ADMUX)) & _BV(ADLAR) )
+		{
+			value <<= 6;
+		}
+		REG(HAL_REG(ADCL)) = value;
+		REG(HAL_REG(ADCH)) = value >> 8;
+		REG(HAL_REG(ADCSRA)) |= _BV(ADIF);
+		hal_stats()->adcConversions++;
+
+		busy = false;
+		if( (REG(HAL_REG(ADCSRA)) & _BV(ADATE)) && (REG(HAL_REG(ADCSRB)) & 7) == 0 )
+		{
+			start( now );
+		}
+		else
+		{
+			REG(HAL_REG(ADCSRA)) &= ~_BV(ADSC);
+		}
+	}
+
+	uint16_t inputs[HAL_ADC_CHANNELS];
+
+private:
+	void start( uint64_t now )
+	{
+		uint8_t ps = REG(HAL_REG(ADCSRA)) & 7;
+
+		channel = REG(HAL_REG(ADMUX)) & 0x0f;
+		done = now + (first ? 25UL : 13UL) * (ps ? 1UL << ps : 2UL);
+		first = false;
+		busy = true;
+	}
+
+	bool busy;
+	bool first;
+	uint8_t channel;
+	uint64_t done;
+};
+
+static HalAdc adc;
+
+/**
+ * SPI master.  Nothing answers, so MISO reads high.
+ */
+class HalSpi : public HalDevice
+{
+public:
+	void reset()
+	{
+		busy = false;
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		uint8_t c = REG(HAL_REG(SPCR));
+
+		if( addr == HAL_REG(SPSR) )
+		{
+			REG(addr) = (old & 0xfe) | (REG(addr) & _BV(SPI2X));
+		}
+		else if( addr == HAL_REG(SPDR) && (c & _BV(SPE)) && (c & _BV(MSTR)) )
+		{
+			static const uint8_t dividers[4] = { 4, 16, 64, 128 };
+			uint32_t div = dividers[c & 3];
+
+			if( REG(HAL_REG(SPSR)) & _BV(SPI2X) )
+			{
+				div /= 2;
+			}
+
+			// reading SPSR then touching SPDR clears SPIF
+			REG(HAL_REG(SPSR)) &= ~_BV(SPIF);
+			done = hal_now() + 8 * div;
+			busy = true;
+		}
+	}
+
+	uint64_t next()
+	{
+		return busy ? done : HAL_NEVER;
+	}
+
+	void event( uint64_t now )
+	{
+		busy = false;
+		REG(HAL_REG(SPDR)) = 0xff;
+		REG(HAL_REG(SPSR)) |= _BV(SPIF);
+		hal_stats()->spiBytes++;
+	}
+
+private:
+	bool busy;
+	uint64_t done;
+};
+
+static HalSpi spi;
+
+/**
+ * TWI master.  A start, a stop or a byte begins when the code writes TWINT
+ * and the result shows up a bus time later, with TWINT set and the status
+ * in TWSR.  Bytes go to whichever HalTwiDevice has the address; with none
+ * there the address is NACKed.
+ */
+#define HAL_TWI_IDLE		0
+#define HAL_TWI_ADDRESS		1
+#define HAL_TWI_WRITE		2
+#define HAL_TWI_READ		3
+#define HAL_TWI_NACKED		4
+
+#define HAL_TWI_START_OP	1
+#define HAL_TWI_BYTE_OP		2
+
+class HalTwi : public HalDevice
+{
+public:
+	void reset()
+	{
+		state = HAL_TWI_IDLE;
+		op = 0;
+		device = 0;
+	}
+
+	void store( uint8_t addr, uint8_t old )
+	{
+		if( addr == HAL_REG(TWSR) )
+		{
+			REG(addr) = (old & 0xf8) | (REG(addr) & 3);
+			return;
+		}
+		if( addr != HAL_REG(TWCR) )
+		{
+			return;
+		}
+
+		uint8_t w = REG(addr);
+
+		// writing one clears TWINT; TWWC is read only
+		REG(addr) = (w & ~(_BV(TWINT) | _BV(TWWC))) |
+			((w & _BV(TWINT)) ? 0 : old & _BV(TWINT));
+
+		if( !(w & _BV(TWEN)) )
+		{
+			stop();
+			op = 0;
+			return;
+		}
+		if( !(w & _BV(TWINT)) )
+		{
+			return;
+		}
+
+		if( w & _BV(TWSTO) )
+		{
+			// a stop takes no time worth modelling and never sets TWINT
+			stop();
+			op = 0;
+			REG(addr) &= ~_BV(TWSTO);
+			if( !(w & _BV(TWSTA)) )
+			{
+				return;
+			}
+		}
+
+		if( w & _BV(TWSTA) )
+		{
+			op = HAL_TWI_START_OP;
+			done = hal_now() + bitCycles();
+		}
+		else if( state != HAL_TWI_IDLE )
+		{
+			op = HAL_TWI_BYTE_OP;
+			done = hal_now() + 9 * bitCycles();
+		}
+	}
+
+	uint64_t next()
+	{
+		return op ? done : HAL_NEVER;
+	}
+
+	void event( uint64_t now )
+	{
+		uint8_t status;
+
+		if( op == HAL_TWI_START_OP )
+		{
+			status = state == HAL_TWI_IDLE ? TW_START : TW_REP_START;
+			state = HAL_TWI_ADDRESS;
+		}
+		else
+		{
+			hal_stats()->twiBytes++;
+			status = byte();
+		}
+		op = 0;
+
+		REG(HAL_REG(TWSR)) = (REG(HAL_REG(TWSR)) & 3) | status;
+		REG(HAL_REG(TWCR)) |= _BV(TWINT);
+	}
+
+private:
+	uint32_t bitCycles()
+	{
+		static const uint8_t prescale[4] = { 1, 4, 16, 64 };
+
+		return 16 + 2UL * REG(HAL_REG(TWBR)) * prescale[REG(HAL_REG(TWSR)) & 3];
+	}
+
+	uint8_t byte()
+	{
+		uint8_t data = REG(HAL_REG(TWDR));
+		bool ack;
+
+		switch( state )
+		{
+		case HAL_TWI_ADDRESS:
+			read = data & 1;
+			device = 0;
+			for( HalTwiDevice *d = hal_twi_devices(); d; d = d->nextTwi )
+			{
+				if( d->twiAddress == (data >> 1) )
+				{
+					device = d;
+					break;
+				}
+			}
+			ack = device && device->twiStart( read );
+			state = !ack ? HAL_TWI_NACKED : read ? HAL_TWI_READ : HAL_TWI_WRITE;
+			if( !ack )
+			{
+				hal_stats()->twiNacks++;
+				return read ? TW_MR_SLA_NACK : TW_MT_SLA_NACK;
+			}
+			return read ? TW_MR_SLA_ACK : TW_MT_SLA_ACK;
+
+		case HAL_TWI_WRITE:
+			if( device->twiWrite( data ) )
+			{
+				return TW_MT_DATA_ACK;
+			}
+			hal_stats()->twiNacks++;
+			return TW_MT_DATA_NACK;
+
+		case HAL_TWI_READ:
+			ack = (REG(HAL_REG(TWCR)) & _BV(TWEA)) != 0;
+			REG(HAL_REG(TWDR)) = device->twiRead( ack );
+			return ack ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+		}
+
+		// clocking bytes after a NACK
+		hal_stats()->twiNacks++;
+		return read ? TW_MR_DATA_NACK : TW_MT_DATA_NACK;
+	}
+
+	void stop()
+	{
+		if( device )
+		{
+			device->twiStop();
+		}
+		device = 0;
+		state = HAL_TWI_IDLE;
+	}
+
+	uint8_t state;
+	uint8_t op;
+	bool read;
+	uint64_t done;
+	HalTwiDevice *device;
+};
+
+static HalTwi twi;
+
+/**
+ * Pins, by Arduino pin number: 0-7 on port D, 8-13 on port B and the
+ * analog pins 14-19 on port C.
+ */
+uint8_t hal_pin_port( uint8_t pin )
+{
+	return pin < 8 ? HAL_PORT_D : pin < 14 ? HAL_PORT_B : HAL_PORT_C;
+}
+
+uint8_t hal_pin_mask( uint8_t pin )
+{
+	return _BV(pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14);
+}
+
+uint8_t hal_pin_read( uint8_t pin )
+{
+	HalAccess access;
+
+	return (hal_sfr[HAL_REG(PINB) + 3 * hal_pin_port( pin )] & hal_pin_mask( pin )) != 0;
+}
+
+void hal_pin_drive( uint8_t pin, uint8_t level )
+{
+	HalAccess access;
+
+	ports.drive( hal_pin_port( pin ), hal_pin_mask( pin ), level );
+}
+
+void hal_pin_release( uint8_t pin )
+{
+	HalAccess access;
+
+	ports.release( hal_pin_port( pin ), hal_pin_mask( pin ) );
+}
+
+void hal_serial_input( const uint8_t *data, size_t length )
+{
+	HalAccess access;
+
+	usart.input( data, length );
+}
+
+void hal_serial_console( bool enable )
+{
+	usart.setConsole( enable );
+}
+
+uint32_t hal_serial_char_cycles()
+{
+	HalAccess access;
+
+	return usart.charCycles();
+}
+
+void hal_analog_set( uint8_t channel, uint16_t value )
+{
+	adc.inputs[channel & (HAL_ADC_CHANNELS - 1)] = value;
+}
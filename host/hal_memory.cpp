@@ -0,0 +1,45 @@
+/*
+ * hal_memory.cpp
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include "wiring.h"
+
+/**
+ * SRAM usage for the host build, in place of avrlib's wiring_memory.c,
+ * which reads the AVR linker's heap symbols and paints the stack from
+ * .init1.  The host has no AVR data space to measure, so it reports it
+ * as empty.
+ */
+int freeMemory(void)
+{
+	return 0;
+}
+
+unsigned int heapTop(void)
+{
+	return 0;
+}
+
+unsigned int largestFreeBlock(void)
+{
+	return 0;
+}
+
+unsigned int stackUnused(void)
+{
+	return 0;
+}
+
+unsigned int stackHighWater(void)
+{
+	return 0;
+}
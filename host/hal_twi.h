@@ -0,0 +1,40 @@
+/*
+ * hal_twi.h
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+
+#ifndef HAL_TWI_H_
+#define HAL_TWI_H_
+
+#include <stdint.h>
+
+/**
+ * Included ahead of twi.c by the host Makefile.  twi.c waits for its
+ * interrupt handler by reading twi_state, which is in RAM, so the HAL
+ * would see no register access for the whole wait.  Every use of
+ * twi_state goes through hal_poll() here and counts towards the same
+ * spin budget as a register read.  twi.c's own declaration of twi_state
+ * becomes a declaration of the function below.
+ */
+void hal_poll(void);
+
+static volatile uint8_t hal_twi_state;
+
+static volatile uint8_t *hal_twi_state_watch(void)
+{
+	hal_poll();
+	return &hal_twi_state;
+}
+
+#define twi_state (*hal_twi_state_watch())
+
+#endif /* HAL_TWI_H_ */
@@ -0,0 +1,10 @@
+/*
+  avr/delay.h - host stand-in for the deprecated avr-libc header.
+*/
+
+#ifndef _HOST_AVR_DELAY_H_
+#define _HOST_AVR_DELAY_H_
+
+#include <util/delay.h>
+
+#endif
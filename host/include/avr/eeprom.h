@@ -0,0 +1,95 @@
+/*
+  avr/eeprom.h - host stand-in: the EEPROM is the byte array hal_eeprom[].
+
+  hal.cpp loads and saves it from the file named by HAL_EEPROM, so
+  settings and history survive between runs like they do on the board.
+
+  Every byte written costs the chip's 3.3ms programming time on the
+  virtual clock; the update functions only pay for the bytes that change.
+  avr-libc waits before a write rather than after, so on the board the
+  last byte's time falls on whatever runs next; here it falls on the
+  writer.
+*/
+
+#ifndef _HOST_AVR_EEPROM_H_
+#define _HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint8_t hal_eeprom[E2END + 1];
+
+void hal_delay_cycles(uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define __HOST_EEPROM_ADDR(p) ((uintptr_t)(p) & E2END)
+#define __HOST_EEPROM_WRITE_CYCLES (F_CPU / 10000 * 33)
+
+static inline uint8_t eeprom_read_byte(const uint8_t *p)
+{
+	return hal_eeprom[__HOST_EEPROM_ADDR(p)];
+}
+
+static inline uint16_t eeprom_read_word(const uint16_t *p)
+{
+	return hal_eeprom[__HOST_EEPROM_ADDR(p)] |
+		(hal_eeprom[__HOST_EEPROM_ADDR(p) + 1] << 8);
+}
+
+static inline void eeprom_write_byte(uint8_t *p, uint8_t value)
+{
+	hal_eeprom[__HOST_EEPROM_ADDR(p)] = value;
+	hal_delay_cycles(__HOST_EEPROM_WRITE_CYCLES);
+}
+
+static inline void eeprom_write_word(uint16_t *p, uint16_t value)
+{
+	eeprom_write_byte((uint8_t *)p, value);
+	eeprom_write_byte((uint8_t *)p + 1, value >> 8);
+}
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+	memcpy(dst, &hal_eeprom[__HOST_EEPROM_ADDR(src)], n);
+}
+
+static inline void eeprom_write_block(const void *src, void *dst, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		eeprom_write_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+}
+
+static inline void eeprom_update_byte(uint8_t *p, uint8_t value)
+{
+	if (eeprom_read_byte(p) != value)
+		eeprom_write_byte(p, value);
+}
+
+static inline void eeprom_update_word(uint16_t *p, uint16_t value)
+{
+	eeprom_update_byte((uint8_t *)p, value);
+	eeprom_update_byte((uint8_t *)p + 1, value >> 8);
+}
+
+static inline void eeprom_update_block(const void *src, void *dst, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		eeprom_update_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+}
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait() do { } while (0)
+
+#endif
@@ -0,0 +1,33 @@
+/*
+  avr/interrupt.h - host stand-in for interrupt control.
+
+  The global interrupt flag lives in the simulated SREG; ISR() bodies become
+  ordinary functions named after their vector, which hal.cpp dispatches.
+*/
+
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define sei() (SREG |= _BV(SREG_I))
+#define cli() (SREG &= (uint8_t)~_BV(SREG_I))
+
+#ifdef __cplusplus
+#define __HOST_ISR_LINKAGE extern "C"
+#else
+#define __HOST_ISR_LINKAGE
+#endif
+
+#define ISR(vector, ...) \
+	__HOST_ISR_LINKAGE void vector(void); \
+	__HOST_ISR_LINKAGE void vector(void)
+#define SIGNAL(vector) ISR(vector)
+#define EMPTY_INTERRUPT(vector) ISR(vector) { }
+#define reti() return
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#endif
@@ -0,0 +1,38 @@
+/*
+  avr/pgmspace.h - host stand-in: program memory is ordinary memory.
+*/
+
+#ifndef _HOST_AVR_PGMSPACE_H_
+#define _HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PGM_VOID_P const void *
+#define PSTR(s) (s)
+
+typedef char prog_char;
+typedef unsigned char prog_uchar;
+typedef uint8_t prog_uint8_t;
+typedef uint16_t prog_uint16_t;
+typedef uint32_t prog_uint32_t;
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+#define pgm_read_dword_near(addr) pgm_read_dword(addr)
+
+#define strlen_P(s) strlen(s)
+#define strcpy_P(d, s) strcpy((d), (s))
+#define strncpy_P(d, s, n) strncpy((d), (s), (n))
+#define strcmp_P(a, b) strcmp((a), (b))
+#define strcasecmp_P(a, b) strcasecmp((a), (b))
+#define strncmp_P(a, b, n) strncmp((a), (b), (n))
+#define memcpy_P(d, s, n) memcpy((d), (s), (n))
+
+#endif
@@ -0,0 +1,52 @@
+/*
+  avr/sfr_defs.h - host stand-in for the avr-libc SFR access macros.
+
+  Every register is a cell in hal_sfr[], indexed by its data-space address,
+  so pointers to registers (as stored by HardwareSerial, SoftwareSerial and
+  the pin tables) point into the same array the peripheral models watch.
+  hal.cpp keeps that array on its own read-only page: reads cost nothing,
+  and every store traps into the model of the register written.
+*/
+
+#ifndef _HOST_AVR_SFR_DEFS_H_
+#define _HOST_AVR_SFR_DEFS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint8_t hal_sfr[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#define __SFR_OFFSET 0x20
+
+#define _MMIO_BYTE(mem_addr) (hal_sfr[(mem_addr)])
+#define _MMIO_WORD(mem_addr) (*(volatile uint16_t *)&hal_sfr[(mem_addr)])
+
+#define _SFR_MEM8(mem_addr) _MMIO_BYTE(mem_addr)
+#define _SFR_MEM16(mem_addr) _MMIO_WORD(mem_addr)
+#define _SFR_IO8(io_addr) _MMIO_BYTE((io_addr) + __SFR_OFFSET)
+#define _SFR_IO16(io_addr) _MMIO_WORD((io_addr) + __SFR_OFFSET)
+
+#define _SFR_MEM_ADDR(sfr) ((uint16_t) (&(sfr) - hal_sfr))
+#define _SFR_IO_ADDR(sfr) (_SFR_MEM_ADDR(sfr) - __SFR_OFFSET)
+#define _SFR_IO_REG_P(sfr) (_SFR_MEM_ADDR(sfr) < 0x40 + __SFR_OFFSET)
+#define _SFR_ADDR(sfr) _SFR_MEM_ADDR(sfr)
+#define _SFR_BYTE(sfr) (sfr)
+#define _SFR_WORD(sfr) (*(volatile uint16_t *)&(sfr))
+
+#define _BV(bit) (1 << (bit))
+
+#define bit_is_set(sfr, bit) (_SFR_BYTE(sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!(_SFR_BYTE(sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) do { } while (bit_is_set(sfr, bit))
+
+#define _VECTOR(N) __vector_ ## N
+
+#endif
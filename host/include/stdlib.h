@@ -0,0 +1,61 @@
+/*
+  stdlib.h - host stand-in: the C library's stdlib.h plus the avr-libc
+  integer to string conversions it does not have.
+*/
+
+#ifndef _HOST_STDLIB_H_
+#define _HOST_STDLIB_H_
+
+#include_next <stdlib.h>
+
+static inline char *__host_ultoa(unsigned long value, char *s, int radix, int negative)
+{
+	char *p = s, *q;
+
+	if (radix < 2 || radix > 36) {
+		*s = 0;
+		return s;
+	}
+	if (negative)
+		*p++ = '-';
+	q = p;
+	do {
+		int d = value % radix;
+		*p++ = d < 10 ? '0' + d : 'a' + d - 10;
+		value /= radix;
+	} while (value);
+	*p-- = 0;
+	while (q < p) {
+		char c = *q;
+		*q++ = *p;
+		*p-- = c;
+	}
+	return s;
+}
+
+static inline char *ultoa(unsigned long value, char *s, int radix)
+{
+	return __host_ultoa(value, s, radix, 0);
+}
+
+static inline char *utoa(unsigned int value, char *s, int radix)
+{
+	return __host_ultoa(value, s, radix, 0);
+}
+
+// like avr-libc, only base 10 gets a sign
+static inline char *ltoa(long value, char *s, int radix)
+{
+	if (radix == 10 && value < 0)
+		return __host_ultoa(-(unsigned long)value, s, radix, 1);
+	return __host_ultoa((unsigned long)value, s, radix, 0);
+}
+
+static inline char *itoa(int value, char *s, int radix)
+{
+	if (radix == 10 && value < 0)
+		return __host_ultoa(-(unsigned long)(long)value, s, radix, 1);
+	return __host_ultoa((unsigned int)value, s, radix, 0);
+}
+
+#endif
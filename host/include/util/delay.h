@@ -0,0 +1,13 @@
+/*
+  util/delay.h - host stand-in: timed delays advance the virtual clock.
+*/
+
+#ifndef _HOST_UTIL_DELAY_H_
+#define _HOST_UTIL_DELAY_H_
+
+#include <util/delay_basic.h>
+
+#define _delay_us(us) hal_delay_cycles((uint32_t)((double)(us) * (F_CPU / 1000000.0)))
+#define _delay_ms(ms) hal_delay_cycles((uint32_t)((double)(ms) * (F_CPU / 1000.0)))
+
+#endif
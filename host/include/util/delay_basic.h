@@ -0,0 +1,23 @@
+/*
+  util/delay_basic.h - host stand-in: busy loops advance the virtual clock.
+*/
+
+#ifndef _HOST_UTIL_DELAY_BASIC_H_
+#define _HOST_UTIL_DELAY_BASIC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void hal_delay_cycles(uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define _delay_loop_1(count) hal_delay_cycles(3UL * ((count) ? (count) : 256))
+#define _delay_loop_2(count) hal_delay_cycles(4UL * ((count) ? (count) : 65536UL))
+
+#endif
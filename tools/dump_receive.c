@@ -0,0 +1,477 @@
+/*
+ * dump_receive.c
+ *
+ * Host side receiver for the AqMonitor log export ('x' console command).
+ * Starts the export, acknowledges each frame, checks every record's crc
+ * and sequence, restarts from the first missing record after a loss and
+ * prints the records as CSV.  At the end it reports the throughput
+ * against what the serial line can carry.
+ *
+ *   cc -O2 -o dump_receive tools/dump_receive.c
+ *   ./dump_receive /dev/ttyUSB0 from to [offset] > log.csv
+ *
+ * from and to are seconds since 2000 (the 'r' command shows the clock's);
+ * "0 4294967295" exports the whole log.  -b sets the baud rate, 115200 by
+ * default.
+ *
+ * "dump_receive -t" runs a self test against a generated export with a
+ * lost frame and line noise.
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../AqMonitorApp/TelemetryFrame.h"
+
+/* 2000-01-01 00:00:00 UTC as a Unix time */
+#define EPOCH_2000 946684800L
+
+#define FRAME_SIZE (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE)
+
+#define IDLE_TIMEOUT	2.0	/* seconds without a frame before a restart */
+#define RESTART_HOLDOFF	0.3	/* frames already in flight when restarting */
+#define MAX_RESTARTS	20
+
+typedef void (*record_handler)(const uint8_t *, void *);
+
+struct receiver {
+	int fd;			/* -1: commands are only kept in sent */
+	char sent[64];		/* last command */
+	record_handler handler;
+	void *arg;
+	unsigned long from, to;
+	uint32_t expected;	/* next record we need */
+	uint8_t frame[FRAME_SIZE];
+	unsigned n;
+	int done;
+	double started, lastFrame, lastRestart;
+	unsigned long records, wireBytes, crcErrors, badRecords, restarts;
+};
+
+/* the self test stops the clock here so that its run does not depend on
+ * how fast it goes */
+static double stoppedClock = -1;
+
+static double now(void)
+{
+	struct timeval tv;
+
+	if (stoppedClock >= 0)
+		return stoppedClock;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static int openPort(const char *path, long baud)
+{
+	struct termios tio;
+	speed_t speed;
+	int fd;
+
+	switch (baud) {
+	case 9600: speed = B9600; break;
+	case 19200: speed = B19200; break;
+	case 38400: speed = B38400; break;
+	case 57600: speed = B57600; break;
+	case 115200: speed = B115200; break;
+	default:
+		fprintf(stderr, "unsupported baud rate %ld\n", baud);
+		return -1;
+	}
+
+	if ((fd = open(path, O_RDWR | O_NOCTTY)) < 0) {
+		perror(path);
+		return -1;
+	}
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+static void command(struct receiver *r, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void command(struct receiver *r, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(r->sent, sizeof(r->sent), fmt, ap);
+	va_end(ap);
+	if (r->fd >= 0 && write(r->fd, r->sent, n) != n)
+		perror("write");
+}
+
+/* Asks for everything from the first record we are missing */
+static void restart(struct receiver *r)
+{
+	r->restarts++;
+	r->lastRestart = r->lastFrame = now();
+	command(r, "x%lu %lu %lu\r", r->from, r->to, (unsigned long)r->expected);
+}
+
+static void printRecord(const uint8_t *p, void *arg)
+{
+	time_t t = (time_t)get32(p + 4) + EPOCH_2000;
+	int16_t temp = get16(p + 8), ph = get16(p + 10);
+	char when[32];
+
+	(void)arg;
+	strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+	printf("%lu,%s,%s%d.%02d,%s%d.%02d,%u\n", (unsigned long)get32(p), when,
+	       temp < 0 ? "-" : "", abs(temp / 100), abs(temp % 100),
+	       ph < 0 ? "-" : "", abs(ph / 100), abs(ph % 100), get16(p + 12));
+}
+
+static void dumpFrame(struct receiver *r, const uint8_t *payload, uint8_t length)
+{
+	uint32_t first = get32(payload), next = get32(payload + 4);
+	const uint8_t *p;
+	uint16_t crc;
+	unsigned i;
+
+	if (first > r->expected) {
+		/* a frame went missing; frames of the old window that are still
+		 * arriving after a restart are not news */
+		if (now() - r->lastRestart >= RESTART_HOLDOFF)
+			restart(r);
+		return;
+	}
+
+	for (p = payload + TELEMETRY_DUMP_HEADER_SIZE; p + TELEMETRY_DUMP_RECORD_SIZE <= payload + length;
+	     p += TELEMETRY_DUMP_RECORD_SIZE) {
+		crc = TELEMETRY_CRC_START;
+		for (i = 0; i < TELEMETRY_DUMP_RECORD_SIZE - 2; i++)
+			crc = telemetryCrcUpdate(crc, p[i]);
+		if (crc != get16(p + TELEMETRY_DUMP_RECORD_SIZE - 2)) {
+			r->badRecords++;
+			continue;
+		}
+		if (get32(p) < r->expected)
+			continue;	/* resent */
+		r->handler(p, r->arg);
+		r->records++;
+	}
+
+	if (next > r->expected)
+		r->expected = next;
+	command(r, "o%lu\r", (unsigned long)r->expected);
+}
+
+static void endFrame(struct receiver *r, const uint8_t *payload)
+{
+	if (payload[4] == TELEMETRY_DUMP_DONE && get32(payload) <= r->expected)
+		r->done = 1;
+	else if (payload[4] == TELEMETRY_DUMP_DONE && now() - r->lastRestart >= RESTART_HOLDOFF)
+		restart(r);	/* ended before we had it all */
+	/* an aborted end is the old run making way for our restart */
+}
+
+/* Returns 0 if the frame is corrupt */
+static int frameIn(struct receiver *r)
+{
+	const uint8_t *payload = r->frame + TELEMETRY_HEADER_SIZE;
+	uint8_t length = r->frame[2];
+	uint16_t crc = TELEMETRY_CRC_START;
+	unsigned i;
+
+	for (i = 1; i < (unsigned)(TELEMETRY_HEADER_SIZE + length); i++)
+		crc = telemetryCrcUpdate(crc, r->frame[i]);
+	if (crc != get16(payload + length)) {
+		r->crcErrors++;
+		return 0;
+	}
+	r->lastFrame = now();
+
+	if (r->frame[1] == TELEMETRY_TYPE_DUMP && length >= TELEMETRY_DUMP_HEADER_SIZE)
+		dumpFrame(r, payload, length);
+	else if (r->frame[1] == TELEMETRY_TYPE_DUMP_END && length >= TELEMETRY_DUMP_END_SIZE)
+		endFrame(r, payload);
+	return 1;
+}
+
+static void resync(struct receiver *r);
+
+/* Frame assembly; a bad frame only costs its sync byte, the rest is
+ * scanned again */
+static void byteIn(struct receiver *r, uint8_t c)
+{
+	if (r->n == 0 && c != TELEMETRY_SYNC)
+		return;
+	r->frame[r->n++] = c;
+	if (r->n == 3 && r->frame[2] > TELEMETRY_MAX_PAYLOAD) {
+		resync(r);
+		return;
+	}
+	if (r->n >= TELEMETRY_HEADER_SIZE &&
+	    r->n == (unsigned)(TELEMETRY_HEADER_SIZE + r->frame[2] + TELEMETRY_CRC_SIZE)) {
+		if (frameIn(r))
+			r->n = 0;
+		else
+			resync(r);
+	}
+}
+
+/* Drops the first byte of the buffered frame and scans the rest again */
+static void resync(struct receiver *r)
+{
+	uint8_t rest[FRAME_SIZE];
+	unsigned n = r->n - 1;
+	unsigned i;
+
+	memcpy(rest, r->frame + 1, n);
+	r->n = 0;
+	for (i = 0; i < n; i++)
+		byteIn(r, rest[i]);
+}
+
+/* Self test: an export behind console text and a false sync whose length
+ * runs into the first frame, with one frame corrupted on the line.  The
+ * receiver must ask for the rest again, and gets it as the device would
+ * send it. */
+
+#define TEST_RECORDS	24
+#define TEST_PER_FRAME	3
+#define TEST_LOST	2	/* frame that is corrupted */
+#define TEST_EPOCH	844819200UL
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static size_t encodeFrame(uint8_t *out, uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length)
+{
+	uint16_t crc = TELEMETRY_CRC_START;
+	size_t n = 0, i;
+
+	out[n++] = TELEMETRY_SYNC;
+	out[n++] = type;
+	out[n++] = length;
+	out[n++] = sequence;
+	memcpy(out + n, payload, length);
+	n += length;
+	for (i = 1; i < n; i++)
+		crc = telemetryCrcUpdate(crc, out[i]);
+	out[n++] = crc;
+	out[n++] = crc >> 8;
+	return n;
+}
+
+static int16_t testTemp(uint32_t sequence)
+{
+	return sequence < 4 ? -(int16_t)sequence * 33 : 7850 + (int16_t)sequence;
+}
+
+/* The frame of records first.. as Dump::poll() builds it */
+static size_t testFrame(uint8_t *out, uint32_t first, uint8_t sequence)
+{
+	uint8_t payload[TELEMETRY_MAX_PAYLOAD], *p;
+	uint32_t k, next = first + TEST_PER_FRAME;
+	uint16_t crc;
+	unsigned i;
+
+	put32(payload, first);
+	put32(payload + 4, next);
+	for (k = first, p = payload + TELEMETRY_DUMP_HEADER_SIZE; k < next; k++, p += TELEMETRY_DUMP_RECORD_SIZE) {
+		put32(p, k);
+		put32(p + 4, TEST_EPOCH + k * 10);
+		put16(p + 8, testTemp(k));
+		put16(p + 10, 810);
+		put16(p + 12, k / 7);
+		crc = TELEMETRY_CRC_START;
+		for (i = 0; i < TELEMETRY_DUMP_RECORD_SIZE - 2; i++)
+			crc = telemetryCrcUpdate(crc, p[i]);
+		put16(p + 14, crc);
+	}
+	return encodeFrame(out, TELEMETRY_TYPE_DUMP, sequence, payload, p - payload);
+}
+
+static size_t testEnd(uint8_t *out, uint32_t next, uint8_t status, uint8_t sequence)
+{
+	uint8_t payload[TELEMETRY_DUMP_END_SIZE];
+
+	put32(payload, next);
+	payload[4] = status;
+	return encodeFrame(out, TELEMETRY_TYPE_DUMP_END, sequence, payload, sizeof(payload));
+}
+
+static void checkRecord(const uint8_t *p, void *arg)
+{
+	uint32_t *next = arg;
+
+	if (get32(p) == *next && get32(p + 4) == TEST_EPOCH + *next * 10 &&
+	    (int16_t)get16(p + 8) == testTemp(*next))
+		(*next)++;
+}
+
+static int selfTest(void)
+{
+	static const char noise[] = "Logger: slot 0, record 0\r\n";
+	struct receiver r;
+	uint8_t stream[2048];
+	unsigned long from, to, offset = 0;
+	uint32_t k, checked = 0;
+	uint8_t sequence = 0;
+	size_t n = 0, i;
+
+	memset(&r, 0, sizeof(r));
+	r.fd = -1;
+	r.to = 0xffffffffUL;
+	r.handler = checkRecord;
+	r.arg = &checked;
+	stoppedClock = 100.0;
+
+	memcpy(stream + n, noise, sizeof(noise) - 1);
+	n += sizeof(noise) - 1;
+	stream[n++] = TELEMETRY_SYNC;
+	stream[n++] = TELEMETRY_TYPE_DUMP;
+	stream[n++] = 12;
+	for (k = 0; k < TEST_RECORDS; k += TEST_PER_FRAME) {
+		i = n;
+		n += testFrame(stream + n, k, sequence++);
+		if (k == TEST_LOST * TEST_PER_FRAME)
+			stream[i + 10] ^= 0x40;
+	}
+	n += testEnd(stream + n, TEST_RECORDS, TELEMETRY_DUMP_DONE, sequence++);
+	for (i = 0; i < n; i++)
+		byteIn(&r, stream[i]);
+
+	/* the device answers the restart from the record asked for */
+	if (!r.done && sscanf(r.sent, "x%lu %lu %lu", &from, &to, &offset) == 3) {
+		n = testEnd(stream, offset, TELEMETRY_DUMP_ABORTED, sequence++);
+		for (k = offset; k < TEST_RECORDS; k += TEST_PER_FRAME)
+			n += testFrame(stream + n, k, sequence++);
+		n += testEnd(stream + n, TEST_RECORDS, TELEMETRY_DUMP_DONE, sequence++);
+		for (i = 0; i < n; i++)
+			byteIn(&r, stream[i]);
+	}
+
+	fprintf(stderr, "%lu records, %lu bad frames, %lu restarts from %lu, next record %lu\n",
+	        r.records, r.crcErrors, r.restarts, offset, (unsigned long)r.expected);
+	if (!r.done || checked != TEST_RECORDS || r.records != TEST_RECORDS || r.restarts != 1 ||
+	    offset != TEST_LOST * TEST_PER_FRAME || r.crcErrors < 2) {
+		fprintf(stderr, "self test FAILED\n");
+		return 1;
+	}
+	fprintf(stderr, "self test passed\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct receiver r;
+	uint8_t buffer[512];
+	struct timeval tv;
+	fd_set fds;
+	long baud = 115200;
+	double elapsed, line;
+	ssize_t got;
+	int i, arg = 1;
+
+	if (argc > 1 && strcmp(argv[1], "-t") == 0)
+		return selfTest();
+
+	if (argc > 2 && strcmp(argv[1], "-b") == 0) {
+		baud = atol(argv[2]);
+		arg = 3;
+	}
+	if (argc - arg < 3) {
+		fprintf(stderr, "usage: %s [-b baud] device from to [offset] | -t\n", argv[0]);
+		return 2;
+	}
+
+	memset(&r, 0, sizeof(r));
+	r.handler = printRecord;
+	if ((r.fd = openPort(argv[arg], baud)) < 0)
+		return 1;
+	r.from = strtoul(argv[arg + 1], NULL, 10);
+	r.to = strtoul(argv[arg + 2], NULL, 10);
+	r.expected = argc - arg > 3 ? strtoul(argv[arg + 3], NULL, 10) : 0;
+
+	tcflush(r.fd, TCIFLUSH);
+	printf("sequence,time,temp,ph,errors\n");
+	r.started = now();
+	restart(&r);
+	r.restarts = 0;
+
+	while (!r.done) {
+		FD_ZERO(&fds);
+		FD_SET(r.fd, &fds);
+		tv.tv_sec = 0;
+		tv.tv_usec = 100000;
+		if (select(r.fd + 1, &fds, NULL, NULL, &tv) < 0 && errno != EINTR) {
+			perror("select");
+			return 1;
+		}
+		if (FD_ISSET(r.fd, &fds)) {
+			if ((got = read(r.fd, buffer, sizeof(buffer))) < 0) {
+				perror("read");
+				return 1;
+			}
+			r.wireBytes += got;
+			for (i = 0; i < got; i++)
+				byteIn(&r, buffer[i]);
+		}
+		if (!r.done && now() - r.lastFrame > IDLE_TIMEOUT) {
+			if (r.restarts >= MAX_RESTARTS) {
+				fprintf(stderr, "no answer, giving up at record %lu\n", (unsigned long)r.expected);
+				break;
+			}
+			restart(&r);
+		}
+	}
+	fflush(stdout);
+
+	elapsed = now() - r.started;
+	line = baud / 10.0;	/* 8N1: ten bits a byte */
+	fprintf(stderr, "%lu records in %.2f s, next record %lu\n", r.records, elapsed,
+	        (unsigned long)r.expected);
+	fprintf(stderr, "record data %.0f B/s, line %.0f B/s of %.0f B/s possible (%.0f%%)\n",
+	        r.records * (double)TELEMETRY_DUMP_RECORD_SIZE / elapsed, r.wireBytes / elapsed,
+	        line, 100.0 * r.wireBytes / elapsed / line);
+	fprintf(stderr, "%lu bad frames, %lu bad records, %lu restarts\n",
+	        r.crcErrors, r.badRecords, r.restarts);
+	return r.done ? 0 : 1;
+}
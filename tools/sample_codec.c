@@ -0,0 +1,374 @@
+/*
+ * sample_codec.c
+ *
+ * Host side encoder, decoder and benchmark for the AqMonitor sample codec
+ * (AqMonitorApp/SampleCodec.h).  Works on the CSV that telemetry_decode
+ * prints:
+ *
+ *   cc -O2 -o sample_codec tools/sample_codec.c
+ *   ./sample_codec -e log.csv > log.bin     encode into blocks
+ *   ./sample_codec -d log.bin > log.csv     decode blocks back to CSV
+ *   ./sample_codec -b log.csv               compression ratio benchmark
+ *   ./sample_codec -g 86400 > day.csv       synthetic day for -b
+ *   ./sample_codec -t                       self test
+ *
+ * The block file is a series of blocks, each a 16 bit little endian
+ * length followed by that many bytes.
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../AqMonitorApp/SampleCodec.h"
+
+/* 2000-01-01 00:00:00 UTC as a Unix time */
+#define EPOCH_2000 946684800L
+
+#define MAX_BLOCK 4096
+
+struct records {
+	struct sample_record *r;
+	size_t n;
+	size_t size;
+};
+
+static void addRecord(struct records *rs, const struct sample_record *r)
+{
+	if (rs->n == rs->size) {
+		rs->size = rs->size ? rs->size * 2 : 1024;
+		rs->r = realloc(rs->r, rs->size * sizeof(*rs->r));
+		if (rs->r == NULL) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	rs->r[rs->n++] = *r;
+}
+
+/* "78.5" or "-0.07" to hundredths */
+static int16_t parseHundredths(const char *s)
+{
+	int negative = (*s == '-');
+	long whole, frac = 0;
+	char *end;
+
+	whole = labs(strtol(s, &end, 10));
+	if (*end == '.') {
+		end++;
+		if (end[0] >= '0' && end[0] <= '9') {
+			frac = (end[0] - '0') * 10;
+			if (end[1] >= '0' && end[1] <= '9')
+				frac += end[1] - '0';
+		}
+	}
+	return (int16_t)(negative ? -(whole * 100 + frac) : whole * 100 + frac);
+}
+
+/* sequence,YYYY-MM-DDTHH:MM:SS,temp,ph,errors */
+static void readCsv(FILE *in, struct records *rs)
+{
+	char line[256], when[32], temp[16], ph[16];
+	unsigned sequence, errors;
+	struct sample_record r;
+	struct tm tm;
+
+	while (fgets(line, sizeof(line), in)) {
+		if (sscanf(line, "%u,%31[^,],%15[^,],%15[^,],%u", &sequence, when, temp, ph, &errors) != 5)
+			continue;	/* header or junk */
+		memset(&tm, 0, sizeof(tm));
+		if (sscanf(when, "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+		           &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+			continue;
+		tm.tm_year -= 1900;
+		tm.tm_mon -= 1;
+		r.epoch = (uint32_t)(timegm(&tm) - EPOCH_2000);
+		r.temp = parseHundredths(temp);
+		r.ph = parseHundredths(ph);
+		r.errors = errors;
+		addRecord(rs, &r);
+	}
+}
+
+static void printCsv(unsigned sequence, const struct sample_record *r)
+{
+	time_t t = (time_t)r->epoch + EPOCH_2000;
+	char when[32];
+
+	strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+	printf("%u,%s,%s%d.%02d,%s%d.%02d,%u\n", sequence, when,
+	       r->temp < 0 ? "-" : "", abs(r->temp / 100), abs(r->temp % 100),
+	       r->ph < 0 ? "-" : "", abs(r->ph / 100), abs(r->ph % 100),
+	       r->errors);
+}
+
+/*
+ * Encodes all records into blocks of blockSize, calling emit for each.
+ * Returns the total encoded size.
+ */
+typedef void (*block_handler)(const uint8_t *block, uint16_t length, void *arg);
+
+static size_t encodeAll(const struct records *rs, uint16_t blockSize, uint8_t keyInterval,
+                        block_handler emit, void *arg)
+{
+	struct sample_encoder e;
+	uint8_t block[MAX_BLOCK];
+	size_t total = 0, i;
+
+	sampleEncoderBegin(&e, block, blockSize, keyInterval);
+	for (i = 0; i < rs->n; i++) {
+		if (!sampleEncode(&e, &rs->r[i])) {
+			total += e.length;
+			if (emit)
+				emit(block, e.length, arg);
+			sampleEncoderBegin(&e, block, blockSize, keyInterval);
+			sampleEncode(&e, &rs->r[i]);
+		}
+	}
+	if (e.length) {
+		total += e.length;
+		if (emit)
+			emit(block, e.length, arg);
+	}
+	return total;
+}
+
+static void writeBlock(const uint8_t *block, uint16_t length, void *arg)
+{
+	FILE *out = arg;
+
+	putc(length, out);
+	putc(length >> 8, out);
+	fwrite(block, 1, length, out);
+}
+
+struct check {
+	const struct records *rs;
+	size_t next;
+	int bad;
+};
+
+/* Decodes a block and compares it with the records it came from */
+static void checkBlock(const uint8_t *block, uint16_t length, void *arg)
+{
+	struct check *c = arg;
+	struct sample_decoder d;
+	struct sample_record r;
+	const struct sample_record *w;
+	int8_t status;
+
+	sampleDecoderBegin(&d, block, length);
+	while ((status = sampleDecode(&d, &r)) == 1) {
+		if (c->next >= c->rs->n) {
+			c->bad++;
+			return;
+		}
+		w = &c->rs->r[c->next++];
+		if (r.epoch != w->epoch || r.temp != w->temp || r.ph != w->ph || r.errors != w->errors)
+			c->bad++;
+	}
+	if (status < 0)
+		c->bad++;
+}
+
+static int roundTrip(const struct records *rs, uint16_t blockSize, uint8_t keyInterval, size_t *total)
+{
+	struct check c;
+
+	memset(&c, 0, sizeof(c));
+	c.rs = rs;
+	*total = encodeAll(rs, blockSize, keyInterval, checkBlock, &c);
+	return c.bad == 0 && c.next == rs->n;
+}
+
+static int decodeFile(FILE *in)
+{
+	struct sample_decoder d;
+	struct sample_record r;
+	uint8_t block[MAX_BLOCK];
+	unsigned sequence = 0;
+	int lo, hi, status;
+	unsigned length;
+
+	printf("sequence,time,temp,ph,errors\n");
+	while ((lo = getc(in)) != EOF && (hi = getc(in)) != EOF) {
+		length = lo | (hi << 8);
+		if (length > MAX_BLOCK || fread(block, 1, length, in) != length) {
+			fprintf(stderr, "truncated block\n");
+			return 1;
+		}
+		sampleDecoderBegin(&d, block, length);
+		while ((status = sampleDecode(&d, &r)) == 1)
+			printCsv(sequence++, &r);
+		if (status < 0)
+			fprintf(stderr, "corrupt block, rest skipped\n");
+	}
+	return 0;
+}
+
+/* Slow drift, a heater cycling, pH swinging with the lights, the odd
+ * pH error and one clock adjustment. */
+static void generate(struct records *rs, unsigned long n)
+{
+	struct sample_record r;
+	unsigned long i;
+	double temp = 7850, ph = 810;
+
+	srand(1);
+	r.epoch = 844819200UL;
+	r.errors = 0;
+	for (i = 0; i < n; i++) {
+		temp += ((i / 1800) % 2 ? 0.02 : -0.02) + (rand() % 3 - 1) * 0.3;
+		ph += (((i / 43200) % 2) ? 0.002 : -0.002) + (rand() % 5 == 0 ? (rand() % 3 - 1) : 0);
+		r.temp = (int16_t)temp;
+		r.ph = (int16_t)ph;
+		if (rand() % 5000 == 0)
+			r.errors++;
+		r.epoch += (rand() % 10 == 0) ? 2 : 1;	/* pH reads stretch some cycles */
+		if (i == n / 2)
+			r.epoch -= 3600;
+		addRecord(rs, &r);
+	}
+}
+
+static int benchmark(const struct records *rs)
+{
+	static const struct {
+		uint16_t size;
+		uint8_t keyInterval;
+		const char *use;
+	} configs[] = {
+		{ 64, 0, "telemetry frame / 24LC256 page" },
+		{ 128, 0, "24LC512 page" },
+		{ 4096, 64, "stream, keyframe every 64" },
+		{ 4096, 0, "stream, 4K blocks" },
+	};
+	size_t total, i;
+	int ok = 1;
+
+	if (rs->n == 0) {
+		fprintf(stderr, "no records\n");
+		return 1;
+	}
+	printf("%lu records\n", (unsigned long)rs->n);
+	printf("  %-32s %10lu bytes  %6.2f bytes/record\n", "epoch + 2 floats",
+	       (unsigned long)rs->n * 12, 12.0);
+	printf("  %-32s %10lu bytes  %6.2f bytes/record\n", "sample frame payload",
+	       (unsigned long)rs->n * 10, 10.0);
+	for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+		if (!roundTrip(rs, configs[i].size, configs[i].keyInterval, &total)) {
+			printf("  %-32s ROUND TRIP FAILED\n", configs[i].use);
+			ok = 0;
+			continue;
+		}
+		printf("  %-32s %10lu bytes  %6.2f bytes/record  %5.1fx vs floats\n",
+		       configs[i].use, (unsigned long)total, (double)total / rs->n,
+		       12.0 * rs->n / total);
+	}
+	return ok ? 0 : 1;
+}
+
+static int selfTest(void)
+{
+	static const uint16_t sizes[] = { 11, 12, 26, 64, 255, 4096 };
+	struct records rs;
+	struct sample_record r;
+	struct sample_decoder d;
+	uint8_t junk[64];
+	size_t total, i;
+	int k, failed = 0;
+
+	memset(&rs, 0, sizeof(rs));
+	generate(&rs, 20000);
+	/* extremes and long runs */
+	r = rs.r[rs.n - 1];
+	for (k = 0; k < 200; k++) {
+		r.epoch++;
+		addRecord(&rs, &r);
+	}
+	r.temp = 32767; r.ph = -32768; r.errors = 65535; r.epoch = 0xFFFFFFFF;
+	addRecord(&rs, &r);
+	r.temp = -32768; r.ph = 32767; r.errors = 0; r.epoch = 0;
+	addRecord(&rs, &r);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		for (k = 0; k < 2; k++) {
+			if (!roundTrip(&rs, sizes[i], k ? 16 : 0, &total)) {
+				fprintf(stderr, "round trip failed, block %u\n", sizes[i]);
+				failed = 1;
+			}
+		}
+	}
+
+	/* garbage must end in an error or the end, never run away */
+	srand(2);
+	for (k = 0; k < 10000; k++) {
+		for (i = 0; i < sizeof(junk); i++)
+			junk[i] = rand();
+		junk[0] = SAMPLE_CODEC_KEY;
+		sampleDecoderBegin(&d, junk, sizeof(junk));
+		for (i = 0; i < 64 * sizeof(junk) && sampleDecode(&d, &r) == 1; i++)
+			;
+		if (i == 64 * sizeof(junk)) {
+			fprintf(stderr, "decoder ran away on junk\n");
+			failed = 1;
+			break;
+		}
+	}
+
+	free(rs.r);
+	fprintf(stderr, failed ? "self test FAILED\n" : "self test passed\n");
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	struct records rs;
+	FILE *in = stdin;
+	unsigned long n, i;
+
+	memset(&rs, 0, sizeof(rs));
+	if (argc < 2 || argv[1][0] != '-') {
+		fprintf(stderr, "usage: %s -e|-d|-b [file] | -g count | -t\n", argv[0]);
+		return 2;
+	}
+	if (argv[1][1] == 't')
+		return selfTest();
+	if (argv[1][1] == 'g') {
+		n = argc > 2 ? strtoul(argv[2], NULL, 10) : 86400;
+		generate(&rs, n);
+		printf("sequence,time,temp,ph,errors\n");
+		for (i = 0; i < rs.n; i++)
+			printCsv(i, &rs.r[i]);
+		return 0;
+	}
+	if (argc > 2 && (in = fopen(argv[2], "rb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	switch (argv[1][1]) {
+	case 'e':
+		readCsv(in, &rs);
+		encodeAll(&rs, 64, 0, writeBlock, stdout);
+		return 0;
+	case 'd':
+		return decodeFile(in);
+	case 'b':
+		readCsv(in, &rs);
+		return benchmark(&rs);
+	}
+	fprintf(stderr, "unknown option %s\n", argv[1]);
+	return 2;
+}
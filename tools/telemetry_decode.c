@@ -0,0 +1,321 @@
+/*
+ * telemetry_decode.c
+ *
+ * Host side decoder for the AqMonitor binary telemetry frames.  Reads the
+ * serial stream from a file or stdin, skips anything that is not a valid
+ * frame (console text, line noise) and prints one CSV line per sample,
+ * unpacking compressed block frames.
+ *
+ *   cc -O2 -o telemetry_decode tools/telemetry_decode.c
+ *   stty -F /dev/ttyUSB0 115200 raw -echo
+ *   ./telemetry_decode /dev/ttyUSB0
+ *
+ * "telemetry_decode -t" runs a self test against generated frames.
+ *
+ * Copyright (c) 2026 the AqMonitor contributors.
+ *
+ * This work is licensed under the Creative Commons
+ * Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+ * To view a copy of this license, visit
+ * http://creativecommons.org/licenses/by-nc-sa/3.0/
+ * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain View,
+ * California, 94041, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../AqMonitorApp/TelemetryFrame.h"
+#include "../AqMonitorApp/SampleCodec.h"
+
+/* 2000-01-01 00:00:00 UTC as a Unix time */
+#define EPOCH_2000 946684800L
+
+#define FRAME_SIZE (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE)
+
+struct decoder {
+	uint8_t frame[FRAME_SIZE];
+	unsigned n;
+	unsigned long frames;
+	unsigned long crcErrors;
+	unsigned long skipped;
+	unsigned long lost;
+	int lastSequence;
+};
+
+struct sample {
+	uint8_t sequence;
+	uint32_t epoch;
+	int16_t temp;
+	int16_t ph;
+	uint16_t errors;
+};
+
+typedef void (*sample_handler)(const struct sample *, void *);
+
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static void decoderInit(struct decoder *d)
+{
+	memset(d, 0, sizeof(*d));
+	d->lastSequence = -1;
+}
+
+/* Drops the first byte of the buffered frame and rescans the rest. */
+static void decoderResync(struct decoder *d, sample_handler handler, void *arg);
+
+static int frameComplete(const struct decoder *d)
+{
+	return d->n >= TELEMETRY_HEADER_SIZE &&
+	       d->n == (unsigned)(TELEMETRY_HEADER_SIZE + d->frame[2] + TELEMETRY_CRC_SIZE);
+}
+
+static void decoderFrame(struct decoder *d, sample_handler handler, void *arg)
+{
+	const uint8_t *payload = d->frame + TELEMETRY_HEADER_SIZE;
+	uint8_t length = d->frame[2];
+	uint16_t crc = TELEMETRY_CRC_START;
+	struct sample s;
+	struct sample_decoder block;
+	struct sample_record r;
+	unsigned i;
+
+	for (i = 1; i < (unsigned)(TELEMETRY_HEADER_SIZE + length); i++)
+		crc = telemetryCrcUpdate(crc, d->frame[i]);
+	if (crc != get16(payload + length)) {
+		d->crcErrors++;
+		decoderResync(d, handler, arg);
+		return;
+	}
+
+	d->frames++;
+	if (d->lastSequence >= 0)
+		d->lost += (uint8_t)(d->frame[3] - d->lastSequence - 1);
+	d->lastSequence = d->frame[3];
+	d->n = 0;
+
+	if (d->frame[1] == TELEMETRY_TYPE_SAMPLE && length >= TELEMETRY_SAMPLE_SIZE) {
+		s.sequence = d->frame[3];
+		s.epoch = get32(payload);
+		s.temp = get16(payload + 4);
+		s.ph = get16(payload + 6);
+		s.errors = get16(payload + 8);
+		handler(&s, arg);
+	}
+
+	if (d->frame[1] == TELEMETRY_TYPE_BLOCK) {
+		s.sequence = d->frame[3];
+		sampleDecoderBegin(&block, payload, length);
+		while (sampleDecode(&block, &r) == 1) {
+			s.epoch = r.epoch;
+			s.temp = r.temp;
+			s.ph = r.ph;
+			s.errors = r.errors;
+			handler(&s, arg);
+		}
+	}
+}
+
+static void decoderByte(struct decoder *d, uint8_t c, sample_handler handler, void *arg)
+{
+	if (d->n == 0 && c != TELEMETRY_SYNC) {
+		d->skipped++;
+		return;
+	}
+	d->frame[d->n++] = c;
+	if (d->n == 3 && d->frame[2] > TELEMETRY_MAX_PAYLOAD) {
+		decoderResync(d, handler, arg);
+		return;
+	}
+	if (frameComplete(d))
+		decoderFrame(d, handler, arg);
+}
+
+static void decoderResync(struct decoder *d, sample_handler handler, void *arg)
+{
+	uint8_t rest[FRAME_SIZE];
+	unsigned n = d->n - 1;
+	unsigned i;
+
+	memcpy(rest, d->frame + 1, n);
+	d->n = 0;
+	d->skipped++;
+	for (i = 0; i < n; i++)
+		decoderByte(d, rest[i], handler, arg);
+}
+
+/* Hundredths as a decimal; the sign goes separately so that -0.07 keeps
+ * it. */
+static void formatHundredths(char *out, size_t size, int16_t v)
+{
+	snprintf(out, size, "%s%d.%02d", v < 0 ? "-" : "", abs(v / 100), abs(v % 100));
+}
+
+static void printSample(const struct sample *s, void *arg)
+{
+	time_t t = (time_t)s->epoch + EPOCH_2000;
+	char when[32], temp[8], ph[8];
+
+	(void)arg;
+	strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+	formatHundredths(temp, sizeof(temp), s->temp);
+	formatHundredths(ph, sizeof(ph), s->ph);
+	printf("%u,%s,%s,%s,%u\n", s->sequence, when, temp, ph, s->errors);
+	fflush(stdout);
+}
+
+static void printStats(const struct decoder *d)
+{
+	fprintf(stderr, "frames %lu, crc errors %lu, bytes skipped %lu, sequence gaps %lu\n",
+	        d->frames, d->crcErrors, d->skipped, d->lost);
+}
+
+/* Self test: frames wrapped in console text, one corrupted frame, then
+ * a compressed block. */
+
+static size_t encodeFrame(uint8_t *out, uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length)
+{
+	uint16_t crc = TELEMETRY_CRC_START;
+	size_t n = 0, i;
+
+	out[n++] = TELEMETRY_SYNC;
+	out[n++] = type;
+	out[n++] = length;
+	out[n++] = sequence;
+	memcpy(out + n, payload, length);
+	n += length;
+	for (i = 1; i < n; i++)
+		crc = telemetryCrcUpdate(crc, out[i]);
+	out[n++] = crc;
+	out[n++] = crc >> 8;
+	return n;
+}
+
+static size_t encodeSample(uint8_t *out, uint8_t sequence, const struct sample *s)
+{
+	uint8_t payload[TELEMETRY_SAMPLE_SIZE];
+
+	payload[0] = s->epoch; payload[1] = s->epoch >> 8;
+	payload[2] = s->epoch >> 16; payload[3] = s->epoch >> 24;
+	payload[4] = s->temp; payload[5] = (uint16_t)s->temp >> 8;
+	payload[6] = s->ph; payload[7] = (uint16_t)s->ph >> 8;
+	payload[8] = s->errors; payload[9] = s->errors >> 8;
+	return encodeFrame(out, TELEMETRY_TYPE_SAMPLE, sequence, payload, sizeof(payload));
+}
+
+struct expect {
+	struct sample want[32];
+	int count;
+	int bad;
+};
+
+/* The values are also checked as printed, against printf's own idea of
+ * the decimal. */
+static int printedWrong(int16_t v)
+{
+	char got[8], want[16];
+
+	formatHundredths(got, sizeof(got), v);
+	snprintf(want, sizeof(want), "%.2f", v / 100.0);
+	return strcmp(got, want) != 0;
+}
+
+static void checkSample(const struct sample *s, void *arg)
+{
+	struct expect *e = arg;
+	const struct sample *w = &e->want[e->count++];
+
+	if (s->epoch != w->epoch || s->temp != w->temp || s->ph != w->ph || s->errors != w->errors ||
+	    printedWrong(s->temp) || printedWrong(s->ph))
+		e->bad++;
+}
+
+static int selfTest(void)
+{
+	static const char noise[] = "** Error in Sample 3, Error 1: bad reading\r\n\xa5\x01";
+	struct decoder d;
+	struct expect e;
+	struct sample s;
+	struct sample_encoder encoder;
+	struct sample_record r;
+	uint8_t block[TELEMETRY_MAX_PAYLOAD];
+	uint8_t stream[1024];
+	size_t n = 0, i;
+	int k, delivered = 0;
+
+	decoderInit(&d);
+	memset(&e, 0, sizeof(e));
+
+	for (k = 0; k < 8; k++) {
+		s.epoch = 844819200UL + k;
+		s.temp = k < 4 ? -k * 33 : 7850 + k;	/* -0.33 prints with its sign */
+		s.ph = -k * 7;
+		s.errors = k;
+		memcpy(stream + n, noise, sizeof(noise) - 1);
+		n += sizeof(noise) - 1;
+		i = n;
+		n += encodeSample(stream + n, k, &s);
+		if (k == 5) {
+			stream[i + 6] ^= 0x10;	/* corrupt; the decoder must drop it */
+		} else {
+			e.want[delivered++] = s;
+		}
+	}
+
+	/* then a compressed block of ten */
+	sampleEncoderBegin(&encoder, block, sizeof(block), 0);
+	for (k = 0; k < 10; k++) {
+		r.epoch = s.epoch = 844819300UL + k;
+		r.temp = s.temp = 7850 + k / 3;
+		r.ph = s.ph = 810;
+		r.errors = s.errors = 7;
+		sampleEncode(&encoder, &r);
+		e.want[delivered++] = s;
+	}
+	n += encodeFrame(stream + n, TELEMETRY_TYPE_BLOCK, 8, block, encoder.length);
+
+	for (i = 0; i < n; i++)
+		decoderByte(&d, stream[i], checkSample, &e);
+
+	printStats(&d);
+	if (e.count != delivered || e.bad || d.crcErrors != 1 || d.lost != 1) {
+		fprintf(stderr, "self test FAILED: %d of %d samples, %d wrong\n",
+		        e.count, delivered, e.bad);
+		return 1;
+	}
+	fprintf(stderr, "self test passed\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct decoder d;
+	FILE *in = stdin;
+	int c;
+
+	if (argc > 1 && strcmp(argv[1], "-t") == 0)
+		return selfTest();
+
+	if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	decoderInit(&d);
+	printf("sequence,time,temp,ph,errors\n");
+	while ((c = getc(in)) != EOF)
+		decoderByte(&d, c, printSample, NULL);
+
+	printStats(&d);
+	return 0;
+}